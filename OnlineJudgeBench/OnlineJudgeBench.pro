@@ -0,0 +1,9 @@
+# 基准测试工具，与服务器分开构建
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    loadgen \
+    datagen \
+    storagebench \
+    parserbench \
+    fuzz
@@ -0,0 +1,227 @@
+#include "syntheticdataset.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+namespace {
+
+// 答案文本的词表：让答案像代码，分词与指纹的开销接近真实提交
+const char *const kWords[] = {
+    "int", "return", "for", "while", "if", "else", "i", "j", "n", "sum", "ans", "vector<int>",
+    "cin", ">>", "cout", "<<", "=", "+=", "==", "<", "(", ")", "{", "}", ";", "0", "1", "std::sort",
+    "const", "auto", "&", "result", "count", "++", "size()", "push_back", "break", "long long"
+};
+const int kWordCount = int(sizeof(kWords) / sizeof(kWords[0]));
+
+const int kFlushBytes = 1 << 20;
+
+// 生成的文本不含其他控制字符，只需转义引号、反斜杠与换行
+void appendString(QByteArray &out, const QString &text)
+{
+    out.append('"');
+    for (QChar ch : text) {
+        switch (ch.unicode()) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            default:
+                if (ch.unicode() < 0x80) {
+                    out.append(char(ch.unicode()));
+                } else {
+                    out.append(QString(ch).toUtf8());
+                }
+        }
+    }
+    out.append('"');
+}
+
+// 缓冲写入，攒够 kFlushBytes 写一次
+class JsonFileWriter
+{
+public:
+    explicit JsonFileWriter(const QString &path) : file(path) {}
+
+    bool open(QString *error)
+    {
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            *error = QString("无法写入 %1：%2").arg(file.fileName()).arg(file.errorString());
+            return false;
+        }
+        buffer.reserve(kFlushBytes * 2);
+        return true;
+    }
+
+    QByteArray &out() { return buffer; }
+
+    bool flushIfFull(QString *error)
+    {
+        return buffer.size() < kFlushBytes || flush(error);
+    }
+
+    bool flush(QString *error)
+    {
+        if (file.write(buffer) != buffer.size()) {
+            *error = QString("写入 %1 失败：%2").arg(file.fileName()).arg(file.errorString());
+            return false;
+        }
+        buffer.resize(0);
+        return true;
+    }
+
+private:
+    QFile file;
+    QByteArray buffer;
+};
+
+} // namespace
+
+QString SyntheticDataset::username(int userId)
+{
+    return QString("user%1").arg(userId);
+}
+
+QString SyntheticDataset::password()
+{
+    return "123456";
+}
+
+int SyntheticDataset::firstStudentId(const DatasetSpec &spec)
+{
+    return qMin(spec.users, spec.teachers + 2);
+}
+
+int SyntheticDataset::submissionsPerHomework(const DatasetSpec &spec)
+{
+    if (spec.homeworks <= 0) {
+        return 0;
+    }
+    return int((spec.submissions + spec.homeworks - 1) / spec.homeworks);
+}
+
+int SyntheticDataset::studentForSubmission(const DatasetSpec &spec, int homeworkId, int submissionId)
+{
+    // 同一作业内的学生互不相同（提交数不超过学生数时）
+    int first = firstStudentId(spec);
+    int students = qMax(1, spec.users - first + 1);
+    return first + int((qint64(homeworkId) * 7919 + submissionId - 1) % students);
+}
+
+QString SyntheticDataset::answerText(std::mt19937 &rng, int averageBytes)
+{
+    std::uniform_int_distribution<int> length(qMax(1, averageBytes / 4), qMax(2, averageBytes * 2));
+    std::uniform_int_distribution<int> word(0, kWordCount - 1);
+    std::uniform_int_distribution<int> lineBreak(0, 11);
+    int target = length(rng);
+
+    QString text;
+    text.reserve(target + 16);
+    while (text.size() < target) {
+        text.append(QLatin1String(kWords[word(rng)]));
+        text.append(lineBreak(rng) == 0 ? '\n' : ' ');
+    }
+    text.truncate(target);
+    return text;
+}
+
+bool SyntheticDataset::generate(const DatasetSpec &spec, const QString &dir, QString *error)
+{
+    if (!QDir().mkpath(dir)) {
+        *error = QString("无法创建目录 %1").arg(dir);
+        return false;
+    }
+    return writeUsers(spec, QDir(dir).filePath("users.json"), error)
+        && writeHomeworks(spec, QDir(dir).filePath("homeworks.json"), error);
+}
+
+bool SyntheticDataset::writeUsers(const DatasetSpec &spec, const QString &path, QString *error)
+{
+    JsonFileWriter writer(path);
+    if (!writer.open(error)) {
+        return false;
+    }
+    QString createdAt = QDateTime::currentDateTime().toString(Qt::ISODate);
+    int firstStudent = firstStudentId(spec);
+
+    QByteArray &out = writer.out();
+    out.append("{\"users\":[");
+    for (int id = 1; id <= spec.users; ++id) {
+        const char *role = id == 1 ? "admin" : (id < firstStudent ? "teacher" : "student");
+        if (id > 1) {
+            out.append(',');
+        }
+        out.append("{\"id\":" + QByteArray::number(id) + ",\"username\":");
+        appendString(out, username(id));
+        out.append(",\"password\":");
+        appendString(out, password());
+        out.append(",\"role\":\"" + QByteArray(role) + "\",\"status\":\"active\",\"created_at\":");
+        appendString(out, createdAt);
+        out.append('}');
+        if (!writer.flushIfFull(error)) {
+            return false;
+        }
+    }
+    out.append("]}\n");
+    return writer.flush(error);
+}
+
+bool SyntheticDataset::writeHomeworks(const DatasetSpec &spec, const QString &path, QString *error)
+{
+    JsonFileWriter writer(path);
+    if (!writer.open(error)) {
+        return false;
+    }
+    std::mt19937 rng(spec.seed);
+    std::uniform_int_distribution<int> score(40, 100);
+    QDateTime now = QDateTime::currentDateTime();
+    QString createdAt = now.addDays(-7).toString(Qt::ISODate);
+    QString deadline = now.addDays(30).toString(Qt::ISODate);
+    int perHomework = submissionsPerHomework(spec);
+    int teachers = qMax(1, firstStudentId(spec) - 2);
+    qint64 remaining = spec.submissions;
+
+    QByteArray &out = writer.out();
+    out.append("{\"homeworks\":[");
+    for (int id = 1; id <= spec.homeworks; ++id) {
+        int teacherId = 2 + (id - 1) % teachers;
+        if (id > 1) {
+            out.append(',');
+        }
+        out.append("{\"id\":" + QByteArray::number(id) + ",\"title\":");
+        appendString(out, QString("第 %1 次作业").arg(id));
+        out.append(",\"description\":");
+        appendString(out, answerText(rng, 256));
+        out.append(",\"deadline\":");
+        appendString(out, deadline);
+        out.append(",\"courseId\":" + QByteArray::number(1 + (id - 1) % qMax(1, spec.courses)));
+        out.append(",\"teacherId\":" + QByteArray::number(teacherId) + ",\"teacherName\":");
+        appendString(out, username(teacherId));
+        out.append(",\"createdAt\":");
+        appendString(out, createdAt);
+        out.append(",\"submissions\":[");
+
+        int count = int(qMin<qint64>(perHomework, remaining));
+        remaining -= count;
+        for (int submissionId = 1; submissionId <= count; ++submissionId) {
+            int studentId = studentForSubmission(spec, id, submissionId);
+            bool graded = submissionId % 3 == 0;
+            if (submissionId > 1) {
+                out.append(',');
+            }
+            out.append("{\"id\":" + QByteArray::number(submissionId)
+                       + ",\"studentId\":" + QByteArray::number(studentId) + ",\"studentName\":");
+            appendString(out, username(studentId));
+            out.append(",\"answer\":");
+            appendString(out, answerText(rng, spec.answerBytes));
+            out.append(",\"submitTime\":");
+            appendString(out, createdAt);
+            out.append(",\"status\":\"已提交\",\"score\":"
+                       + (graded ? QByteArray::number(score(rng)) : QByteArray("null")) + "}");
+            if (!writer.flushIfFull(error)) {
+                return false;
+            }
+        }
+        out.append("]}");
+    }
+    out.append("]}\n");
+    return writer.flush(error);
+}
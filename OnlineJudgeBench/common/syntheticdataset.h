@@ -0,0 +1,43 @@
+#ifndef SYNTHETICDATASET_H
+#define SYNTHETICDATASET_H
+
+#include <QString>
+#include <QByteArray>
+#include <random>
+
+// 合成数据集的规模
+struct DatasetSpec
+{
+    int users = 1000;             // 第 1 个用户为管理员，随后 teachers 个教师，其余为学生
+    int teachers = 20;
+    int courses = 10;
+    int homeworks = 100;
+    qint64 submissions = 10000;   // 总提交数，平均分到各作业
+    int answerBytes = 1024;       // 答案平均长度，实际长度在其 1/4 到 2 倍之间
+    quint32 seed = 20240601;
+};
+
+// 生成与服务器读写格式一致的 users.json 与 homeworks.json，供基准测试使用
+// 边生成边写文件，百万级提交也不需要在内存中构造整个 JSON 文档
+// 相同的 spec 总是生成相同的数据
+class SyntheticDataset
+{
+public:
+    static bool generate(const DatasetSpec &spec, const QString &dir, QString *error);
+
+    // 以下约定供负载生成器挑选确实存在的用户、作业与提交
+    static QString username(int userId);
+    static QString password();
+    static int firstStudentId(const DatasetSpec &spec);
+    static int submissionsPerHomework(const DatasetSpec &spec);
+    static int studentForSubmission(const DatasetSpec &spec, int homeworkId, int submissionId);
+
+    // 类似代码的答案文本，长度在 averageBytes 的 1/4 到 2 倍之间
+    static QString answerText(std::mt19937 &rng, int averageBytes);
+
+private:
+    static bool writeUsers(const DatasetSpec &spec, const QString &path, QString *error);
+    static bool writeHomeworks(const DatasetSpec &spec, const QString &path, QString *error);
+};
+
+#endif // SYNTHETICDATASET_H
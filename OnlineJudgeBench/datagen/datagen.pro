@@ -0,0 +1,21 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = oj-datagen
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+
+# 各基准测试共用的合成数据集
+COMMON_DIR = ../common
+INCLUDEPATH += $$COMMON_DIR
+
+SOURCES += \
+    main.cpp \
+    $$COMMON_DIR/syntheticdataset.cpp
+
+HEADERS += \
+    $$COMMON_DIR/syntheticdataset.h
@@ -0,0 +1,33 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = oj-parser-fuzzer
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+
+SERVER_DIR = ../../OnlineJudgeServer
+INCLUDEPATH += $$SERVER_DIR
+
+SOURCES += \
+    parserfuzzer.cpp \
+    $$SERVER_DIR/httprequestparser.cpp
+
+HEADERS += \
+    $$SERVER_DIR/httprequestparser.h
+
+# 默认编译为普通程序，回放命令行给出的语料文件或目录（任何编译器都可用）：
+#     ./oj-parser-fuzzer corpus/
+# 用 clang 链接 libFuzzer 进行覆盖率引导的模糊测试：
+#     qmake CONFIG+=libfuzzer QMAKE_CXX=clang++ QMAKE_LINK=clang++ && make
+#     ./oj-parser-fuzzer findings/ corpus/ -max_len=4096
+# 发现的 crash-* 用例可用普通构建回放，修复后放进 corpus/ 作为回归用例
+libfuzzer {
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined -g
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+} else {
+    SOURCES += standalonemain.cpp
+}
@@ -0,0 +1,100 @@
+#include <QByteArray>
+#include <QList>
+#include <cstdio>
+#include <cstdlib>
+#include "httprequestparser.h"
+
+namespace {
+
+// 解析结果：取出的请求，以及最后停在 NeedMore 还是 Invalid
+struct ParseOutcome
+{
+    QList<HttpRequest> requests;
+    bool invalid = false;
+    int buffered = 0;
+};
+
+void fail(const char *what)
+{
+    fprintf(stderr, "解析器不一致：%s\n", what);
+    abort();
+}
+
+// 按给定的分段方式把数据交给解析器，每段之后取出所有完整的请求
+ParseOutcome parse(const QByteArray &data, const QList<int> &pieceSizes)
+{
+    ParseOutcome outcome;
+    HttpRequestParser parser;
+    int offset = 0;
+    int piece = 0;
+    while (offset < data.size() && !outcome.invalid) {
+        int size = qMin(pieceSizes[piece++ % pieceSizes.size()], data.size() - offset);
+        parser.append(data.mid(offset, size));
+        offset += size;
+
+        HttpRequest request;
+        QString error;
+        HttpRequestParser::Status status;
+        while ((status = parser.next(&request, &error)) == HttpRequestParser::Complete) {
+            if (request.body.size() != request.contentLength || request.wireBytes <= request.contentLength
+                || request.method.isEmpty() || request.path.isEmpty()) {
+                fail("取出的请求字段不正确");
+            }
+            outcome.requests.append(request);
+        }
+        if (status == HttpRequestParser::Invalid) {
+            if (error.isEmpty()) {
+                fail("Invalid 时没有错误信息");
+            }
+            outcome.invalid = true;
+        }
+        if (parser.buffered() < 0 || parser.buffered() > offset) {
+            fail("缓冲字节数超出已收到的数据");
+        }
+    }
+    outcome.buffered = outcome.invalid ? -1 : (data.isEmpty() ? 0 : parser.buffered());
+    return outcome;
+}
+
+bool sameRequests(const ParseOutcome &a, const ParseOutcome &b)
+{
+    if (a.requests.size() != b.requests.size() || a.invalid != b.invalid || a.buffered != b.buffered) {
+        return false;
+    }
+    for (int i = 0; i < a.requests.size(); ++i) {
+        const HttpRequest &x = a.requests[i];
+        const HttpRequest &y = b.requests[i];
+        if (x.method != y.method || x.path != y.path || x.body != y.body || x.authorization != y.authorization
+            || x.wireBytes != y.wireBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// 同一段数据一次到达、逐字节到达、按不规则长度分段到达时，解析出的请求必须完全相同，
+// 且所有请求的字节数之和加上剩余缓冲正好等于输入长度
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    QByteArray input(reinterpret_cast<const char*>(data), int(size));
+
+    ParseOutcome whole = parse(input, {qMax(1, input.size())});
+    ParseOutcome bytewise = parse(input, {1});
+    ParseOutcome irregular = parse(input, {3, 1, 7, 2, 64, 5});
+    if (!sameRequests(whole, bytewise) || !sameRequests(whole, irregular)) {
+        fail("分段方式改变了解析结果");
+    }
+
+    if (!whole.invalid) {
+        qint64 consumed = 0;
+        for (const HttpRequest &request : whole.requests) {
+            consumed += request.wireBytes;
+        }
+        if (consumed + whole.buffered != input.size()) {
+            fail("请求字节数与输入长度不符");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <cstdio>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// 不链接 libFuzzer 时的入口：依次运行参数中的文件，参数为目录时运行其中所有文件
+// 用于在本地回放种子语料与模糊测试发现的崩溃用例
+int main(int argc, char *argv[])
+{
+    QStringList files;
+    for (int i = 1; i < argc; ++i) {
+        QString path = QString::fromLocal8Bit(argv[i]);
+        if (QFileInfo(path).isDir()) {
+            for (const QFileInfo &info : QDir(path).entryInfoList(QDir::Files, QDir::Name)) {
+                files.append(info.filePath());
+            }
+        } else {
+            files.append(path);
+        }
+    }
+    if (files.isEmpty()) {
+        fprintf(stderr, "用法：%s <语料文件或目录>...\n", argv[0]);
+        return 1;
+    }
+
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "无法读取 %s\n", qPrintable(path));
+            return 1;
+        }
+        QByteArray data = file.readAll();
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.constData()), size_t(data.size()));
+    }
+    printf("已运行 %d 个用例\n", files.size());
+    return 0;
+}
@@ -0,0 +1,25 @@
+QT -= gui
+QT += network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = oj-loadgen
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtNetwork
+
+# 各基准测试共用的合成数据集
+COMMON_DIR = ../common
+INCLUDEPATH += $$COMMON_DIR
+
+SOURCES += \
+    main.cpp \
+    loadgenerator.cpp \
+    $$COMMON_DIR/syntheticdataset.cpp
+
+HEADERS += \
+    loadgenerator.h \
+    $$COMMON_DIR/syntheticdataset.h
@@ -0,0 +1,359 @@
+#include "loadgenerator.h"
+#include <QThread>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace {
+
+const char *const kOperationNames[] = {"login", "homeworks", "submit", "grade"};
+const char *const kOperationPaths[] = {"/api/login", "/api/homeworks", "/api/submit", "/api/grade"};
+
+// 每个虚拟用户预先生成的答案数，避免在计时循环中生成文本
+const int kAnswerPool = 32;
+
+qint64 percentileOf(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    int index = qBound(0, int(std::ceil(p * sorted.size())) - 1, sorted.size() - 1);
+    return sorted[index];
+}
+
+double toMs(qint64 us)
+{
+    return qRound64(us / 10.0) / 100.0;
+}
+
+// 一个虚拟用户：一条长连接，按配置的比例发送请求
+class VirtualUser : public QThread
+{
+public:
+    VirtualUser(const LoadConfig &config, int index, const QElapsedTimer &clock,
+                qint64 startNs, qint64 warmupEndNs, qint64 endNs)
+        : config(config)
+        , index(index)
+        , clock(clock)
+        , startNs(startNs)
+        , warmupEndNs(warmupEndNs)
+        , endNs(endNs)
+        , rng(config.dataset.seed + quint32(index) * 7919u)
+    {
+    }
+
+    OperationSamples samples[OperationCount];
+
+protected:
+    void run() override
+    {
+        for (int i = 0; i < kAnswerPool; ++i) {
+            answers.append(SyntheticDataset::answerText(rng, config.dataset.answerBytes));
+        }
+
+        // 每个虚拟用户固定扮演一名学生（提交、查看作业）和一名教师（评分），先登录取得令牌
+        const DatasetSpec &dataset = config.dataset;
+        int firstStudent = SyntheticDataset::firstStudentId(dataset);
+        studentId = firstStudent + index % qMax(1, dataset.users - firstStudent + 1);
+        studentToken = login(studentId);
+        teacherToken = login(2 + index % qMax(1, firstStudent - 2));
+
+        // 开环：每个用户负责总速率的 1/N，起始时刻错开，避免所有用户同时发送
+        qint64 intervalNs = config.rate > 0
+            ? qint64(1e9 * config.virtualUsers / config.rate) : 0;
+        qint64 nextNs = startNs + (intervalNs > 0 ? intervalNs * index / config.virtualUsers : 0);
+
+        while (true) {
+            qint64 nowNs = clock.nsecsElapsed();
+            qint64 intendedNs = nowNs;
+            if (intervalNs > 0) {
+                if (nextNs > nowNs) {
+                    QThread::usleep(quint64((nextNs - nowNs) / 1000));
+                }
+                intendedNs = nextNs;
+                nextNs += intervalNs;
+            }
+            if (intendedNs >= endNs) {
+                break;
+            }
+
+            int op = pickOperation();
+            int status = exchange(buildRequest(op));
+            qint64 doneNs = clock.nsecsElapsed();
+            if (intendedNs < warmupEndNs) {
+                continue;
+            }
+            OperationSamples &target = samples[op];
+            if (status < 0) {
+                ++target.errors;
+            } else {
+                ++target.statuses[status];
+                target.latencyUs.append((doneNs - intendedNs) / 1000);
+            }
+        }
+        socket.reset();
+    }
+
+private:
+    int pickOperation()
+    {
+        int total = 0;
+        for (int weight : config.weights) {
+            total += weight;
+        }
+        int roll = std::uniform_int_distribution<int>(0, total - 1)(rng);
+        for (int op = 0; op < OperationCount; ++op) {
+            roll -= config.weights[op];
+            if (roll < 0) {
+                return op;
+            }
+        }
+        return OpLogin;
+    }
+
+    int randomInt(int low, int high)
+    {
+        return std::uniform_int_distribution<int>(low, qMax(low, high))(rng);
+    }
+
+    QByteArray login(int userId)
+    {
+        QJsonObject body{
+            {"username", SyntheticDataset::username(userId)},
+            {"password", SyntheticDataset::password()}
+        };
+        QByteArray response;
+        if (exchange(httpRequest(OpLogin, body, QByteArray()), &response) != 200) {
+            return QByteArray();
+        }
+        return QJsonDocument::fromJson(response).object()["token"].toString().toLatin1();
+    }
+
+    QByteArray buildRequest(int op)
+    {
+        const DatasetSpec &dataset = config.dataset;
+        QJsonObject body;
+        QByteArray token = studentToken;
+        switch (op) {
+            case OpLogin: {
+                int userId = randomInt(1, dataset.users);
+                body["username"] = SyntheticDataset::username(userId);
+                body["password"] = SyntheticDataset::password();
+                break;
+            }
+            case OpHomeworks:
+                body["courseId"] = randomInt(1, dataset.courses);
+                break;
+            case OpSubmit: {
+                int homeworkId = randomInt(1, dataset.homeworks);
+                body["homeworkId"] = homeworkId;
+                body["studentId"] = studentId;
+                body["studentName"] = SyntheticDataset::username(studentId);
+                body["answer"] = answers[randomInt(0, answers.size() - 1)];
+                break;
+            }
+            case OpGrade:
+                body["submissionId"] = randomInt(1, SyntheticDataset::submissionsPerHomework(dataset));
+                body["score"] = randomInt(0, 100);
+                token = teacherToken;
+                break;
+        }
+        return httpRequest(op, body, op == OpLogin ? QByteArray() : token);
+    }
+
+    // 与客户端 QNetworkAccessManager 发出的请求逐字节一致
+    QByteArray httpRequest(int op, const QJsonObject &body, const QByteArray &token)
+    {
+        QByteArray payload = QJsonDocument(body).toJson();
+        QByteArray authorization = token.isEmpty() ? QByteArray() : "Authorization: Bearer " + token + "\r\n";
+        return "POST " + QByteArray(kOperationPaths[op]) + " HTTP/1.1\r\n"
+               "Host: " + config.host.toUtf8() + ":" + QByteArray::number(config.port) + "\r\n"
+               "Content-Type: application/json\r\n"
+               "Content-Length: " + QByteArray::number(payload.size()) + "\r\n"
+               + authorization +
+               "Connection: Keep-Alive\r\n"
+               "Accept-Encoding: gzip, deflate\r\n"
+               "Accept-Language: zh-CN,en,*\r\n"
+               "User-Agent: Mozilla/5.0\r\n"
+               "\r\n" + payload;
+    }
+
+    // 发送一个请求并读完响应，返回状态码；出错时断开连接，下次重新连接
+    int exchange(const QByteArray &request, QByteArray *body = nullptr)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        if (!socket || socket->state() != QAbstractSocket::ConnectedState) {
+            socket.reset(new QTcpSocket);
+            socket->connectToHost(config.host, config.port);
+            if (!socket->waitForConnected(config.timeoutMs)) {
+                socket.reset();
+                return -1;
+            }
+        }
+        socket->write(request);
+
+        QByteArray response;
+        int headerEnd = -1;
+        qint64 contentLength = -1;
+        while (true) {
+            if (headerEnd < 0) {
+                headerEnd = response.indexOf("\r\n\r\n");
+                if (headerEnd >= 0) {
+                    for (const QByteArray &line : response.left(headerEnd).split('\n')) {
+                        if (line.toLower().startsWith("content-length:")) {
+                            contentLength = line.mid(15).trimmed().toLongLong();
+                        }
+                    }
+                }
+            }
+            if (headerEnd >= 0 && contentLength >= 0 && response.size() - headerEnd - 4 >= contentLength) {
+                break;
+            }
+            int remaining = config.timeoutMs - int(timer.elapsed());
+            if (remaining <= 0 || !socket->waitForReadyRead(remaining)) {
+                socket.reset();
+                return -1;
+            }
+            response.append(socket->readAll());
+        }
+
+        // 每次只有一个请求在途，响应读完后连接上不会有多余数据
+        if (body) {
+            *body = response.mid(headerEnd + 4);
+        }
+        return response.left(response.indexOf("\r\n")).split(' ').value(1).toInt();
+    }
+
+    const LoadConfig &config;
+    int index;
+    const QElapsedTimer &clock;
+    qint64 startNs;
+    qint64 warmupEndNs;
+    qint64 endNs;
+    std::mt19937 rng;
+    QStringList answers;
+    int studentId = 0;
+    QByteArray studentToken;
+    QByteArray teacherToken;
+    std::unique_ptr<QTcpSocket> socket;
+};
+
+} // namespace
+
+LoadGenerator::LoadGenerator(const LoadConfig &config)
+    : config(config)
+{
+}
+
+const char *LoadGenerator::operationName(int op)
+{
+    return kOperationNames[op];
+}
+
+bool LoadGenerator::parseMix(const QString &text, int weights[OperationCount], QString *error)
+{
+    int parsed[OperationCount] = {0, 0, 0, 0};
+    int total = 0;
+    for (const QString &item : text.split(',', QString::SkipEmptyParts)) {
+        QString name = item.section('=', 0, 0).trimmed();
+        bool ok = false;
+        int weight = item.section('=', 1, 1).trimmed().toInt(&ok);
+        int op = 0;
+        while (op < OperationCount && name != QLatin1String(kOperationNames[op])) {
+            ++op;
+        }
+        if (op == OperationCount || !ok || weight < 0) {
+            *error = QString("无效的请求比例：%1").arg(item);
+            return false;
+        }
+        parsed[op] = weight;
+        total += weight;
+    }
+    if (total <= 0) {
+        *error = "请求比例之和必须大于 0";
+        return false;
+    }
+    std::copy(parsed, parsed + OperationCount, weights);
+    return true;
+}
+
+QJsonObject LoadGenerator::summarize(OperationSamples &samples, double seconds)
+{
+    std::sort(samples.latencyUs.begin(), samples.latencyUs.end());
+    const QVector<qint64> &sorted = samples.latencyUs;
+    QJsonObject statuses;
+    for (auto it = samples.statuses.constBegin(); it != samples.statuses.constEnd(); ++it) {
+        statuses[QString::number(it.key())] = it.value();
+    }
+    return QJsonObject{
+        {"requests", sorted.size()},
+        {"errors", samples.errors},
+        {"throughput", seconds > 0 ? qRound64(sorted.size() / seconds * 10) / 10.0 : 0.0},
+        {"statuses", statuses},
+        {"latencyMs", QJsonObject{
+            {"p50", toMs(percentileOf(sorted, 0.50))},
+            {"p90", toMs(percentileOf(sorted, 0.90))},
+            {"p99", toMs(percentileOf(sorted, 0.99))},
+            {"p999", toMs(percentileOf(sorted, 0.999))},
+            {"max", toMs(sorted.isEmpty() ? 0 : sorted.last())}
+        }}
+    };
+}
+
+QJsonObject LoadGenerator::run()
+{
+    QElapsedTimer clock;
+    clock.start();
+    // 留出线程启动与生成答案的时间
+    qint64 startNs = clock.nsecsElapsed() + qint64(200) * 1000 * 1000;
+    qint64 warmupEndNs = startNs + qint64(config.warmupSec) * 1000 * 1000 * 1000;
+    qint64 endNs = warmupEndNs + qint64(config.durationSec) * 1000 * 1000 * 1000;
+
+    QVector<VirtualUser*> users;
+    for (int i = 0; i < config.virtualUsers; ++i) {
+        users.append(new VirtualUser(config, i, clock, startNs, warmupEndNs, endNs));
+        users.last()->start();
+    }
+
+    OperationSamples combined[OperationCount];
+    OperationSamples overall;
+    for (VirtualUser *user : users) {
+        user->wait();
+        for (int op = 0; op < OperationCount; ++op) {
+            OperationSamples &samples = user->samples[op];
+            combined[op].latencyUs += samples.latencyUs;
+            combined[op].errors += samples.errors;
+            overall.latencyUs += samples.latencyUs;
+            overall.errors += samples.errors;
+            for (auto it = samples.statuses.constBegin(); it != samples.statuses.constEnd(); ++it) {
+                combined[op].statuses[it.key()] += it.value();
+                overall.statuses[it.key()] += it.value();
+            }
+        }
+    }
+    qDeleteAll(users);
+
+    double seconds = config.durationSec;
+    QJsonObject operations;
+    for (int op = 0; op < OperationCount; ++op) {
+        if (config.weights[op] > 0) {
+            operations[kOperationNames[op]] = summarize(combined[op], seconds);
+        }
+    }
+    return QJsonObject{
+        {"config", QJsonObject{
+            {"virtualUsers", config.virtualUsers},
+            {"durationSec", config.durationSec},
+            {"warmupSec", config.warmupSec},
+            {"mode", config.rate > 0 ? "open" : "closed"},
+            {"rate", config.rate}
+        }},
+        {"overall", summarize(overall, seconds)},
+        {"operations", operations}
+    };
+}
@@ -0,0 +1,62 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QJsonObject>
+#include "syntheticdataset.h"
+
+// 负载中的请求类型
+enum Operation {
+    OpLogin,
+    OpHomeworks,
+    OpSubmit,
+    OpGrade,
+    OperationCount
+};
+
+struct LoadConfig
+{
+    QString host = "127.0.0.1";
+    quint16 port = 8080;
+    int virtualUsers = 32;
+    int durationSec = 30;
+    int warmupSec = 5;             // 预热期间的请求不计入结果
+    double rate = 0;               // 开环模式的总请求速率（次/秒），0 为闭环
+    int weights[OperationCount] = {40, 40, 15, 5};
+    DatasetSpec dataset;           // 服务器上的数据集，用于挑选确实存在的用户、作业与提交
+    int timeoutMs = 10000;
+};
+
+// 一类请求的原始结果
+struct OperationSamples
+{
+    QVector<qint64> latencyUs;
+    qint64 errors = 0;             // 网络错误与超时
+    QMap<int, qint64> statuses;    // HTTP 状态码 -> 次数
+};
+
+// 负载生成器：每个虚拟用户一个线程，各自保持一条长连接，
+// 按与客户端完全相同的请求格式（QNetworkAccessManager 的请求头、缩进的 JSON 请求体）发送请求
+// 闭环模式下收到响应立即发下一个；开环模式下按固定间隔发送，
+// 延迟从计划发送时刻算起，服务器变慢时排队时间计入延迟，不会被掩盖
+class LoadGenerator
+{
+public:
+    explicit LoadGenerator(const LoadConfig &config);
+
+    // 阻塞运行到结束，返回汇总结果
+    QJsonObject run();
+
+    static const char *operationName(int op);
+    // 解析 "login=40,homeworks=40,submit=15,grade=5"
+    static bool parseMix(const QString &text, int weights[OperationCount], QString *error);
+
+private:
+    static QJsonObject summarize(OperationSamples &samples, double seconds);
+
+    LoadConfig config;
+};
+
+#endif // LOADGENERATOR_H
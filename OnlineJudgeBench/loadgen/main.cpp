@@ -0,0 +1,166 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "loadgenerator.h"
+
+namespace {
+
+// 等待服务器开始监听
+bool waitForServer(const QString &host, quint16 port, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeoutMs) {
+        QTcpSocket probe;
+        probe.connectToHost(host, port);
+        if (probe.waitForConnected(500)) {
+            probe.disconnectFromHost();
+            return true;
+        }
+        QThread::msleep(200);
+    }
+    return false;
+}
+
+void printReport(const QJsonObject &report)
+{
+    QTextStream out(stdout);
+    QJsonObject config = report["config"].toObject();
+    out << QString("模式 %1，%2 个虚拟用户，测量 %3 秒（预热 %4 秒）\n")
+           .arg(config["mode"].toString())
+           .arg(config["virtualUsers"].toInt())
+           .arg(config["durationSec"].toInt())
+           .arg(config["warmupSec"].toInt());
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+           .arg("请求", -10).arg("次数", 9).arg("错误", 7).arg("次/秒", 9)
+           .arg("p50", 9).arg("p90", 9).arg("p99", 9).arg("p999", 9).arg("max(ms)", 9);
+
+    auto printRow = [&out](const QString &name, const QJsonObject &row) {
+        QJsonObject latency = row["latencyMs"].toObject();
+        qint64 failed = row["errors"].toVariant().toLongLong();
+        QJsonObject statuses = row["statuses"].toObject();
+        for (auto it = statuses.constBegin(); it != statuses.constEnd(); ++it) {
+            if (it.key() != "200") {
+                failed += it.value().toVariant().toLongLong();
+            }
+        }
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(name, -10)
+               .arg(row["requests"].toInt(), 9)
+               .arg(failed, 7)
+               .arg(row["throughput"].toDouble(), 9, 'f', 1)
+               .arg(latency["p50"].toDouble(), 9, 'f', 2)
+               .arg(latency["p90"].toDouble(), 9, 'f', 2)
+               .arg(latency["p99"].toDouble(), 9, 'f', 2)
+               .arg(latency["p999"].toDouble(), 9, 'f', 2)
+               .arg(latency["max"].toDouble(), 9, 'f', 2);
+    };
+
+    QJsonObject operations = report["operations"].toObject();
+    for (int op = 0; op < OperationCount; ++op) {
+        QString name = LoadGenerator::operationName(op);
+        if (operations.contains(name)) {
+            printRow(name, operations[name].toObject());
+        }
+    }
+    printRow("total", report["overall"].toObject());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在线评测服务器 HTTP 接口负载生成器");
+    parser.addHelpOption();
+    parser.addOption({"server", "服务器地址 host:port", "address", "127.0.0.1:8080"});
+    parser.addOption({"spawn", "在临时目录中生成数据集并启动此服务器程序，测完后关闭", "path"});
+    parser.addOption({"users", "虚拟用户数", "count", "32"});
+    parser.addOption({"duration", "测量时长（秒）", "seconds", "30"});
+    parser.addOption({"warmup", "预热时长（秒），不计入结果", "seconds", "5"});
+    parser.addOption({"rate", "开环模式的总请求速率（次/秒），不指定时为闭环", "rps", "0"});
+    parser.addOption({"mix", "各类请求的比例", "weights", "login=40,homeworks=40,submit=15,grade=5"});
+    parser.addOption({"dataset-users", "数据集用户数", "count", "1000"});
+    parser.addOption({"dataset-homeworks", "数据集作业数", "count", "100"});
+    parser.addOption({"dataset-submissions", "数据集总提交数", "count", "10000"});
+    parser.addOption({"answer-bytes", "答案平均长度（字节）", "bytes", "1024"});
+    parser.addOption({"json", "把结果以 JSON 写入文件", "file"});
+    parser.process(a);
+
+    LoadConfig config;
+    config.virtualUsers = qMax(1, parser.value("users").toInt());
+    config.durationSec = qMax(1, parser.value("duration").toInt());
+    config.warmupSec = qMax(0, parser.value("warmup").toInt());
+    config.rate = qMax(0.0, parser.value("rate").toDouble());
+    config.dataset.users = qMax(2, parser.value("dataset-users").toInt());
+    config.dataset.homeworks = qMax(1, parser.value("dataset-homeworks").toInt());
+    config.dataset.submissions = qMax<qint64>(0, parser.value("dataset-submissions").toLongLong());
+    config.dataset.answerBytes = qMax(1, parser.value("answer-bytes").toInt());
+
+    QTextStream err(stderr);
+    QString mixError;
+    if (!LoadGenerator::parseMix(parser.value("mix"), config.weights, &mixError)) {
+        err << mixError << "\n";
+        return 1;
+    }
+
+    QString address = parser.value("server");
+    config.host = address.section(':', 0, 0);
+    config.port = quint16(address.contains(':') ? address.section(':', 1, 1).toInt() : 8080);
+
+    // 启动独立的服务器进程：工作目录为临时目录，数据文件、缓存与日志都在其中
+    QTemporaryDir workDir;
+    QProcess server;
+    if (parser.isSet("spawn")) {
+        QString error;
+        err << "正在生成数据集...\n";
+        err.flush();
+        if (!workDir.isValid() || !SyntheticDataset::generate(config.dataset, workDir.path(), &error)) {
+            err << "生成数据集失败：" << error << "\n";
+            return 1;
+        }
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("OJ_PORT", QString::number(config.port));
+        server.setProcessEnvironment(env);
+        server.setWorkingDirectory(workDir.path());
+        server.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        server.setStandardOutputFile(QProcess::nullDevice());
+        server.start(parser.value("spawn"), QStringList());
+        if (!server.waitForStarted() || !waitForServer(config.host, config.port, 30000)) {
+            err << "服务器未能启动\n";
+            server.kill();
+            return 1;
+        }
+    }
+
+    QJsonObject report = LoadGenerator(config).run();
+
+    if (server.state() != QProcess::NotRunning) {
+        server.terminate();
+        if (!server.waitForFinished(5000)) {
+            server.kill();
+            server.waitForFinished();
+        }
+    }
+
+    printReport(report);
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "无法写入 " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(report).toJson());
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QVector>
+#include "httprequestparser.h"
+
+namespace {
+
+// 一个测试场景：每一轮把 pieces 依次交给一个新的解析器，应当恰好取出 requests 个请求
+struct ParserCase
+{
+    QString name;
+    QVector<QByteArray> pieces;
+    int requests;
+};
+
+// 与客户端 QNetworkAccessManager 发出的提交请求格式一致
+QByteArray submitRequest(int answerBytes)
+{
+    QByteArray answer;
+    answer.reserve(answerBytes);
+    const QByteArray line = "for (int i = 0; i < n; ++i) sum += a[i];\\n";
+    while (answer.size() < answerBytes) {
+        answer.append(line);
+    }
+    answer.truncate(answerBytes);
+    QByteArray body = "{\n    \"answer\": \"" + answer + "\",\n    \"homeworkId\": 17,\n"
+                      "    \"studentId\": 1024,\n    \"studentName\": \"user1024\"\n}\n";
+    return "POST /api/submit HTTP/1.1\r\n"
+           "Host: 127.0.0.1:8080\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+           "Connection: Keep-Alive\r\n"
+           "Accept-Encoding: gzip, deflate\r\n"
+           "Accept-Language: zh-CN,en,*\r\n"
+           "User-Agent: Mozilla/5.0\r\n"
+           "\r\n" + body;
+}
+
+QVector<QByteArray> split(const QByteArray &data, int pieceBytes)
+{
+    QVector<QByteArray> pieces;
+    for (int offset = 0; offset < data.size(); offset += pieceBytes) {
+        pieces.append(data.mid(offset, pieceBytes));
+    }
+    return pieces;
+}
+
+QVector<ParserCase> buildCases(int fragmentBytes, int pipelineDepth)
+{
+    QByteArray typical = submitRequest(1024);
+    QByteArray large = submitRequest(1 << 20);
+    QByteArray pipelined;
+    for (int i = 0; i < pipelineDepth; ++i) {
+        pipelined.append(typical);
+    }
+
+    QVector<ParserCase> cases;
+    cases.append({"typical", {typical}, 1});
+    cases.append({"large", {large}, 1});
+    cases.append({"fragmented", split(typical, fragmentBytes), 1});
+    // 大请求按以太网 MSS 分段到达，是上传测试数据时的常见情形
+    cases.append({"large.fragmented", split(large, 1460), 1});
+    cases.append({"pipelined", {pipelined}, pipelineDepth});
+    return cases;
+}
+
+QJsonObject runCase(const ParserCase &parserCase, double seconds, QString *error)
+{
+    qint64 wireBytes = 0;
+    for (const QByteArray &piece : parserCase.pieces) {
+        wireBytes += piece.size();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 rounds = 0;
+    qint64 limitNs = qint64(seconds * 1e9);
+    HttpRequest request;
+    QString parseError;
+    while (timer.nsecsElapsed() < limitNs) {
+        HttpRequestParser parser;
+        int parsed = 0;
+        for (const QByteArray &piece : parserCase.pieces) {
+            parser.append(piece);
+            HttpRequestParser::Status status;
+            while ((status = parser.next(&request, &parseError)) == HttpRequestParser::Complete) {
+                ++parsed;
+            }
+            if (status == HttpRequestParser::Invalid) {
+                *error = QString("%1：%2").arg(parserCase.name).arg(parseError);
+                return QJsonObject();
+            }
+        }
+        if (parsed != parserCase.requests) {
+            *error = QString("%1：取出 %2 个请求，应为 %3").arg(parserCase.name).arg(parsed).arg(parserCase.requests);
+            return QJsonObject();
+        }
+        ++rounds;
+    }
+
+    double elapsed = timer.nsecsElapsed() / 1e9;
+    return QJsonObject{
+        {"pieces", parserCase.pieces.size()},
+        {"requestBytes", wireBytes / parserCase.requests},
+        {"requests", rounds * parserCase.requests},
+        {"requestsPerSec", qRound64(rounds * parserCase.requests / elapsed)},
+        {"megabytesPerSec", qRound64(rounds * wireBytes / elapsed / 1048576.0 * 10) / 10.0}
+    };
+}
+
+} // namespace
+
+// HTTP 请求解析器的吞吐量：典型请求、大请求、分段到达与流水线
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("HTTP 请求解析器基准测试");
+    parser.addHelpOption();
+    parser.addOption({"seconds", "每个场景的运行时长（秒）", "seconds", "2"});
+    parser.addOption({"fragment", "fragmented 场景每段的字节数", "bytes", "64"});
+    parser.addOption({"pipeline", "pipelined 场景一次发送的请求数", "count", "32"});
+    parser.addOption({"json", "把结果以 JSON 写入文件", "file"});
+    parser.process(a);
+
+    double seconds = qMax(0.1, parser.value("seconds").toDouble());
+    QVector<ParserCase> cases = buildCases(qMax(1, parser.value("fragment").toInt()),
+                                           qMax(1, parser.value("pipeline").toInt()));
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg("场景", -18).arg("段数", 8).arg("请求字节", 10).arg("请求/秒", 12).arg("MB/秒", 10);
+    QJsonObject results;
+    for (const ParserCase &parserCase : cases) {
+        QString error;
+        QJsonObject row = runCase(parserCase, seconds, &error);
+        if (!error.isEmpty()) {
+            QTextStream(stderr) << "解析结果不正确：" << error << "\n";
+            return 1;
+        }
+        results[parserCase.name] = row;
+        out << QString("%1 %2 %3 %4 %5\n")
+               .arg(parserCase.name, -18)
+               .arg(row["pieces"].toInt(), 8)
+               .arg(row["requestBytes"].toVariant().toLongLong(), 10)
+               .arg(row["requestsPerSec"].toVariant().toLongLong(), 12)
+               .arg(row["megabytesPerSec"].toDouble(), 10, 'f', 1);
+        out.flush();
+    }
+
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly)) {
+            QTextStream(stderr) << "无法写入 " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(QJsonObject{{"secondsPerCase", seconds}, {"cases", results}}).toJson());
+    }
+    return 0;
+}
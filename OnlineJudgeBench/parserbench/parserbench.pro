@@ -0,0 +1,21 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = oj-parserbench
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+
+# 只依赖服务器的 HTTP 请求解析器
+SERVER_DIR = ../../OnlineJudgeServer
+INCLUDEPATH += $$SERVER_DIR
+
+SOURCES += \
+    main.cpp \
+    $$SERVER_DIR/httprequestparser.cpp
+
+HEADERS += \
+    $$SERVER_DIR/httprequestparser.h
@@ -0,0 +1,129 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "storagebenchmark.h"
+#include "syntheticdataset.h"
+#include "logger.h"
+
+namespace {
+
+void printReport(const QJsonObject &report)
+{
+    QTextStream out(stdout);
+    QJsonObject dataset = report["dataset"].toObject();
+    out << QString("数据集：%1 个用户（%2 MB），%3 个作业（%4 MB），每项 %5 次\n")
+           .arg(dataset["users"].toInt())
+           .arg(dataset["usersBytes"].toDouble() / 1048576.0, 0, 'f', 1)
+           .arg(dataset["homeworks"].toInt())
+           .arg(dataset["homeworksBytes"].toDouble() / 1048576.0, 0, 'f', 1)
+           .arg(report["iterations"].toInt());
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+           .arg("操作", -26).arg("mean", 10).arg("p50", 10).arg("p90", 10)
+           .arg("max(ms)", 10).arg("字节", 12).arg("状态", 5);
+
+    QJsonObject operations = report["operations"].toObject();
+    for (const QString &name : StorageBenchmark::operationNames()) {
+        if (!operations.contains(name)) {
+            continue;
+        }
+        QJsonObject row = operations[name].toObject();
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(name, -26)
+               .arg(row["meanMs"].toDouble(), 10, 'f', 3)
+               .arg(row["p50Ms"].toDouble(), 10, 'f', 3)
+               .arg(row["p90Ms"].toDouble(), 10, 'f', 3)
+               .arg(row["maxMs"].toDouble(), 10, 'f', 3)
+               .arg(row["bytes"].toVariant().toLongLong(), 12)
+               .arg(row.contains("status") ? QString::number(row["status"].toInt()) : QString("-"), 5);
+    }
+}
+
+bool copyDataset(const QString &from, const QString &to, QString *error)
+{
+    for (const char *name : {"users.json", "homeworks.json"}) {
+        if (!QFile::copy(QDir(from).filePath(name), QDir(to).filePath(name))) {
+            *error = QString("无法复制 %1").arg(QDir(from).filePath(name));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在线评测服务器数据文件与接口处理函数的基准测试");
+    parser.addHelpOption();
+    parser.addOption({"dataset", "使用已有数据集目录（先复制到临时目录，原文件不会被改写）", "dir"});
+    parser.addOption({"users", "生成数据集的用户数", "count", "10000"});
+    parser.addOption({"homeworks", "生成数据集的作业数", "count", "2000"});
+    parser.addOption({"submissions", "生成数据集的总提交数", "count", "100000"});
+    parser.addOption({"answer-bytes", "答案平均长度（字节）", "bytes", "1024"});
+    parser.addOption({"iterations", "每项操作的计时次数", "count", "5"});
+    parser.addOption({"ops", "只运行指定的操作，逗号分隔", "names"});
+    parser.addOption({"json", "把结果以 JSON 写入文件", "file"});
+    parser.process(a);
+
+    // 处理函数每次调用都会写日志，只保留警告以上，避免日志开销混入结果
+    Logger::getInstance()->setLogLevel(Logger::Warning);
+
+    QTextStream err(stderr);
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        err << "无法创建临时目录\n";
+        return 1;
+    }
+
+    QString error;
+    if (parser.isSet("dataset")) {
+        if (!copyDataset(parser.value("dataset"), workDir.path(), &error)) {
+            err << error << "\n";
+            return 1;
+        }
+    } else {
+        DatasetSpec spec;
+        spec.users = qMax(2, parser.value("users").toInt());
+        spec.homeworks = qMax(1, parser.value("homeworks").toInt());
+        spec.submissions = qMax<qint64>(0, parser.value("submissions").toLongLong());
+        spec.answerBytes = qMax(1, parser.value("answer-bytes").toInt());
+        err << "正在生成数据集...\n";
+        err.flush();
+        if (!SyntheticDataset::generate(spec, workDir.path(), &error)) {
+            err << "生成数据集失败：" << error << "\n";
+            return 1;
+        }
+    }
+
+    StorageBenchConfig config;
+    config.workDir = workDir.path();
+    config.iterations = qMax(1, parser.value("iterations").toInt());
+    QStringList known = StorageBenchmark::operationNames();
+    for (const QString &name : parser.value("ops").split(',', QString::SkipEmptyParts)) {
+        if (!known.contains(name.trimmed())) {
+            err << "未知的操作：" << name << "，可选：" << known.join(", ") << "\n";
+            return 1;
+        }
+        config.operations.append(name.trimmed());
+    }
+
+    QJsonObject report = StorageBenchmark(config).run();
+
+    printReport(report);
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "无法写入 " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(report).toJson());
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+QT -= gui
+QT += network sql
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = oj-storagebench
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtNetwork
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtSql
+
+# 直接编译服务器源码（不含 main.cpp），在进程内调用数据文件读写与接口处理函数
+SERVER_DIR = ../../OnlineJudgeServer
+COMMON_DIR = ../common
+INCLUDEPATH += $$SERVER_DIR $$COMMON_DIR
+
+LIBS += -lz
+
+SOURCES += \
+    main.cpp \
+    storagebenchmark.cpp \
+    $$COMMON_DIR/syntheticdataset.cpp \
+    $$SERVER_DIR/server.cpp \
+    $$SERVER_DIR/logger.cpp \
+    $$SERVER_DIR/judger.cpp \
+    $$SERVER_DIR/judgequeue.cpp \
+    $$SERVER_DIR/sandbox.cpp \
+    $$SERVER_DIR/compilecache.cpp \
+    $$SERVER_DIR/latencyrecorder.cpp \
+    $$SERVER_DIR/zygotepool.cpp \
+    $$SERVER_DIR/outputcomparator.cpp \
+    $$SERVER_DIR/checkerpool.cpp \
+    $$SERVER_DIR/verdictcache.cpp \
+    $$SERVER_DIR/testsetstore.cpp \
+    $$SERVER_DIR/plagiarismindex.cpp \
+    $$SERVER_DIR/workerlease.cpp \
+    $$SERVER_DIR/admissioncontrol.cpp \
+    $$SERVER_DIR/metrics.cpp \
+    $$SERVER_DIR/tracer.cpp \
+    $$SERVER_DIR/slowlog.cpp \
+    $$SERVER_DIR/httprequestparser.cpp \
+    $$SERVER_DIR/sessionstore.cpp
+
+HEADERS += \
+    storagebenchmark.h \
+    $$COMMON_DIR/syntheticdataset.h \
+    $$SERVER_DIR/server.h \
+    $$SERVER_DIR/logger.h \
+    $$SERVER_DIR/judger.h \
+    $$SERVER_DIR/judgequeue.h \
+    $$SERVER_DIR/sandbox.h \
+    $$SERVER_DIR/compilecache.h \
+    $$SERVER_DIR/latencyrecorder.h \
+    $$SERVER_DIR/zygotepool.h \
+    $$SERVER_DIR/outputcomparator.h \
+    $$SERVER_DIR/checkerpool.h \
+    $$SERVER_DIR/verdictcache.h \
+    $$SERVER_DIR/testsetstore.h \
+    $$SERVER_DIR/plagiarismindex.h \
+    $$SERVER_DIR/workerlease.h \
+    $$SERVER_DIR/admissioncontrol.h \
+    $$SERVER_DIR/metrics.h \
+    $$SERVER_DIR/tracer.h \
+    $$SERVER_DIR/slowlog.h \
+    $$SERVER_DIR/httprequestparser.h \
+    $$SERVER_DIR/sessionstore.h
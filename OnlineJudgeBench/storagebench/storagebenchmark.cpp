@@ -0,0 +1,240 @@
+#include "storagebenchmark.h"
+#include "server.h"
+#include "logger.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+// 丢弃写入数据的套接字：只记录字节数与响应的状态行
+class DiscardSocket : public QTcpSocket
+{
+public:
+    DiscardSocket() { setOpenMode(QIODevice::ReadWrite); }
+
+    void reset()
+    {
+        written = 0;
+        statusLine.clear();
+    }
+
+    int status() const
+    {
+        return statusLine.split(' ').value(1).toInt();
+    }
+
+    qint64 written = 0;
+
+protected:
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        if (written == 0) {
+            QByteArray head = QByteArray::fromRawData(data, int(qMin<qint64>(len, 64)));
+            statusLine = head.left(head.indexOf("\r\n"));
+        }
+        written += len;
+        return len;
+    }
+
+private:
+    QByteArray statusLine;
+};
+
+namespace {
+
+const char *const kOperationNames[] = {
+    "storage.users.load", "storage.users.save", "storage.homeworks.load", "storage.homeworks.save",
+    "handler.login", "handler.users.list", "handler.homeworks.course", "handler.homeworks.all",
+    "handler.submit", "handler.grade"
+};
+
+qint64 percentileOf(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    int index = qBound(0, int(std::ceil(p * sorted.size())) - 1, sorted.size() - 1);
+    return sorted[index];
+}
+
+double toMs(qint64 ns)
+{
+    return qRound64(ns / 1000.0) / 1000.0;
+}
+
+} // namespace
+
+StorageBenchmark::StorageBenchmark(const StorageBenchConfig &config)
+    : config(config)
+    , server(nullptr)
+    , socket(new DiscardSocket)
+    , sampleCourseId(-1)
+    , sampleHomeworkId(0)
+    , sampleStudentId(0)
+    , sampleSubmissionId(0)
+{
+}
+
+StorageBenchmark::~StorageBenchmark()
+{
+    delete server;
+    delete socket;
+}
+
+QStringList StorageBenchmark::operationNames()
+{
+    QStringList names;
+    for (const char *name : kOperationNames) {
+        names.append(name);
+    }
+    return names;
+}
+
+qint64 StorageBenchmark::callHandler(void (Server::*handler)(QTcpSocket*, const QJsonObject&),
+                                     const QJsonObject &request)
+{
+    socket->reset();
+    (server->*handler)(socket, request);
+    return socket->written;
+}
+
+QVector<StorageBenchmark::Operation> StorageBenchmark::buildOperations()
+{
+    // 读写用的数据对象只加载一次，保存操作每次写回同样的内容
+    QJsonObject users = server->loadDatabase();
+    QJsonObject homeworks = server->loadHomeworkDatabase();
+    qint64 usersBytes = QFileInfo(server->dbFilePath).size();
+    qint64 homeworksBytes = QFileInfo(server->homeworkDbPath).size();
+
+    QJsonArray userList = users["users"].toArray();
+    if (!userList.isEmpty()) {
+        sampleUsername = userList[userList.size() / 2].toObject()["username"].toString();
+    }
+    QJsonArray homeworkList = homeworks["homeworks"].toArray();
+    if (!homeworkList.isEmpty()) {
+        QJsonObject homework = homeworkList[homeworkList.size() / 2].toObject();
+        sampleHomeworkId = homework["id"].toInt();
+        sampleCourseId = homework["courseId"].toInt(-1);
+        QJsonArray submissions = homework["submissions"].toArray();
+        if (!submissions.isEmpty()) {
+            // 重复提交会替换该学生原有的记录，数据文件大小在多次运行中保持不变
+            QJsonObject submission = submissions[submissions.size() / 2].toObject();
+            sampleStudentId = submission["studentId"].toInt();
+            sampleSubmissionId = submission["id"].toInt();
+            sampleAnswer = submission["answer"].toString();
+            // 提交人取自登录会话，这里直接填入该学生的身份
+            server->session.userId = sampleStudentId;
+            server->session.username = submission["studentName"].toString();
+            server->session.role = "student";
+            server->authenticated = true;
+        }
+    }
+
+    Server *s = server;
+    QVector<Operation> operations;
+    operations.append({kOperationNames[0], [s, usersBytes]() {
+        s->loadDatabase();
+        return usersBytes;
+    }});
+    operations.append({kOperationNames[1], [s, users]() {
+        s->saveDatabase(users);
+        return QFileInfo(s->dbFilePath).size();
+    }});
+    operations.append({kOperationNames[2], [s, homeworksBytes]() {
+        s->loadHomeworkDatabase();
+        return homeworksBytes;
+    }});
+    operations.append({kOperationNames[3], [s, homeworks]() {
+        s->saveHomeworkDatabase(homeworks);
+        return QFileInfo(s->homeworkDbPath).size();
+    }});
+    operations.append({kOperationNames[4], [this]() {
+        return callHandler(&Server::handleLogin, {{"username", sampleUsername}, {"password", "123456"}});
+    }});
+    operations.append({kOperationNames[5], [this]() {
+        return callHandler(&Server::handleUserList, QJsonObject());
+    }});
+    operations.append({kOperationNames[6], [this]() {
+        return callHandler(&Server::handleHomeworkList, {{"courseId", sampleCourseId}});
+    }});
+    operations.append({kOperationNames[7], [this]() {
+        return callHandler(&Server::handleHomeworkList, QJsonObject());
+    }});
+    operations.append({kOperationNames[8], [this]() {
+        return callHandler(&Server::handleSubmission, {
+            {"homeworkId", sampleHomeworkId},
+            {"answer", sampleAnswer}
+        });
+    }});
+    operations.append({kOperationNames[9], [this]() {
+        return callHandler(&Server::handleGrade, {{"submissionId", sampleSubmissionId}, {"score", 90}});
+    }});
+    return operations;
+}
+
+QJsonObject StorageBenchmark::measure(const Operation &operation)
+{
+    // 先执行一次预热（文件缓存、首次注册的指标等），不计入结果
+    qint64 bytes = operation.body();
+    int status = operation.name.startsWith("handler.") ? socket->status() : 0;
+
+    QVector<qint64> samples;
+    QElapsedTimer timer;
+    for (int i = 0; i < config.iterations; ++i) {
+        timer.start();
+        bytes = operation.body();
+        samples.append(timer.nsecsElapsed());
+    }
+    std::sort(samples.begin(), samples.end());
+    qint64 total = 0;
+    for (qint64 ns : samples) {
+        total += ns;
+    }
+
+    QJsonObject result{
+        {"iterations", samples.size()},
+        {"bytes", bytes},
+        {"meanMs", toMs(samples.isEmpty() ? 0 : total / samples.size())},
+        {"minMs", toMs(samples.isEmpty() ? 0 : samples.first())},
+        {"p50Ms", toMs(percentileOf(samples, 0.50))},
+        {"p90Ms", toMs(percentileOf(samples, 0.90))},
+        {"p99Ms", toMs(percentileOf(samples, 0.99))},
+        {"maxMs", toMs(samples.isEmpty() ? 0 : samples.last())}
+    };
+    // 处理函数返回错误时结果不代表正常路径，记录状态码便于发现
+    if (status != 0) {
+        result["status"] = status;
+    }
+    return result;
+}
+
+QJsonObject StorageBenchmark::run()
+{
+    // 服务器的数据文件与各类缓存目录都相对于当前目录
+    QString previous = QDir::currentPath();
+    QDir::setCurrent(config.workDir);
+    server = new Server;
+
+    QJsonObject results;
+    for (const Operation &operation : buildOperations()) {
+        if (!config.operations.isEmpty() && !config.operations.contains(operation.name)) {
+            continue;
+        }
+        LOG_DEBUG(QString("基准测试：%1").arg(operation.name));
+        results[operation.name] = measure(operation);
+    }
+
+    QJsonObject dataset{
+        {"usersBytes", QFileInfo(server->dbFilePath).size()},
+        {"homeworksBytes", QFileInfo(server->homeworkDbPath).size()},
+        {"users", server->loadDatabase()["users"].toArray().size()},
+        {"homeworks", server->loadHomeworkDatabase()["homeworks"].toArray().size()}
+    };
+    QDir::setCurrent(previous);
+    return QJsonObject{
+        {"iterations", config.iterations},
+        {"dataset", dataset},
+        {"operations", results}
+    };
+}
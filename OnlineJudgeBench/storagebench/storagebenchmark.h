@@ -0,0 +1,58 @@
+#ifndef STORAGEBENCHMARK_H
+#define STORAGEBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+class QTcpSocket;
+class Server;
+class DiscardSocket;
+
+struct StorageBenchConfig
+{
+    QString workDir;            // 数据集所在目录，基准测试会改写其中的数据文件
+    int iterations = 5;
+    QStringList operations;     // 为空时运行全部
+};
+
+// 在进程内直接调用服务器的数据文件读写与接口处理函数并计时：
+// 不经过网络，响应写入一个丢弃数据的套接字，测得的是存储与处理本身的开销
+class StorageBenchmark
+{
+public:
+    explicit StorageBenchmark(const StorageBenchConfig &config);
+    ~StorageBenchmark();
+
+    // 阻塞运行全部操作，返回每个操作的耗时分布
+    QJsonObject run();
+
+    static QStringList operationNames();
+
+private:
+    struct Operation
+    {
+        QString name;
+        std::function<qint64()> body;   // 执行一次，返回写出或读入的字节数
+    };
+
+    QVector<Operation> buildOperations();
+    QJsonObject measure(const Operation &operation);
+    qint64 callHandler(void (Server::*handler)(QTcpSocket*, const QJsonObject&),
+                       const QJsonObject &request);
+
+    StorageBenchConfig config;
+    Server *server;
+    DiscardSocket *socket;
+    // 从已加载的数据中挑出确实存在的用户、作业与提交
+    QString sampleUsername;
+    int sampleCourseId;
+    int sampleHomeworkId;
+    int sampleStudentId;
+    int sampleSubmissionId;
+    QString sampleAnswer;
+};
+
+#endif // STORAGEBENCHMARK_H
@@ -9,6 +9,7 @@
 #include <QCloseEvent>
 
 QString LoginWindow::username;
+QByteArray LoginWindow::token;
 
 LoginWindow::LoginWindow(QWidget *parent)
     : QDialog(parent)
@@ -118,6 +119,7 @@ void LoginWindow::handleNetworkReply(QNetworkReply *reply)
         // 登录成功，获取用户ID和角色
         int userId = response["userId"].toInt();
         QString role = response["role"].toString();
+        token = response["token"].toString().toLatin1();
         
         // 发送登录成功信号，包含用户ID和角色信息
         emit loginSuccess(userId, role);
@@ -15,6 +15,8 @@ class LoginWindow : public QDialog
 public:
     explicit LoginWindow(QWidget *parent = nullptr);
     static QString getUsername() { return username; }
+    // 登录后服务器签发的会话令牌，之后的请求都放在 Authorization 头中
+    static QByteArray getToken() { return token; }
     
 signals:
     void loginSuccess(int userId, const QString &role);
@@ -33,6 +35,7 @@ private:
     QLabel *statusLabel;
     QNetworkAccessManager *networkManager;
     static QString username;
+    static QByteArray token;
 
     void setupUI();
     void initConnections();
@@ -228,6 +228,7 @@ private slots:
         QUrl url(QString("http://localhost:8080/api/users/%1").arg(action));
         QNetworkRequest request(url);
         request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request.setRawHeader("Authorization", "Bearer " + LoginWindow::getToken());
         
         QJsonDocument doc(data);
         QByteArray jsonData = doc.toJson();
@@ -316,6 +317,7 @@ void MainWindow::sendRequest(const QString &endpoint, const QJsonObject &data)
     QUrl url(QString("http://localhost:8080/api/%1").arg(endpoint));
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Authorization", "Bearer " + LoginWindow::getToken());
     
     QJsonDocument doc(data);
     QByteArray jsonData = doc.toJson();
@@ -657,6 +659,7 @@ public:
                     QUrl gradeUrl("http://localhost:8080/api/grade");
                     QNetworkRequest gradeRequest(gradeUrl);
                     gradeRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+                    gradeRequest.setRawHeader("Authorization", "Bearer " + LoginWindow::getToken());
                     
                     QJsonObject gradeData;
                     gradeData["submissionId"] = submission["id"].toInt();
@@ -824,6 +827,7 @@ void MainWindow::showSubmitDialog(const QJsonObject &homework)
         QUrl url("http://localhost:8080/api/submit");
         QNetworkRequest request(url);
         request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request.setRawHeader("Authorization", "Bearer " + LoginWindow::getToken());
         
         QJsonDocument doc(data);
         QByteArray jsonData = doc.toJson();
@@ -10,14 +10,56 @@ INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
 INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtNetwork
 INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtSql
 
+# 编译期最低日志级别（0=Debug … 4=Fatal），低于此级别的日志语句不会编译进程序
+# DEFINES += LOG_MIN_LEVEL=1
+
+# 轮转后的日志用 zlib 压缩为 .gz
+LIBS += -lz
+
 SOURCES += \
     main.cpp \
     server.cpp \
-    logger.cpp
+    logger.cpp \
+    judger.cpp \
+    judgequeue.cpp \
+    sandbox.cpp \
+    compilecache.cpp \
+    latencyrecorder.cpp \
+    zygotepool.cpp \
+    outputcomparator.cpp \
+    checkerpool.cpp \
+    verdictcache.cpp \
+    testsetstore.cpp \
+    plagiarismindex.cpp \
+    workerlease.cpp \
+    admissioncontrol.cpp \
+    metrics.cpp \
+    tracer.cpp \
+    slowlog.cpp \
+    httprequestparser.cpp \
+    sessionstore.cpp
 
 HEADERS += \
     server.h \
-    logger.h
+    logger.h \
+    judger.h \
+    judgequeue.h \
+    sandbox.h \
+    compilecache.h \
+    latencyrecorder.h \
+    zygotepool.h \
+    outputcomparator.h \
+    checkerpool.h \
+    verdictcache.h \
+    testsetstore.h \
+    plagiarismindex.h \
+    workerlease.h \
+    admissioncontrol.h \
+    metrics.h \
+    tracer.h \
+    slowlog.h \
+    httprequestparser.h \
+    sessionstore.h
 
 target.path = /usr/local/bin
 !isEmpty(target.path): INSTALLS += target 
\ No newline at end of file
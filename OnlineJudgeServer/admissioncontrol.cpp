@@ -0,0 +1,136 @@
+#include "admissioncontrol.h"
+#include <QDateTime>
+#include "logger.h"
+
+namespace {
+
+// 过载阈值；普通请求在阈值的 kSevereFactor 倍时才拒绝
+const qint64 kMaxLoopLagMs = 200;
+const qint64 kMaxP99Ms = 1000;
+const int kMaxPendingRequests = 64;
+const int kSevereFactor = 4;
+// 评测积压超过容量的一半时不再接受重测
+const int kRejudgeBacklogPercent = 50;
+
+// 只看最近的样本：超过此时间没有新样本的类别不参与判断
+const qint64 kSampleFreshMs = 5000;
+// p99 需要排序，最多每隔此时间重算一次
+const qint64 kP99RefreshMs = 250;
+const int kSampleWindow = 512;
+const int kMaxRetryAfterSec = 60;
+
+const char *const kClassNames[] = {"critical", "normal", "low"};
+
+int retryAfterFor(qint64 ms)
+{
+    return int(qBound<qint64>(1, ms / 1000 + 1, kMaxRetryAfterSec));
+}
+
+} // namespace
+
+AdmissionControl::AdmissionControl()
+{
+    for (int i = 0; i < kClassCount; ++i) {
+        latency.append(new LatencyRecorder(kSampleWindow));
+        lastSampleMs[i] = 0;
+        cachedP99Ms[i] = 0;
+        cachedAtMs[i] = 0;
+        admitted[i] = 0;
+        rejected[i] = 0;
+    }
+}
+
+AdmissionControl::~AdmissionControl()
+{
+    qDeleteAll(latency);
+}
+
+AdmissionControl::RouteClass AdmissionControl::classify(const QString &path)
+{
+    if (path == "/api/login" || path == "/api/submit" || path == "/api/grade"
+        || path.startsWith("/api/worker/") || path == "/metrics" || path == "/api/admin/introspect") {
+        return Critical;
+    }
+    if (path == "/api/homeworks" || path == "/api/rejudge" || path == "/api/users/list"
+        || path == "/api/judge/stats" || path == "/api/plagiarism") {
+        return Low;
+    }
+    return Normal;
+}
+
+qint64 AdmissionControl::recentP99Ms(RouteClass routeClass, qint64 nowMs)
+{
+    if (nowMs - lastSampleMs[routeClass] > kSampleFreshMs) {
+        return 0;
+    }
+    if (nowMs - cachedAtMs[routeClass] >= kP99RefreshMs) {
+        cachedP99Ms[routeClass] = latency[routeClass]->percentile(0.99) / 1000;
+        cachedAtMs[routeClass] = nowMs;
+    }
+    return cachedP99Ms[routeClass];
+}
+
+int AdmissionControl::admit(RouteClass routeClass, const QString &path, const Load &load)
+{
+    if (routeClass == Critical) {
+        ++admitted[routeClass];
+        return 0;
+    }
+
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    int factor = routeClass == Low ? 1 : kSevereFactor;
+    int retryAfter = 0;
+    QString reason;
+
+    // 关键请求变慢说明服务器已经饱和，优先为其让路
+    qint64 criticalP99 = recentP99Ms(Critical, nowMs);
+    qint64 ownP99 = recentP99Ms(routeClass, nowMs);
+    if (load.loopLagMs > kMaxLoopLagMs * factor) {
+        reason = QString("事件循环延迟 %1ms").arg(load.loopLagMs);
+        retryAfter = retryAfterFor(load.loopLagMs);
+    } else if (qMax(criticalP99, ownP99) > kMaxP99Ms * factor) {
+        qint64 p99 = qMax(criticalP99, ownP99);
+        reason = QString("p99 延迟 %1ms").arg(p99);
+        retryAfter = retryAfterFor(p99);
+    } else if (load.pendingRequests > kMaxPendingRequests * factor) {
+        reason = QString("%1 个请求排队").arg(load.pendingRequests);
+        retryAfter = 2;
+    } else if (path == "/api/rejudge" && load.judgeCapacity > 0
+               && load.judgeBacklog * 100 >= load.judgeCapacity * kRejudgeBacklogPercent) {
+        reason = QString("评测积压 %1/%2").arg(load.judgeBacklog).arg(load.judgeCapacity);
+        retryAfter = 10;
+    }
+
+    if (retryAfter == 0) {
+        ++admitted[routeClass];
+        return 0;
+    }
+
+    ++rejected[routeClass];
+    if (reason != lastReason) {
+        LOG_WARNING(QString("服务器过载（%1），拒绝 %2 类请求 %3").arg(reason).arg(kClassNames[routeClass]).arg(path));
+        lastReason = reason;
+    }
+    return retryAfter;
+}
+
+void AdmissionControl::record(RouteClass routeClass, qint64 latencyUs)
+{
+    latency[routeClass]->record(latencyUs);
+    lastSampleMs[routeClass] = QDateTime::currentMSecsSinceEpoch();
+}
+
+QJsonObject AdmissionControl::stats()
+{
+    QJsonObject classes;
+    for (int i = 0; i < kClassCount; ++i) {
+        QJsonObject summary = latency[i]->summary();
+        summary["admitted"] = admitted[i];
+        summary["rejected"] = rejected[i];
+        classes[kClassNames[i]] = summary;
+    }
+    return QJsonObject{
+        {"latencyUs", classes},
+        {"lastReason", lastReason}
+    };
+}
@@ -0,0 +1,58 @@
+#ifndef ADMISSIONCONTROL_H
+#define ADMISSIONCONTROL_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include "latencyrecorder.h"
+
+// 过载保护：按路由类别统计请求延迟，负载超限时拒绝低优先级请求
+// 延迟从请求的第一个字节到达开始计算，包含在事件循环中排队的时间
+// 登录、提交、评分等关键请求从不拒绝；列表刷新、重测等在过载时返回 503
+// 只在主线程调用
+class AdmissionControl
+{
+public:
+    enum RouteClass {
+        Critical = 0,  // 登录、提交、评分、远程评测节点、指标抓取、运维查询
+        Normal = 1,    // 其余写操作，严重过载时才拒绝
+        Low = 2        // 列表刷新、重测、统计查询
+    };
+
+    // 判断是否放行时的服务器负载
+    struct Load
+    {
+        qint64 loopLagMs = 0;     // 事件循环延迟
+        int pendingRequests = 0;  // 已收到数据、尚未处理完的连接数
+        int judgeBacklog = 0;
+        int judgeCapacity = 0;
+    };
+
+    AdmissionControl();
+    ~AdmissionControl();
+
+    static RouteClass classify(const QString &path);
+
+    // 放行返回 0，否则返回建议客户端等待的秒数（Retry-After）
+    int admit(RouteClass routeClass, const QString &path, const Load &load);
+    // 请求处理完成后记录延迟（微秒）
+    void record(RouteClass routeClass, qint64 latencyUs);
+
+    QJsonObject stats();
+
+private:
+    static const int kClassCount = 3;
+
+    // 最近样本的 p99（毫秒），样本过旧时视为 0
+    qint64 recentP99Ms(RouteClass routeClass, qint64 nowMs);
+
+    QList<LatencyRecorder*> latency;
+    qint64 lastSampleMs[kClassCount];
+    qint64 cachedP99Ms[kClassCount];
+    qint64 cachedAtMs[kClassCount];
+    qint64 admitted[kClassCount];
+    qint64 rejected[kClassCount];
+    QString lastReason;
+};
+
+#endif // ADMISSIONCONTROL_H
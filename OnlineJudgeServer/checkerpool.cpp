@@ -0,0 +1,353 @@
+#include "checkerpool.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include "sandbox.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+
+// 单个测试点的判定时限
+const qint64 kCheckTimeoutMs = 10000;
+const int kMaxResponseBytes = 64 * 1024;
+// 每个特判程序保留的空闲进程上限，多出的判完即退出
+const int kMaxIdlePerChecker = 16;
+
+// 特判程序常驻运行，CPU 时间按整个进程生命周期累计，只限制内存和进程数
+ResourceLimits checkerLimits()
+{
+    ResourceLimits limits;
+    limits.cpuTimeMs = 24LL * 3600 * 1000;
+    limits.memoryBytes = 1024LL << 20;
+    limits.outputBytes = 64LL << 20;
+    limits.maxProcesses = 1;
+    return limits;
+}
+
+void closeFd(int &fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int remainingMs(qint64 deadlineUs)
+{
+    return int(qMax<qint64>(0, (deadlineUs - Sandbox::monotonicUs()) / 1000));
+}
+
+// 非阻塞描述符上带截止时间的写入
+bool writeAll(int fd, const char *data, qint64 size, qint64 deadlineUs)
+{
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size_t(size));
+        if (n > 0) {
+            data += n;
+            size -= n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int timeout = remainingMs(deadlineUs);
+        if (timeout <= 0 || (poll(&pfd, 1, timeout) <= 0 && errno != EINTR)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readAll(int fd, char *data, qint64 size, qint64 deadlineUs)
+{
+    while (size > 0) {
+        ssize_t n = ::read(fd, data, size_t(size));
+        if (n > 0) {
+            data += n;
+            size -= n;
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            return false;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int timeout = remainingMs(deadlineUs);
+        if (timeout <= 0 || (poll(&pfd, 1, timeout) <= 0 && errno != EINTR)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeFrame(int fd, const QByteArray &payload, qint64 deadlineUs)
+{
+    quint32 length = qToLittleEndian(quint32(payload.size()));
+    return writeAll(fd, reinterpret_cast<const char*>(&length), sizeof(length), deadlineUs)
+        && writeAll(fd, payload.constData(), payload.size(), deadlineUs);
+}
+
+} // namespace
+
+CheckerPool::CheckerPool(const QString &dir)
+    : dir(dir)
+    , checks(0)
+    , spawns(0)
+    , restarts(0)
+{
+    QDir().mkpath(dir);
+}
+
+CheckerPool::~CheckerPool()
+{
+    QMutexLocker locker(&mutex);
+    for (Checker &checker : checkers) {
+        for (Process &process : checker.idle) {
+            terminate(process);
+        }
+    }
+    checkers.clear();
+}
+
+bool CheckerPool::contains(const QByteArray &key)
+{
+    QMutexLocker locker(&mutex);
+    return checkers.contains(key);
+}
+
+bool CheckerPool::install(const QByteArray &key, const QString &builtPath)
+{
+    QString binaryPath = QString("%1/%2").arg(dir).arg(QString::fromLatin1(key));
+    QString tmpPath = binaryPath + ".tmp";
+    QFile::remove(tmpPath);
+    if (!QFile::copy(builtPath, tmpPath)) {
+        LOG_ERROR(QString("无法登记特判程序：%1").arg(builtPath));
+        return false;
+    }
+    QFile::setPermissions(tmpPath, QFile::permissions(builtPath));
+
+    QMutexLocker locker(&mutex);
+    if (checkers.contains(key)) {
+        // 其他评测线程已先一步登记
+        QFile::remove(tmpPath);
+        return true;
+    }
+    QFile::remove(binaryPath);
+    if (!QFile::rename(tmpPath, binaryPath)) {
+        QFile::remove(tmpPath);
+        return false;
+    }
+    checkers[key].binaryPath = QFileInfo(binaryPath).absoluteFilePath();
+    LOG_INFO(QString("登记特判程序 %1").arg(QString::fromLatin1(key.left(12))));
+    return true;
+}
+
+CheckResult CheckerPool::check(const QByteArray &key, const QByteArray &input,
+                               const QByteArray &expected, const QByteArray &output)
+{
+    CheckResult result;
+    result.verdict = "SE";
+
+    Process process;
+    QString binary;
+    {
+        QMutexLocker locker(&mutex);
+        auto it = checkers.find(key);
+        if (it == checkers.end()) {
+            result.message = "特判程序未登记";
+            return result;
+        }
+        binary = it->binaryPath;
+        if (!it->idle.isEmpty()) {
+            process = it->idle.takeLast();
+        }
+        ++checks;
+    }
+
+    // 进程异常时重启一次再试
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (process.pid < 0) {
+            if (!spawn(binary, &process)) {
+                result.message = "特判程序无法启动";
+                return result;
+            }
+        }
+        if (exchange(process, input, expected, output, &result)) {
+            QMutexLocker locker(&mutex);
+            auto it = checkers.find(key);
+            if (it != checkers.end() && it->idle.size() < kMaxIdlePerChecker) {
+                it->idle.append(process);
+            } else {
+                terminate(process);
+            }
+            return result;
+        }
+
+        terminate(process);
+        QMutexLocker locker(&mutex);
+        ++restarts;
+        LOG_WARNING(QString("特判程序 %1 异常，重启").arg(QString::fromLatin1(key.left(12))));
+    }
+
+    result.verdict = "SE";
+    result.score = 0;
+    result.message = "特判程序运行异常";
+    return result;
+}
+
+QJsonObject CheckerPool::stats()
+{
+    QMutexLocker locker(&mutex);
+    int idle = 0;
+    for (const Checker &checker : checkers) {
+        idle += checker.idle.size();
+    }
+    return QJsonObject{
+        {"checkers", checkers.size()},
+        {"idle", idle},
+        {"checks", checks},
+        {"spawns", spawns},
+        {"restarts", restarts}
+    };
+}
+
+bool CheckerPool::spawn(const QString &binary, Process *process)
+{
+    QByteArray path = QFile::encodeName(binary);
+    QByteArray workDir = QFile::encodeName(dir);
+    int requestPipe[2] = {-1, -1};
+    int responsePipe[2] = {-1, -1};
+    int execPipe[2] = {-1, -1};
+    int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNull < 0 || pipe2(requestPipe, O_CLOEXEC) < 0 || pipe2(responsePipe, O_CLOEXEC) < 0
+        || pipe2(execPipe, O_CLOEXEC) < 0) {
+        for (int *p : {requestPipe, responsePipe, execPipe}) {
+            closeFd(p[0]);
+            closeFd(p[1]);
+        }
+        closeFd(devNull);
+        return false;
+    }
+
+    ResourceLimits limits = checkerLimits();
+    process->cgroupDir = Sandbox::createCgroup(limits);
+    int procsFd = -1;
+    if (!process->cgroupDir.isEmpty()) {
+        procsFd = ::open(QFile::encodeName(process->cgroupDir + "/cgroup.procs").constData(),
+                         O_WRONLY | O_CLOEXEC);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        int keep[] = {execPipe[1]};
+        if (Sandbox::setupChild(limits, requestPipe[0], responsePipe[1], devNull, keep, 1, procsFd)
+            && chdir(workDir.constData()) == 0) {
+            char *argv[] = {path.data(), nullptr};
+            execv(path.constData(), argv);
+        }
+        int err = errno;
+        ssize_t ignored = ::write(execPipe[1], &err, sizeof(err));
+        Q_UNUSED(ignored);
+        _exit(127);
+    }
+
+    closeFd(requestPipe[0]);
+    closeFd(responsePipe[1]);
+    closeFd(execPipe[1]);
+    closeFd(devNull);
+    closeFd(procsFd);
+    process->pid = pid;
+    process->requestFd = requestPipe[1];
+    process->responseFd = responsePipe[0];
+
+    int childErrno = 0;
+    ssize_t n = -1;
+    if (pid > 0) {
+        do {
+            n = ::read(execPipe[0], &childErrno, sizeof(childErrno));
+        } while (n < 0 && errno == EINTR);
+    }
+    closeFd(execPipe[0]);
+
+    if (pid < 0 || n == sizeof(childErrno)) {
+        LOG_ERROR(QString("特判程序启动失败：%1").arg(strerror(pid < 0 ? errno : childErrno)));
+        terminate(*process);
+        return false;
+    }
+
+    fcntl(process->requestFd, F_SETFL, O_NONBLOCK);
+    fcntl(process->responseFd, F_SETFL, O_NONBLOCK);
+    QMutexLocker locker(&mutex);
+    ++spawns;
+    return true;
+}
+
+void CheckerPool::terminate(Process &process)
+{
+    closeFd(process.requestFd);
+    closeFd(process.responseFd);
+    if (process.pid > 0) {
+        kill(-process.pid, SIGKILL);
+        kill(process.pid, SIGKILL);
+        while (waitpid(process.pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        process.pid = -1;
+    }
+    if (!process.cgroupDir.isEmpty()) {
+        QDir().rmdir(process.cgroupDir);
+        process.cgroupDir.clear();
+    }
+}
+
+bool CheckerPool::exchange(Process &process, const QByteArray &input, const QByteArray &expected,
+                           const QByteArray &output, CheckResult *result)
+{
+    qint64 deadlineUs = Sandbox::monotonicUs() + kCheckTimeoutMs * 1000;
+    if (!writeFrame(process.requestFd, input, deadlineUs)
+        || !writeFrame(process.requestFd, expected, deadlineUs)
+        || !writeFrame(process.requestFd, output, deadlineUs)) {
+        return false;
+    }
+
+    quint32 length = 0;
+    if (!readAll(process.responseFd, reinterpret_cast<char*>(&length), sizeof(length), deadlineUs)) {
+        return false;
+    }
+    length = qFromLittleEndian(length);
+    if (length == 0 || length > quint32(kMaxResponseBytes)) {
+        return false;
+    }
+    QByteArray response(int(length), '\0');
+    if (!readAll(process.responseFd, response.data(), length, deadlineUs)) {
+        return false;
+    }
+
+    // "<AC|WA|PC> [得分] [说明]"
+    QString text = QString::fromUtf8(response).trimmed();
+    QString verdict = text.section(' ', 0, 0);
+    QString rest = text.section(' ', 1).trimmed();
+    if (verdict != "AC" && verdict != "WA" && verdict != "PC") {
+        return false;
+    }
+
+    bool hasScore = false;
+    int score = rest.section(' ', 0, 0).toInt(&hasScore);
+    if (hasScore) {
+        rest = rest.section(' ', 1).trimmed();
+    } else {
+        score = verdict == "AC" ? 100 : 0;
+    }
+    result->verdict = verdict;
+    result->score = qBound(0, score, 100);
+    result->message = rest;
+    return true;
+}
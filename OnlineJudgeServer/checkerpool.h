@@ -0,0 +1,72 @@
+#ifndef CHECKERPOOL_H
+#define CHECKERPOOL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QJsonObject>
+#include <sys/types.h>
+
+// 特判程序的判定结果
+struct CheckResult
+{
+    QString verdict;   // AC / WA / PC（部分正确）/ SE（特判程序异常）
+    int score = 0;     // 本测试点得分百分比，0-100
+    QString message;
+};
+
+// 常驻特判程序池
+// 特判程序按源码哈希登记，进程启动后持续运行，通过标准输入输出上的分帧协议逐个判定测试点：
+//   请求：依次三帧——测试输入、标准输出、选手输出，每帧为 4 字节小端长度 + 内容
+//   响应：一帧文本 "<AC|WA|PC> [得分 0-100] [说明]"
+// 每个进程同一时间只服务一个测试点，判完放回空闲列表供后续测试点和提交复用；
+// 进程崩溃、超时或违反协议时终止并重启一次
+// 可被多个评测线程同时调用
+class CheckerPool
+{
+public:
+    explicit CheckerPool(const QString &dir);
+    ~CheckerPool();
+
+    // 是否已登记该特判程序
+    bool contains(const QByteArray &key);
+    // 登记编译好的特判程序，产物复制到池目录
+    bool install(const QByteArray &key, const QString &builtPath);
+
+    CheckResult check(const QByteArray &key, const QByteArray &input,
+                      const QByteArray &expected, const QByteArray &output);
+
+    QJsonObject stats();
+
+private:
+    struct Process
+    {
+        pid_t pid = -1;
+        int requestFd = -1;
+        int responseFd = -1;
+        QString cgroupDir;
+    };
+
+    struct Checker
+    {
+        QString binaryPath;
+        QList<Process> idle;
+    };
+
+    bool spawn(const QString &binary, Process *process);
+    void terminate(Process &process);
+    bool exchange(Process &process, const QByteArray &input, const QByteArray &expected,
+                  const QByteArray &output, CheckResult *result);
+
+    QString dir;
+    QHash<QByteArray, Checker> checkers;
+    QMutex mutex;
+
+    qint64 checks;
+    qint64 spawns;
+    qint64 restarts;
+};
+
+#endif // CHECKERPOOL_H
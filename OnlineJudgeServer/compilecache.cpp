@@ -0,0 +1,166 @@
+#include "compilecache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include "logger.h"
+
+CompileCache::CompileCache(const QString &cacheDir, qint64 maxBytes)
+    : dir(cacheDir)
+    , maxBytes(maxBytes)
+    , totalBytes(0)
+    , hits(0)
+    , misses(0)
+    , evictions(0)
+    , savedMs(0)
+{
+    QDir().mkpath(dir);
+    loadIndex();
+}
+
+QByteArray CompileCache::makeKey(const QByteArray &source, const QString &language,
+                                 const QString &compilerVersion, const QStringList &flags)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(language.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(compilerVersion.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(flags.join(' ').toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(source);
+    return hash.result().toHex();
+}
+
+QString CompileCache::artifactPath(const QByteArray &key) const
+{
+    return QString("%1/%2.bin").arg(dir).arg(QString::fromLatin1(key));
+}
+
+void CompileCache::loadIndex()
+{
+    // 重启后按文件修改时间恢复 LRU 顺序，编译耗时记录在同名 .meta 文件中
+    QFileInfoList files = QDir(dir).entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+    for (const QFileInfo &info : files) {
+        QByteArray key = info.completeBaseName().toLatin1();
+        QFile meta(QString("%1/%2.meta").arg(dir).arg(info.completeBaseName()));
+        qint64 compileMs = 0;
+        if (meta.open(QIODevice::ReadOnly)) {
+            compileMs = meta.readAll().trimmed().toLongLong();
+        }
+
+        lru.push_back(key);
+        Entry entry;
+        entry.size = info.size();
+        entry.compileMs = compileMs;
+        entry.lruPos = std::prev(lru.end());
+        index.insert(key, entry);
+        totalBytes += entry.size;
+    }
+
+    evictLocked();
+    LOG_INFO(QString("编译缓存载入 %1 个产物，共 %2 KB").arg(index.size()).arg(totalBytes / 1024));
+}
+
+bool CompileCache::fetch(const QByteArray &key, const QString &destPath)
+{
+    QString path;
+    qint64 compileMs = 0;
+    {
+        QMutexLocker locker(&mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++misses;
+            return false;
+        }
+        lru.splice(lru.begin(), lru, it->lruPos);
+        path = artifactPath(key);
+        compileMs = it->compileMs;
+    }
+
+    // 复制在锁外进行；期间被淘汰时已打开的文件仍可读完
+    QFile::remove(destPath);
+    if (!QFile::copy(path, destPath)) {
+        QMutexLocker locker(&mutex);
+        ++misses;
+        return false;
+    }
+    QFile::setPermissions(destPath, QFile::permissions(path));
+
+    QMutexLocker locker(&mutex);
+    ++hits;
+    savedMs += compileMs;
+    return true;
+}
+
+void CompileCache::store(const QByteArray &key, const QString &builtPath, qint64 compileMs)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (index.contains(key)) {
+            return;
+        }
+    }
+
+    // 先复制到临时文件再改名，其他线程不会读到半个产物
+    QString target = artifactPath(key);
+    QString temp = QString("%1.tmp%2").arg(target).arg(quintptr(QThread::currentThreadId()));
+    QFile::remove(temp);
+    if (!QFile::copy(builtPath, temp)) {
+        LOG_WARNING(QString("写入编译缓存失败：%1").arg(QString::fromLatin1(key)));
+        return;
+    }
+    QFile meta(QString("%1/%2.meta").arg(dir).arg(QString::fromLatin1(key)));
+    if (meta.open(QIODevice::WriteOnly)) {
+        meta.write(QByteArray::number(compileMs));
+        meta.close();
+    }
+    QFile::remove(target);
+    if (!QFile::rename(temp, target)) {
+        QFile::remove(temp);
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (index.contains(key)) {
+        return;
+    }
+    lru.push_front(key);
+    Entry entry;
+    entry.size = QFileInfo(target).size();
+    entry.compileMs = compileMs;
+    entry.lruPos = lru.begin();
+    index.insert(key, entry);
+    totalBytes += entry.size;
+    evictLocked();
+}
+
+void CompileCache::evictLocked()
+{
+    while (totalBytes > maxBytes && !lru.empty()) {
+        QByteArray key = lru.back();
+        lru.pop_back();
+        totalBytes -= index.value(key).size;
+        index.remove(key);
+        QFile::remove(artifactPath(key));
+        QFile::remove(QString("%1/%2.meta").arg(dir).arg(QString::fromLatin1(key)));
+        ++evictions;
+    }
+}
+
+QJsonObject CompileCache::stats()
+{
+    QMutexLocker locker(&mutex);
+    qint64 lookups = hits + misses;
+    return QJsonObject{
+        {"entries", index.size()},
+        {"bytes", totalBytes},
+        {"maxBytes", maxBytes},
+        {"hits", hits},
+        {"misses", misses},
+        {"evictions", evictions},
+        {"hitRate", lookups > 0 ? double(hits) / lookups : 0.0},
+        {"savedMs", savedMs}
+    };
+}
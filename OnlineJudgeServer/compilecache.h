@@ -0,0 +1,56 @@
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QJsonObject>
+#include <list>
+#include <iterator>
+
+// 编译产物缓存：以源码、语言、编译器版本、编译参数的哈希为键
+// 产物存放在磁盘目录中，内存里维护索引和 LRU 顺序，总大小超限时淘汰最久未用的产物
+// 可被多个评测线程同时调用
+class CompileCache
+{
+public:
+    CompileCache(const QString &cacheDir, qint64 maxBytes);
+
+    static QByteArray makeKey(const QByteArray &source, const QString &language,
+                              const QString &compilerVersion, const QStringList &flags);
+
+    // 命中时把产物复制到 destPath 并返回 true
+    bool fetch(const QByteArray &key, const QString &destPath);
+    // 编译成功后登记产物，compileMs 用于统计命中节省的时间
+    void store(const QByteArray &key, const QString &builtPath, qint64 compileMs);
+
+    QJsonObject stats();
+
+private:
+    struct Entry
+    {
+        qint64 size;
+        qint64 compileMs;
+        std::list<QByteArray>::iterator lruPos;
+    };
+
+    QString artifactPath(const QByteArray &key) const;
+    void loadIndex();
+    void evictLocked();
+
+    QString dir;
+    qint64 maxBytes;
+    qint64 totalBytes;
+    QHash<QByteArray, Entry> index;
+    std::list<QByteArray> lru;  // 队首最近使用
+    QMutex mutex;
+
+    qint64 hits;
+    qint64 misses;
+    qint64 evictions;
+    qint64 savedMs;
+};
+
+#endif // COMPILECACHE_H
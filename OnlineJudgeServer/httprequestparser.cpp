@@ -0,0 +1,136 @@
+#include "httprequestparser.h"
+#include <QList>
+
+HttpRequestParser::HttpRequestParser()
+    : start(0)
+    , scanned(0)
+    , bodyStart(-1)
+    , failed(false)
+    , contentLength(0)
+{
+}
+
+void HttpRequestParser::append(const QByteArray &data)
+{
+    if (start > 0) {
+        // 丢掉已取出的请求；流水线中剩下的半个请求移到开头
+        buffer.remove(0, start);
+        scanned -= start;
+        if (bodyStart >= 0) {
+            bodyStart -= start;
+        }
+        start = 0;
+    }
+    buffer.append(data);
+}
+
+void HttpRequestParser::clear()
+{
+    buffer.clear();
+    start = 0;
+    scanned = 0;
+    bodyStart = -1;
+    failed = false;
+}
+
+HttpRequestParser::Status HttpRequestParser::next(HttpRequest *request, QString *error)
+{
+    if (failed) {
+        *error = "连接上的请求格式错误";
+        return Invalid;
+    }
+
+    if (bodyStart < 0) {
+        // 结束标记可能跨越两次到达的数据，从上次查找位置之前 3 个字节开始
+        int headerEnd = buffer.indexOf("\r\n\r\n", qMax(start, scanned - 3));
+        if (headerEnd < 0) {
+            scanned = buffer.size();
+            if (buffered() >= kMaxHeaderBytes) {
+                failed = true;
+                *error = "请求头过长";
+                return Invalid;
+            }
+            return NeedMore;
+        }
+        if (headerEnd + 4 - start > kMaxHeaderBytes) {
+            failed = true;
+            *error = "请求头过长";
+            return Invalid;
+        }
+        if (!parseHeader(headerEnd, error)) {
+            failed = true;
+            return Invalid;
+        }
+        bodyStart = headerEnd + 4;
+    }
+
+    if (buffer.size() - bodyStart < contentLength) {
+        return NeedMore;
+    }
+
+    request->method = method;
+    request->path = path;
+    request->authorization = authorization;
+    request->body = buffer.mid(bodyStart, int(contentLength));
+    request->contentLength = contentLength;
+    request->wireBytes = bodyStart + contentLength - start;
+
+    start = bodyStart + int(contentLength);
+    scanned = start;
+    bodyStart = -1;
+    if (start == buffer.size()) {
+        buffer.clear();
+        start = 0;
+        scanned = 0;
+    }
+    return Complete;
+}
+
+bool HttpRequestParser::parseHeader(int headerEnd, QString *error)
+{
+    QList<QByteArray> lines = buffer.mid(start, headerEnd - start).split('\n');
+
+    // 请求行：方法 路径 版本
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 3 || requestLine[0].isEmpty() || requestLine[1].isEmpty()) {
+        *error = "无效的 HTTP 请求行";
+        return false;
+    }
+    method = requestLine[0];
+    path = requestLine[1];
+
+    // 只关心 Content-Length 与 Authorization，字段名不区分大小写，重复时取第一个
+    contentLength = 0;
+    authorization.clear();
+    bool lengthSeen = false;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray &line = lines[i];
+        int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        QByteArray name = line.left(colon).trimmed().toLower();
+        if (name == "authorization") {
+            if (authorization.isEmpty()) {
+                authorization = line.mid(colon + 1).trimmed();
+            }
+            continue;
+        }
+        if (name != "content-length" || lengthSeen) {
+            continue;
+        }
+        lengthSeen = true;
+        bool ok = false;
+        qint64 length = line.mid(colon + 1).trimmed().toLongLong(&ok);
+        if (!ok || length < 0) {
+            *error = "无效的 Content-Length";
+            return false;
+        }
+        if (length > kMaxBodyBytes) {
+            *error = QString("请求体过大：%1 字节").arg(length);
+            return false;
+        }
+        contentLength = length;
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef HTTPREQUESTPARSER_H
+#define HTTPREQUESTPARSER_H
+
+#include <QByteArray>
+#include <QString>
+
+// 一个完整的 HTTP 请求
+struct HttpRequest
+{
+    QByteArray method;
+    QByteArray path;
+    QByteArray body;
+    QByteArray authorization;  // Authorization 头的值，没有时为空
+    qint64 contentLength = 0;
+    qint64 wireBytes = 0;      // 请求行、请求头与请求体的总字节数
+};
+
+// 增量解析一条连接上收到的 HTTP/1.1 请求，不依赖套接字，可单独测试与压测
+// 数据分多次到达时只查找新到的部分；一次收到多个请求（流水线）时逐个取出
+// 每条连接一个实例，只在所属线程调用
+class HttpRequestParser
+{
+public:
+    enum Status {
+        NeedMore,   // 请求还不完整，等待更多数据
+        Complete,   // 取出了一个请求，缓冲区中可能还有下一个
+        Invalid     // 格式错误或超出限制，连接应当关闭
+    };
+
+    static const int kMaxHeaderBytes = 64 * 1024;           // 请求行与请求头（含结束空行）
+    static const qint64 kMaxBodyBytes = qint64(512) << 20;
+
+    HttpRequestParser();
+
+    void append(const QByteArray &data);
+    // 取出下一个完整的请求；返回 Invalid 后解析器不再可用
+    Status next(HttpRequest *request, QString *error);
+    void clear();
+
+    bool isIdle() const { return buffer.size() == start; }
+    int buffered() const { return buffer.size() - start; }
+    int capacity() const { return buffer.capacity(); }
+
+private:
+    bool parseHeader(int headerEnd, QString *error);
+
+    QByteArray buffer;
+    int start;             // 下一个请求在缓冲区中的起始位置
+    int scanned;           // 已查找过请求头结束标记的位置
+    int bodyStart;         // 请求头已解析时为请求体的起始位置，否则为 -1
+    bool failed;
+    QByteArray method;
+    QByteArray path;
+    QByteArray authorization;
+    qint64 contentLength;
+};
+
+#endif // HTTPREQUESTPARSER_H
@@ -0,0 +1,260 @@
+#include "judgequeue.h"
+#include <QDateTime>
+#include <limits>
+#include "logger.h"
+
+namespace {
+
+const qint64 kNoDeadline = std::numeric_limits<qint64>::max();
+// rank 中各字段的位宽：优先级 2 位、轮次 14 位、截止时间 42 位（毫秒，可表示到 2109 年）
+const int kRoundBits = 14;
+const int kDeadlineBits = 42;
+
+} // namespace
+
+JudgeWorker::JudgeWorker(JudgeQueue *queue, int index, QObject *parent)
+    : QThread(parent)
+    , queue(queue)
+    , index(index)
+{
+}
+
+void JudgeWorker::run()
+{
+    JudgeJob job;
+    while (queue->take(index, &job)) {
+        JudgeResult result = queue->judger.judge(job);
+        emit queue->jobFinished(result);
+    }
+}
+
+bool JudgeQueue::ScheduleKey::operator<(const ScheduleKey &other) const
+{
+    if (priority != other.priority) return priority < other.priority;
+    if (round != other.round) return round < other.round;
+    if (deadlineMs != other.deadlineMs) return deadlineMs < other.deadlineMs;
+    return sequence < other.sequence;
+}
+
+qint64 JudgeQueue::ScheduleKey::rank() const
+{
+    const qint64 maxRound = (qint64(1) << kRoundBits) - 1;
+    const qint64 maxDeadline = (qint64(1) << kDeadlineBits) - 1;
+    qint64 deadline = deadlineMs == kNoDeadline ? maxDeadline : qBound<qint64>(0, deadlineMs, maxDeadline - 1);
+    return (qint64(priority) << (kRoundBits + kDeadlineBits))
+        | (qMin<qint64>(round, maxRound) << kDeadlineBits)
+        | deadline;
+}
+
+JudgeQueue::JudgeQueue(int capacity, int workerCount, QObject *parent)
+    : QObject(parent)
+    , maxPending(capacity)
+    , nextSequence(0)
+    , totalPending(0)
+    , stopping(0)
+    , steals(0)
+    , nextJobId(QDateTime::currentMSecsSinceEpoch())
+{
+    qRegisterMetaType<JudgeResult>("JudgeResult");
+
+    if (workerCount <= 0) {
+        workerCount = qMax(1, QThread::idealThreadCount());
+    }
+    casePool.setMaxThreadCount(workerCount);
+    judger.setCasePool(&casePool);
+    judger.setCaseCallback([this](qint64 jobId, int index, const QJsonObject &caseResult) {
+        emit caseFinished(jobId, index, caseResult);
+    });
+    for (int i = 0; i < workerCount; ++i) {
+        LocalQueue *queue = new LocalQueue;
+        queue->headRank.storeRelease(kEmptyRank);
+        queue->size.storeRelease(0);
+        queues.append(queue);
+        workers.append(new JudgeWorker(this, i, this));
+    }
+}
+
+JudgeQueue::~JudgeQueue()
+{
+    stop();
+    qDeleteAll(queues);
+}
+
+void JudgeQueue::start()
+{
+    for (JudgeWorker *worker : workers) {
+        worker->start();
+    }
+    LOG_INFO(QString("评测队列启动：%1 个评测线程，容量 %2")
+        .arg(workers.size())
+        .arg(maxPending));
+}
+
+void JudgeQueue::stop()
+{
+    {
+        QMutexLocker locker(&idleMutex);
+        if (stopping.loadAcquire()) {
+            return;
+        }
+        stopping.storeRelease(1);
+        notEmpty.wakeAll();
+    }
+
+    for (JudgeWorker *worker : workers) {
+        worker->wait();
+    }
+    casePool.waitForDone();
+}
+
+qint64 JudgeQueue::enqueue(JudgeJob job)
+{
+    if (stopping.loadAcquire() || totalPending.loadAcquire() >= maxPending) {
+        return -1;
+    }
+
+    job.jobId = nextJobId.fetchAndAddRelaxed(1);
+    insert(job);
+    return job.jobId;
+}
+
+void JudgeQueue::requeue(const JudgeJob &job)
+{
+    if (!stopping.loadAcquire()) {
+        insert(job);
+    }
+}
+
+bool JudgeQueue::takeRemote(JudgeJob *job)
+{
+    int best = -1;
+    qint64 bestHead = kEmptyRank;
+    int bestSize = 0;
+    for (int i = 0; i < queues.size(); ++i) {
+        qint64 head = queues[i]->headRank.loadAcquire();
+        int size = queues[i]->size.loadAcquire();
+        if (head < bestHead || (head == bestHead && size > bestSize)) {
+            best = i;
+            bestHead = head;
+            bestSize = size;
+        }
+    }
+    return best >= 0 && popFrom(best, job);
+}
+
+void JudgeQueue::insert(const JudgeJob &job)
+{
+    ScheduleKey key;
+    key.priority = qBound(0, int(job.priority), kPriorityCount - 1);
+    key.deadlineMs = job.deadlineMs > 0 ? job.deadlineMs : kNoDeadline;
+    key.sequence = nextSequence++;
+    {
+        QMutexLocker locker(&roundMutex);
+        key.round = userPending[job.studentId]++;
+    }
+
+    // 放入最短的本地队列，其余不均衡由窃取弥补
+    LocalQueue *target = queues.first();
+    for (LocalQueue *queue : queues) {
+        if (queue->size.loadAcquire() < target->size.loadAcquire()) {
+            target = queue;
+        }
+    }
+    {
+        QMutexLocker locker(&target->mutex);
+        target->jobs.insert(key, job);
+        target->headRank.storeRelease(target->jobs.firstKey().rank());
+        target->size.storeRelease(target->jobs.size());
+    }
+    totalPending.fetchAndAddRelease(1);
+
+    QMutexLocker locker(&idleMutex);
+    notEmpty.wakeOne();
+}
+
+QJsonObject JudgeQueue::stats()
+{
+    int counts[kPriorityCount] = {0, 0, 0};
+    for (LocalQueue *queue : queues) {
+        QMutexLocker locker(&queue->mutex);
+        for (auto it = queue->jobs.cbegin(); it != queue->jobs.cend(); ++it) {
+            ++counts[it.key().priority];
+        }
+    }
+    return QJsonObject{
+        {"sample", counts[JudgeJob::Sample]},
+        {"live", counts[JudgeJob::Live]},
+        {"rejudge", counts[JudgeJob::Rejudge]},
+        {"steals", steals.loadAcquire()}
+    };
+}
+
+bool JudgeQueue::take(int workerIndex, JudgeJob *job)
+{
+    while (!stopping.loadAcquire()) {
+        if (tryTake(workerIndex, job)) {
+            return true;
+        }
+        // 在 idleMutex 下复查计数，enqueue 在同一把锁下唤醒，不会丢失通知
+        QMutexLocker locker(&idleMutex);
+        if (!stopping.loadAcquire() && totalPending.loadAcquire() == 0) {
+            notEmpty.wait(&idleMutex);
+        }
+    }
+    return false;
+}
+
+bool JudgeQueue::tryTake(int workerIndex, JudgeJob *job)
+{
+    // 只读原子变量挑选目标：比较各队首的（优先级，轮次，截止时间），
+    // 其他队列的队首排在本地队首之前时窃取，使公平轮次与截止时间在队列之间也成立
+    qint64 ownHead = queues[workerIndex]->headRank.loadAcquire();
+    int victim = -1;
+    qint64 victimHead = ownHead;
+    int victimSize = 0;
+    for (int k = 1; k < queues.size(); ++k) {
+        int i = (workerIndex + k) % queues.size();
+        qint64 head = queues[i]->headRank.loadAcquire();
+        int size = queues[i]->size.loadAcquire();
+        if (head < victimHead || (head == victimHead && victim >= 0 && size > victimSize)) {
+            victim = i;
+            victimHead = head;
+            victimSize = size;
+        }
+    }
+
+    if (victim >= 0 && popFrom(victim, job)) {
+        steals.fetchAndAddRelaxed(1);
+        return true;
+    }
+    return popFrom(workerIndex, job);
+}
+
+bool JudgeQueue::popFrom(int queueIndex, JudgeJob *job)
+{
+    LocalQueue *queue = queues[queueIndex];
+    {
+        QMutexLocker locker(&queue->mutex);
+        if (queue->jobs.isEmpty()) {
+            return false;
+        }
+        auto it = queue->jobs.begin();
+        *job = it.value();
+        queue->jobs.erase(it);
+        queue->headRank.storeRelease(queue->jobs.isEmpty()
+            ? kEmptyRank : queue->jobs.firstKey().rank());
+        queue->size.storeRelease(queue->jobs.size());
+    }
+    totalPending.fetchAndSubRelease(1);
+    releaseRound(job->studentId);
+    return true;
+}
+
+void JudgeQueue::releaseRound(int studentId)
+{
+    QMutexLocker locker(&roundMutex);
+    auto it = userPending.find(studentId);
+    if (it != userPending.end() && --it.value() <= 0) {
+        userPending.erase(it);
+    }
+}
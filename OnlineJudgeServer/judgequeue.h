@@ -0,0 +1,133 @@
+#ifndef JUDGEQUEUE_H
+#define JUDGEQUEUE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QAtomicInteger>
+#include <limits>
+#include <QJsonObject>
+#include <QThreadPool>
+#include "judger.h"
+
+class JudgeQueue;
+
+// 评测线程：循环从队列取任务并判题
+class JudgeWorker : public QThread
+{
+    Q_OBJECT
+public:
+    JudgeWorker(JudgeQueue *queue, int index, QObject *parent = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    JudgeQueue *queue;
+    int index;
+};
+
+// 按优先级与截止时间调度的评测队列 + 评测线程池
+// 每个评测线程有自己的本地队列，enqueue 放入当前最短的队列；本地队列为空或别处队首按
+// （优先级，轮次，截止时间）排在本地队首之前时从其他线程的队列窃取，避免所有线程争抢同一把锁
+// 队首只经原子变量读取，并发入队时可能短暂取到次优的任务；同一键值在队列之间不保证入队顺序
+// enqueue 只在主线程调用且不阻塞；结果通过 jobFinished 信号排队回到主线程
+class JudgeQueue : public QObject
+{
+    Q_OBJECT
+public:
+    // workerCount 为 0 时按 CPU 核数创建评测线程
+    explicit JudgeQueue(int capacity = 1024, int workerCount = 0, QObject *parent = nullptr);
+    ~JudgeQueue();
+
+    // 须在 start 之前调用
+    void setCompileCache(CompileCache *cache) { judger.setCompileCache(cache); }
+    void setZygotePool(ZygotePool *pool) { judger.setZygotePool(pool); }
+    void setCheckerPool(CheckerPool *pool) { judger.setCheckerPool(pool); }
+    void setVerdictCache(VerdictCache *cache) { judger.setVerdictCache(cache); }
+    void setTestSetStore(TestSetStore *store) { judger.setTestSetStore(store); }
+
+    void start();
+    void stop();
+
+    // 入队成功返回任务ID，队列已满返回 -1
+    qint64 enqueue(JudgeJob job);
+    // 远程节点租约过期的任务放回队列，保留原任务ID，不受容量限制
+    void requeue(const JudgeJob &job);
+    // 供远程评测节点拉取：不阻塞，取全局优先级最高的任务
+    bool takeRemote(JudgeJob *job);
+
+    int pendingCount() const { return totalPending.loadAcquire(); }
+    int capacity() const { return maxPending; }
+    int workerCount() const { return workers.size(); }
+
+    // 各优先级排队数与窃取次数
+    QJsonObject stats();
+
+signals:
+    void jobFinished(const JudgeResult &result);
+    // 样例运行任务每完成一个样例发出一次，先于 jobFinished
+    void caseFinished(qint64 jobId, int index, const QJsonObject &caseResult);
+
+private:
+    friend class JudgeWorker;
+
+    static const int kPriorityCount = 3;
+    static const qint64 kEmptyRank = std::numeric_limits<qint64>::max();
+
+    // 排序键：优先级 > 该用户的排队轮次 > 截止时间 > 入队顺序
+    // 轮次为入队时该用户已在排队的任务数，同一用户的大量提交会排到其他用户之后
+    struct ScheduleKey
+    {
+        int priority;
+        int round;
+        qint64 deadlineMs;
+        qint64 sequence;
+
+        bool operator<(const ScheduleKey &other) const;
+        // 压缩成一个 64 位数，按数值大小与上面的顺序一致（不含入队顺序，轮次过大时截断）
+        qint64 rank() const;
+    };
+
+    struct LocalQueue
+    {
+        QMutex mutex;
+        QMap<ScheduleKey, JudgeJob> jobs;
+        // 队首任务的 ScheduleKey::rank()（空队列为 kEmptyRank），供其他线程无锁比较
+        QAtomicInteger<qint64> headRank;
+        QAtomicInt size;
+    };
+
+    // 阻塞直到取到任务；队列停止时返回 false
+    bool take(int workerIndex, JudgeJob *job);
+    bool tryTake(int workerIndex, JudgeJob *job);
+    bool popFrom(int queueIndex, JudgeJob *job);
+    void insert(const JudgeJob &job);
+    void releaseRound(int studentId);
+
+    Judger judger;
+    QThreadPool casePool;  // 各评测线程共享的测试点运行线程
+    QList<JudgeWorker*> workers;
+    QList<LocalQueue*> queues;
+    int maxPending;
+    qint64 nextSequence;
+
+    QAtomicInt totalPending;
+    QAtomicInt stopping;
+    QAtomicInteger<qint64> steals;
+    QAtomicInteger<qint64> nextJobId;
+
+    // 空闲线程在此等待新任务
+    QMutex idleMutex;
+    QWaitCondition notEmpty;
+
+    // 每个用户正在排队的任务数
+    QMutex roundMutex;
+    QHash<int, int> userPending;
+};
+
+#endif // JUDGEQUEUE_H
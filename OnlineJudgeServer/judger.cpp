@@ -0,0 +1,773 @@
+#include "judger.h"
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <limits.h>
+#include "compilecache.h"
+#include "zygotepool.h"
+#include "outputcomparator.h"
+#include "checkerpool.h"
+#include "verdictcache.h"
+#include "testsetstore.h"
+#include "logger.h"
+
+namespace {
+
+struct LanguageSpec
+{
+    const char *name;
+    const char *sourceFile;
+    QStringList compileCommand;
+};
+
+const QList<LanguageSpec> &languages()
+{
+    static const QList<LanguageSpec> specs = {
+        {"c", "main.c", {"gcc", "-O2", "-std=c11", "-o", "main", "main.c", "-lm"}},
+        {"cpp", "main.cpp", {"g++", "-O2", "-std=c++17", "-o", "main", "main.cpp"}}
+    };
+    return specs;
+}
+
+const LanguageSpec *findLanguage(const QString &name)
+{
+    for (const LanguageSpec &spec : languages()) {
+        if (name == spec.name) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+// 编译器本身的限制放宽，cc1plus/as/ld 需要多个进程
+ResourceLimits compileLimits()
+{
+    ResourceLimits limits;
+    limits.cpuTimeMs = 10000;
+    limits.wallTimeMs = 20000;
+    limits.memoryBytes = 2048LL << 20;
+    limits.outputBytes = 64LL << 20;
+    limits.maxProcesses = 16;
+    return limits;
+}
+
+// 样例运行返回给学生的输出上限
+const int kSampleOutputLimit = 4096;
+
+// 样例运行的输出接收方：转给比较器，同时保留前 kSampleOutputLimit 字节返回给学生
+class SampleSink : public OutputSink
+{
+public:
+    explicit SampleSink(OutputComparator *comparator)
+        : comparator(comparator)
+    {
+    }
+
+    bool consume(const char *data, qint64 size) override
+    {
+        if (kept.size() < kSampleOutputLimit) {
+            kept.append(data, int(qMin<qint64>(size, kSampleOutputLimit - kept.size())));
+        }
+        bool matching = comparator ? comparator->consume(data, size) : true;
+        // 已判定不一致且保留的输出已满时不再需要后续输出
+        return matching || kept.size() < kSampleOutputLimit;
+    }
+
+    QByteArray kept;
+
+private:
+    OutputComparator *comparator;
+};
+
+// 单个测试点的运行结果
+struct CaseOutcome
+{
+    RunResult run;
+    QString verdict;
+    QString detail;
+    double earned = 0;  // 得分比例，特判可给部分分
+    bool reused = false;  // 沿用上次评测的结果
+};
+
+// 在线程池中运行一个测试点，完成后释放信号量
+class CaseTask : public QRunnable
+{
+public:
+    CaseTask(std::function<void()> body, QSemaphore *done)
+        : body(body)
+        , done(done)
+    {
+    }
+
+    void run() override
+    {
+        body();
+        done->release();
+    }
+
+private:
+    std::function<void()> body;
+    QSemaphore *done;
+};
+
+} // namespace
+
+QJsonObject JudgeJob::toJson() const
+{
+    QJsonArray packCasesJson;
+    for (const auto &testCase : packCases) {
+        packCasesJson.append(QJsonObject{
+            {"input", QString::fromLatin1(testCase.first.toBase64())},
+            {"output", QString::fromLatin1(testCase.second.toBase64())}
+        });
+    }
+    return QJsonObject{
+        {"jobId", QString::number(jobId)},
+        {"priority", int(priority)},
+        {"deadlineMs", QString::number(deadlineMs)},
+        {"homeworkId", homeworkId},
+        {"submissionId", submissionId},
+        {"studentId", studentId},
+        {"language", language},
+        {"answer", answer},
+        {"problem", problem},
+        {"previousTestSet", previousTestSet},
+        {"previousConfig", previousConfig},
+        {"previousCases", previousCases},
+        {"packCases", packCasesJson}
+    };
+}
+
+JudgeJob JudgeJob::fromJson(const QJsonObject &object)
+{
+    JudgeJob job;
+    job.jobId = object["jobId"].toString().toLongLong();
+    job.priority = Priority(qBound(int(Sample), object["priority"].toInt(Live), int(Rejudge)));
+    job.deadlineMs = object["deadlineMs"].toString().toLongLong();
+    job.homeworkId = object["homeworkId"].toInt();
+    job.submissionId = object["submissionId"].toInt();
+    job.studentId = object["studentId"].toInt();
+    job.language = object["language"].toString();
+    job.answer = object["answer"].toString();
+    job.problem = object["problem"].toObject();
+    job.previousTestSet = object["previousTestSet"].toInt();
+    job.previousConfig = object["previousConfig"].toString();
+    job.previousCases = object["previousCases"].toArray();
+    for (const QJsonValue &val : object["packCases"].toArray()) {
+        QJsonObject testCase = val.toObject();
+        job.packCases.append(qMakePair(QByteArray::fromBase64(testCase["input"].toString().toLatin1()),
+                                       QByteArray::fromBase64(testCase["output"].toString().toLatin1())));
+    }
+    return job;
+}
+
+QJsonObject JudgeResult::toJson() const
+{
+    return QJsonObject{
+        {"jobId", QString::number(jobId)},
+        {"homeworkId", homeworkId},
+        {"studentId", studentId},
+        {"verdict", verdict},
+        {"score", score},
+        {"message", message},
+        {"cases", cases},
+        {"timing", timing},
+        {"judgeTimeMs", judgeTimeMs},
+        {"testSetVersion", testSetVersion},
+        {"caseConfig", caseConfig}
+    };
+}
+
+JudgeResult JudgeResult::fromJson(const QJsonObject &object)
+{
+    JudgeResult result;
+    result.jobId = object["jobId"].toString().toLongLong();
+    result.homeworkId = object["homeworkId"].toInt();
+    result.studentId = object["studentId"].toInt();
+    result.verdict = object["verdict"].toString();
+    result.score = object["score"];
+    result.message = object["message"].toString();
+    result.cases = object["cases"].toArray();
+    result.timing = object["timing"].toObject();
+    result.judgeTimeMs = object["judgeTimeMs"].toVariant().toLongLong();
+    result.testSetVersion = object["testSetVersion"].toInt();
+    result.caseConfig = object["caseConfig"].toString();
+    return result;
+}
+
+Judger::Judger()
+    : compileCache(nullptr)
+    , zygotePool(nullptr)
+    , casePool(nullptr)
+    , checkerPool(nullptr)
+    , verdictCache(nullptr)
+    , testSetStore(nullptr)
+{
+}
+
+bool Judger::canJudge(const QJsonObject &problem)
+{
+    if (problem["judgeType"].toString() == "code") {
+        return problem["testSetVersion"].toInt() > 0 || !problem["testCases"].toArray().isEmpty();
+    }
+    return problem.contains("referenceAnswer");
+}
+
+bool Judger::isSupportedLanguage(const QString &language)
+{
+    return findLanguage(language) != nullptr;
+}
+
+JudgeResult Judger::judge(const JudgeJob &job) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    JudgeResult result;
+    if (job.problem["judgeType"].toString() != "code") {
+        result = judgeText(job);
+    } else if (job.priority == JudgeJob::Sample) {
+        result = judgeSamples(job);
+    } else {
+        result = judgeCode(job);
+    }
+    result.jobId = job.jobId;
+    result.homeworkId = job.homeworkId;
+    result.studentId = job.studentId;
+    result.judgeTimeMs = timer.elapsed();
+    return result;
+}
+
+JudgeResult Judger::judgeText(const JudgeJob &job) const
+{
+    JudgeResult result;
+    int fullScore = job.problem["fullScore"].toInt(100);
+
+    // 文本作业：忽略首尾及连续空白后与标准答案比较
+    QString expected = job.problem["referenceAnswer"].toString().simplified();
+    if (job.answer.simplified() == expected) {
+        result.verdict = "AC";
+        result.score = fullScore;
+        result.message = "答案正确";
+    } else {
+        result.verdict = "WA";
+        result.score = 0;
+        result.message = "答案错误";
+    }
+    return result;
+}
+
+JudgeResult Judger::judgeCode(const JudgeJob &job) const
+{
+    JudgeResult result;
+    int fullScore = job.problem["fullScore"].toInt(100);
+
+    QTemporaryDir workDir;
+    QString binaryPath;
+    if (!compileAnswer(job, workDir, &binaryPath, &result)) {
+        return result;
+    }
+    qint64 compileMs = result.timing["compileMs"].toVariant().toLongLong();
+    bool cached = result.timing["compileCached"].toBool();
+
+    QByteArray checkerKey;
+    QString checkerError;
+    if (!prepareChecker(job.problem, &checkerKey, &checkerError)) {
+        result.verdict = "SE";
+        result.message = checkerError;
+        return result;
+    }
+
+    ResourceLimits limits = problemLimits(job.problem);
+    OutputComparator::Mode checkMode = OutputComparator::modeFromString(job.problem["checkMode"].toString());
+    double epsilon = job.problem["floatEpsilon"].toDouble(1e-6);
+
+    // 测试数据优先取版本化的数据包，早期作业仍使用内联的 testCases
+    int packVersion = job.problem["testSetVersion"].toInt();
+    QSharedPointer<TestSetPack> pack;
+    QJsonArray testCases;
+    int caseCount = 0;
+    if (packVersion > 0 && testSetStore) {
+        pack = testSetStore->open(job.homeworkId, packVersion);
+        if (!pack) {
+            result.verdict = "SE";
+            result.message = QString("测试数据版本 %1 不可用").arg(packVersion);
+            return result;
+        }
+        caseCount = pack->caseCount();
+    } else if (packVersion > 0) {
+        // 远程评测节点没有数据包，测试点由服务器内联在任务中
+        caseCount = job.packCases.size();
+    } else {
+        testCases = job.problem["testCases"].toArray();
+        caseCount = testCases.size();
+    }
+    if (caseCount == 0) {
+        result.verdict = "SE";
+        result.message = "没有测试数据";
+        return result;
+    }
+
+    // 可执行文件与判定方式都相同时，单个测试点的结果只取决于该测试点的内容
+    QByteArray artifactHash = fileHash(binaryPath);
+    QCryptographicHash configHash(QCryptographicHash::Sha256);
+    configHash.addData(artifactHash);
+    configHash.addData(limits.key().toUtf8());
+    configHash.addData(QJsonDocument(QJsonObject{
+        {"checkMode", job.problem["checkMode"]},
+        {"floatEpsilon", job.problem["floatEpsilon"]},
+        {"checker", job.problem["checker"]}
+    }).toJson(QJsonDocument::Compact));
+    QString caseConfig = QString::fromLatin1(configHash.result().toHex());
+    result.testSetVersion = packVersion;
+    result.caseConfig = caseConfig;
+
+    // 可执行文件与测试数据都没变时直接复用上次的评测结果
+    QByteArray testVersion;
+    QByteArray verdictKey;
+    if (verdictCache && !artifactHash.isEmpty()) {
+        testVersion = testSetVersion(job.homeworkId, job.problem, pack.data());
+        verdictKey = VerdictCache::makeKey(artifactHash, testVersion, limits.key());
+        JudgeResult cachedResult;
+        if (verdictCache->lookup(job.homeworkId, testVersion, verdictKey, &cachedResult)) {
+            cachedResult.timing = result.timing;
+            cachedResult.timing["verdictCached"] = true;
+            LOG_INFO(QString("评测任务 %1 命中结果缓存：%2").arg(job.jobId).arg(cachedResult.verdict));
+            return cachedResult;
+        }
+    }
+
+    // 增量重测：与上次评测配置相同时，内容未变的测试点沿用上次结果
+    QSharedPointer<TestSetPack> previousPack;
+    if (pack && !artifactHash.isEmpty() && job.previousTestSet > 0 && job.previousConfig == caseConfig) {
+        previousPack = job.previousTestSet == packVersion
+            ? pack : testSetStore->open(job.homeworkId, job.previousTestSet);
+    }
+
+    QVector<CaseOutcome> outcomes(caseCount);
+    QList<int> pendingCases;
+    for (int i = 0; i < caseCount; ++i) {
+        QJsonObject previous = job.previousCases.at(i).toObject();
+        if (previousPack && i < previousPack->caseCount() && !previous.isEmpty()
+            && previous["verdict"].toString() != "SE"
+            && previousPack->caseHash(i) == pack->caseHash(i)) {
+            CaseOutcome &outcome = outcomes[i];
+            outcome.verdict = previous["verdict"].toString();
+            outcome.detail = previous["detail"].toString();
+            outcome.earned = previous["score"].toInt(outcome.verdict == "AC" ? 100 : 0) / 100.0;
+            outcome.run.cpuTimeMs = previous["timeMs"].toInt();
+            outcome.run.peakMemoryKb = previous["memoryKb"].toInt();
+            outcome.reused = true;
+        } else {
+            pendingCases.append(i);
+        }
+    }
+
+    auto runCase = [&](int i) {
+        CaseOutcome &outcome = outcomes[i];
+        QByteArray input;
+        QByteArray expected;
+        const char *expectedData = nullptr;
+        qint64 expectedSize = 0;
+        TestCaseView view;
+        if (pack && pack->view(i, &view)) {
+            // 直接使用映射内存：标准输出交给比较器按 64 位长度读取，输入与特判仍以 QByteArray 传递
+            if (view.inputSize > INT_MAX || (!checkerKey.isEmpty() && view.outputSize > INT_MAX)) {
+                outcome.verdict = "SE";
+                outcome.detail = "测试数据过大";
+                return;
+            }
+            input = QByteArray::fromRawData(view.input, int(view.inputSize));
+            if (!checkerKey.isEmpty()) {
+                expected = QByteArray::fromRawData(view.output, int(view.outputSize));
+            }
+        } else if (pack) {
+            if (!pack->readCase(i, &input, &expected)) {
+                outcome.verdict = "SE";
+                outcome.detail = "测试数据损坏";
+                return;
+            }
+        } else if (packVersion > 0) {
+            input = job.packCases[i].first;
+            expected = job.packCases[i].second;
+        } else {
+            QJsonObject testCase = testCases[i].toObject();
+            input = testCase["input"].toString().toUtf8();
+            expected = testCase["output"].toString().toUtf8();
+        }
+        if (view.output) {
+            expectedData = view.output;
+            expectedSize = view.outputSize;
+        } else {
+            expectedData = expected.constData();
+            expectedSize = expected.size();
+        }
+
+        // 输出边读边比较，发现不一致即终止进程，不保留完整输出；特判需要完整输出
+        OutputComparator comparator(checkMode, epsilon);
+        comparator.setExpected(expectedData, expectedSize);
+        OutputSink *sink = checkerKey.isEmpty() ? &comparator : nullptr;
+        // 有预派生进程时每个测试点只需一次 exec
+        outcome.run = zygotePool
+            ? zygotePool->execute(binaryPath, input, limits, workDir.path(), sink)
+            : Sandbox::run({binaryPath}, input, limits, workDir.path(), sink);
+
+        if (outcome.run.status != RunResult::Ok) {
+            outcome.verdict = Sandbox::statusName(outcome.run.status);
+        } else if (!checkerKey.isEmpty()) {
+            CheckResult checked = checkerPool->check(checkerKey, input, expected, outcome.run.output);
+            outcome.verdict = checked.verdict;
+            outcome.detail = checked.message;
+            outcome.earned = checked.score / 100.0;
+            outcome.run.output.clear();
+        } else {
+            outcome.verdict = caseVerdict(outcome.run, comparator);
+            outcome.earned = outcome.verdict == "AC" ? 1 : 0;
+            if (outcome.verdict == "WA") {
+                outcome.detail = QString("第 %1 行：%2").arg(comparator.expectedLine()).arg(comparator.message());
+            }
+        }
+    };
+
+    // 测试点互不依赖，交给共享线程池并行运行；线程池大小即同时运行的选手进程上限
+    if (casePool && pendingCases.size() > 1) {
+        QSemaphore done;
+        for (int i : pendingCases) {
+            casePool->start(new CaseTask([&runCase, i]() { runCase(i); }, &done));
+        }
+        done.acquire(pendingCases.size());
+    } else {
+        for (int i : pendingCases) {
+            runCase(i);
+        }
+    }
+
+    double earned = 0;
+    qint64 spawnUs = 0;
+    qint64 runMs = 0;
+    for (int i = 0; i < outcomes.size(); ++i) {
+        const CaseOutcome &outcome = outcomes[i];
+        spawnUs += outcome.run.spawnUs;
+        runMs += outcome.run.wallTimeMs;
+        earned += outcome.earned;
+        if (outcome.verdict != "AC" && result.verdict.isEmpty()) {
+            result.verdict = outcome.verdict;
+            result.message = QString("测试点 %1：%2").arg(i + 1).arg(outcome.verdict);
+        }
+
+        QJsonObject caseResult{
+            {"verdict", outcome.verdict},
+            {"score", qRound(outcome.earned * 100)},
+            {"timeMs", outcome.run.cpuTimeMs},
+            {"memoryKb", outcome.run.peakMemoryKb}
+        };
+        if (!outcome.detail.isEmpty()) {
+            caseResult["detail"] = outcome.detail;
+        }
+        if (outcome.reused) {
+            caseResult["reused"] = true;
+        }
+        result.cases.append(caseResult);
+    }
+
+    if (result.verdict.isEmpty()) {
+        result.verdict = "AC";
+        result.message = "全部测试点通过";
+    }
+    result.score = int(fullScore * earned / caseCount);
+    result.timing["spawnUs"] = spawnUs;
+    result.timing["runMs"] = runMs;
+    result.timing["reusedCases"] = caseCount - pendingCases.size();
+
+    // 评测系统自身出错的结果不缓存
+    if (!verdictKey.isEmpty() && result.verdict != "SE") {
+        verdictCache->store(job.homeworkId, testVersion, verdictKey, result);
+    }
+
+    LOG_INFO_KV("judge.timing", {
+        {"jobId", job.jobId},
+        {"verdict", result.verdict},
+        {"compileMs", compileMs},
+        {"compileCached", cached},
+        {"spawnUs", spawnUs},
+        {"runCases", pendingCases.size()},
+        {"reusedCases", caseCount - pendingCases.size()},
+        {"runMs", runMs}
+    });
+    return result;
+}
+
+bool Judger::compileAnswer(const JudgeJob &job, const QTemporaryDir &workDir,
+                           QString *binaryPath, JudgeResult *result) const
+{
+    const LanguageSpec *spec = findLanguage(job.language);
+    if (!spec) {
+        result->verdict = "CE";
+        result->score = 0;
+        result->message = QString("不支持的语言：%1").arg(job.language);
+        return false;
+    }
+
+    if (!workDir.isValid()) {
+        result->verdict = "SE";
+        result->message = "无法创建评测目录";
+        return false;
+    }
+
+    QFile source(workDir.filePath(spec->sourceFile));
+    if (!source.open(QIODevice::WriteOnly) || source.write(job.answer.toUtf8()) < 0) {
+        result->verdict = "SE";
+        result->message = "无法写入源代码";
+        return false;
+    }
+    source.close();
+
+    // 相同源码与工具链的产物直接取自缓存，跳过编译器
+    *binaryPath = workDir.filePath("main");
+    QByteArray cacheKey;
+    bool cached = false;
+    qint64 compileMs = 0;
+    // 查不到编译器版本时不使用缓存，以免取到其他工具链的产物
+    QString version = compileCache ? compilerVersion(spec->compileCommand.first()) : QString();
+    if (!version.isEmpty()) {
+        cacheKey = CompileCache::makeKey(job.answer.toUtf8(), spec->name, version, spec->compileCommand);
+        cached = compileCache->fetch(cacheKey, *binaryPath);
+    }
+
+    if (!cached) {
+        RunResult compiled = Sandbox::run(spec->compileCommand, QByteArray(), compileLimits(), workDir.path());
+        compileMs = compiled.wallTimeMs;
+        if (compiled.status != RunResult::Ok) {
+            result->verdict = compiled.status == RunResult::SystemError ? "SE" : "CE";
+            result->score = 0;
+            result->message = compiled.status == RunResult::SystemError
+                ? compiled.error
+                : QString::fromUtf8(compiled.errorOutput);
+            result->timing["compileMs"] = compileMs;
+            return false;
+        }
+        if (!cacheKey.isEmpty()) {
+            compileCache->store(cacheKey, *binaryPath, compileMs);
+        }
+    }
+    result->timing["compileMs"] = compileMs;
+    result->timing["compileCached"] = cached;
+    return true;
+}
+
+JudgeResult Judger::judgeSamples(const JudgeJob &job) const
+{
+    JudgeResult result;
+
+    QTemporaryDir workDir;
+    QString binaryPath;
+    if (!compileAnswer(job, workDir, &binaryPath, &result)) {
+        return result;
+    }
+
+    // 样例运行只为给学生即时反馈：限制收紧，保留输出供对照，不计分
+    ResourceLimits limits = sampleLimits(job.problem);
+    OutputComparator::Mode checkMode = OutputComparator::modeFromString(job.problem["checkMode"].toString());
+    double epsilon = job.problem["floatEpsilon"].toDouble(1e-6);
+    QJsonArray samples = job.problem["sampleCases"].toArray();
+    int passed = 0;
+    int compared = 0;
+
+    for (int i = 0; i < samples.size(); ++i) {
+        QJsonObject sample = samples[i].toObject();
+        QByteArray input = sample["input"].toString().toUtf8();
+        // 有标准输出时边读边比较，只保留返回给学生的前一段输出
+        QByteArray expected = sample["output"].toString().toUtf8();
+        OutputComparator comparator(checkMode, epsilon);
+        comparator.setExpected(expected.constData(), expected.size());
+        SampleSink sink(sample.contains("output") ? &comparator : nullptr);
+        RunResult run = zygotePool
+            ? zygotePool->execute(binaryPath, input, limits, workDir.path(), &sink)
+            : Sandbox::run({binaryPath}, input, limits, workDir.path(), &sink);
+        run.output = sink.kept;
+
+        QString verdict;
+        QString detail;
+        if (run.status != RunResult::Ok) {
+            verdict = Sandbox::statusName(run.status);
+        } else if (!sample.contains("output")) {
+            verdict = "OK";  // 自定义输入没有标准输出
+        } else {
+            verdict = caseVerdict(run, comparator);
+            if (verdict == "WA") {
+                detail = QString("第 %1 行：%2").arg(comparator.expectedLine()).arg(comparator.message());
+            }
+        }
+        if (sample.contains("output")) {
+            ++compared;
+            passed += verdict == "AC";
+        }
+        if (verdict != "AC" && verdict != "OK" && result.verdict.isEmpty()) {
+            result.verdict = verdict;
+            result.message = QString("样例 %1：%2").arg(i + 1).arg(verdict);
+        }
+
+        QJsonObject caseResult{
+            {"index", i},
+            {"verdict", verdict},
+            {"timeMs", run.cpuTimeMs},
+            {"memoryKb", run.peakMemoryKb},
+            {"output", QString::fromUtf8(run.output)},
+            {"errorOutput", QString::fromUtf8(run.errorOutput)}
+        };
+        if (!detail.isEmpty()) {
+            caseResult["detail"] = detail;
+        }
+        result.cases.append(caseResult);
+        if (caseCallback) {
+            caseCallback(job.jobId, i, caseResult);
+        }
+    }
+
+    if (result.verdict.isEmpty()) {
+        result.verdict = "AC";
+        result.message = QString("通过 %1/%2 个样例").arg(passed).arg(compared);
+    }
+    return result;
+}
+
+bool Judger::prepareChecker(const QJsonObject &problem, QByteArray *key, QString *error) const
+{
+    QJsonObject checker = problem["checker"].toObject();
+    if (checker.isEmpty()) {
+        return true;
+    }
+    if (!checkerPool) {
+        *error = "未启用特判程序";
+        return false;
+    }
+
+    const LanguageSpec *spec = findLanguage(checker["language"].toString("cpp"));
+    if (!spec) {
+        *error = "特判程序语言不受支持";
+        return false;
+    }
+    QByteArray source = checker["source"].toString().toUtf8();
+    *key = CompileCache::makeKey(source, spec->name, compilerVersion(spec->compileCommand.first()),
+                                 spec->compileCommand + QStringList("checker"));
+    if (checkerPool->contains(*key)) {
+        return true;
+    }
+
+    // 首次使用时编译并登记，之后所有提交共用常驻进程
+    QTemporaryDir buildDir;
+    QFile file(buildDir.filePath(spec->sourceFile));
+    if (!buildDir.isValid() || !file.open(QIODevice::WriteOnly) || file.write(source) < 0) {
+        *error = "无法写入特判程序源码";
+        return false;
+    }
+    file.close();
+
+    RunResult compiled = Sandbox::run(spec->compileCommand, QByteArray(), compileLimits(), buildDir.path());
+    if (compiled.status != RunResult::Ok) {
+        *error = QString("特判程序编译失败：%1").arg(QString::fromUtf8(compiled.errorOutput));
+        return false;
+    }
+    if (!checkerPool->install(*key, buildDir.filePath("main"))) {
+        *error = "无法登记特判程序";
+        return false;
+    }
+    return true;
+}
+
+QByteArray Judger::testSetVersion(int homeworkId, const QJsonObject &problem, const TestSetPack *pack)
+{
+    // 各作业的数据包版本号都从 1 开始，只凭版本号无法区分不同作业的测试数据，
+    // 因此同时计入作业ID与数据包内容的摘要
+    QJsonObject testSet{
+        {"homeworkId", homeworkId},
+        {"testCases", problem["testCases"]},
+        {"checkMode", problem["checkMode"]},
+        {"floatEpsilon", problem["floatEpsilon"]},
+        {"checker", problem["checker"]},
+        {"fullScore", problem["fullScore"]},
+        {"testSetVersion", problem["testSetVersion"]}
+    };
+    if (pack) {
+        testSet["packDigest"] = QString::fromLatin1(pack->contentDigest().toHex());
+    }
+    return QCryptographicHash::hash(QJsonDocument(testSet).toJson(QJsonDocument::Compact),
+                                    QCryptographicHash::Sha256).toHex();
+}
+
+QByteArray Judger::fileHash(const QString &path)
+{
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result().toHex();
+}
+
+QString Judger::compilerVersion(const QString &compiler)
+{
+    // 编译器版本参与缓存键，升级工具链后旧产物自然失效；每个编译器查询成功一次后不再查询
+    static QMutex mutex;
+    static QHash<QString, QString> versions;
+
+    {
+        QMutexLocker locker(&mutex);
+        auto it = versions.find(compiler);
+        if (it != versions.end()) {
+            return it.value();
+        }
+    }
+
+    // 查询在锁外进行，不让其他评测线程等待沙箱进程；首次并发查询可能重复运行，结果相同
+    RunResult run = Sandbox::run({compiler, "--version"}, QByteArray(), compileLimits(), QDir::tempPath());
+    QString version = QString::fromUtf8(run.output).section('\n', 0, 0).trimmed();
+    if (run.status != RunResult::Ok || version.isEmpty()) {
+        // 失败不缓存，下次再查
+        LOG_WARNING(QString("无法获取编译器 %1 的版本：%2").arg(compiler).arg(run.error));
+        return QString();
+    }
+
+    QMutexLocker locker(&mutex);
+    versions.insert(compiler, version);
+    return version;
+}
+
+ResourceLimits Judger::sampleLimits(const QJsonObject &problem)
+{
+    ResourceLimits limits = problemLimits(problem);
+    limits.cpuTimeMs = qMin<qint64>(limits.cpuTimeMs, 1000);
+    limits.wallTimeMs = limits.cpuTimeMs + 1000;
+    limits.memoryBytes = qMin<qint64>(limits.memoryBytes, 256LL << 20);
+    limits.outputBytes = 1LL << 20;
+    return limits;
+}
+
+ResourceLimits Judger::problemLimits(const QJsonObject &problem)
+{
+    ResourceLimits limits;
+    limits.cpuTimeMs = problem["timeLimitMs"].toInt(1000);
+    // 墙钟时限留出余量，防止 sleep 或阻塞读导致进程挂起
+    limits.wallTimeMs = limits.cpuTimeMs * 2 + 1000;
+    limits.memoryBytes = qint64(problem["memoryLimitMb"].toInt(256)) << 20;
+    limits.outputBytes = qint64(problem["outputLimitMb"].toInt(64)) << 20;
+    return limits;
+}
+
+QString Judger::caseVerdict(const RunResult &run, OutputComparator &comparator)
+{
+    if (run.status != RunResult::Ok) {
+        return Sandbox::statusName(run.status);
+    }
+    return comparator.finish() ? "AC" : "WA";
+}
@@ -0,0 +1,135 @@
+#ifndef JUDGER_H
+#define JUDGER_H
+
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QByteArray>
+#include <QVector>
+#include <QPair>
+#include <QMetaType>
+#include <functional>
+#include "sandbox.h"
+
+class CompileCache;
+class ZygotePool;
+class OutputComparator;
+class QThreadPool;
+class CheckerPool;
+class VerdictCache;
+class TestSetStore;
+class TestSetPack;
+class QTemporaryDir;
+
+// 评测任务：提交时从作业记录中截取的快照，评测线程只读
+struct JudgeJob
+{
+    // 调度优先级，数值小的先评测
+    enum Priority {
+        Sample = 0,   // 交互式样例运行
+        Live = 1,     // 学生正式提交
+        Rejudge = 2   // 教师发起的重测
+    };
+
+    qint64 jobId = 0;
+    Priority priority = Live;
+    qint64 deadlineMs = 0;  // 作业截止时间，0 表示无截止时间
+    int homeworkId = 0;
+    int submissionId = 0;
+    int studentId = 0;
+    QString language;
+    QString answer;
+    QJsonObject problem;  // 作业配置（不含 submissions）
+
+    // 增量重测：上次评测所用的测试数据版本、评测配置与各测试点结果
+    // 配置相同且测试点内容未变时直接沿用上次的结果
+    int previousTestSet = 0;
+    QString previousConfig;
+    QJsonArray previousCases;
+
+    // 远程评测节点没有数据包，由服务器把测试点（输入、输出）的原始字节内联进任务；
+    // 测试数据不一定是合法 UTF-8，传输时按 base64 编码
+    QVector<QPair<QByteArray, QByteArray>> packCases;
+
+    // 远程评测节点协议中的序列化形式
+    QJsonObject toJson() const;
+    static JudgeJob fromJson(const QJsonObject &object);
+};
+
+// 评测结果：由评测线程产生，回到主线程写回提交记录
+struct JudgeResult
+{
+    qint64 jobId = 0;
+    int homeworkId = 0;
+    int studentId = 0;
+    QString verdict;      // AC / WA / TLE / MLE / RE / OLE / CE / SE
+    QJsonValue score;     // 整数分数，无法给分时为 Null
+    QString message;
+    QJsonArray cases;     // 每个测试点的结果
+    QJsonObject timing;   // 编译、进程创建、运行各阶段耗时
+    qint64 judgeTimeMs = 0;
+    int testSetVersion = 0;  // 所用测试数据版本，内联测试点为 0
+    QString caseConfig;      // 可执行文件与判定配置的哈希，用于增量重测
+
+    QJsonObject toJson() const;
+    static JudgeResult fromJson(const QJsonObject &object);
+};
+
+Q_DECLARE_METATYPE(JudgeResult)
+
+// 判题逻辑，可被多个评测线程同时调用
+class Judger
+{
+public:
+    Judger();
+
+    // 在评测线程启动前设置，cache 由调用方持有
+    void setCompileCache(CompileCache *cache) { compileCache = cache; }
+    void setZygotePool(ZygotePool *pool) { zygotePool = pool; }
+    // 设置后同一提交的测试点在该线程池中并行运行，否则逐个运行
+    void setCasePool(QThreadPool *pool) { casePool = pool; }
+    void setCheckerPool(CheckerPool *pool) { checkerPool = pool; }
+    void setVerdictCache(VerdictCache *cache) { verdictCache = cache; }
+    void setTestSetStore(TestSetStore *store) { testSetStore = store; }
+    // 样例运行每完成一个样例回调一次（在评测线程中调用）
+    typedef std::function<void(qint64 jobId, int index, const QJsonObject &caseResult)> CaseCallback;
+    void setCaseCallback(const CaseCallback &callback) { caseCallback = callback; }
+
+    // 作业是否配置了自动评测所需的数据
+    static bool canJudge(const QJsonObject &problem);
+    static bool isSupportedLanguage(const QString &language);
+
+    JudgeResult judge(const JudgeJob &job) const;
+
+private:
+    JudgeResult judgeText(const JudgeJob &job) const;
+    JudgeResult judgeCode(const JudgeJob &job) const;
+    JudgeResult judgeSamples(const JudgeJob &job) const;
+    // 写入源码并编译（或取自编译缓存），失败时填好 result 并返回 false
+    bool compileAnswer(const JudgeJob &job, const QTemporaryDir &workDir,
+                       QString *binaryPath, JudgeResult *result) const;
+
+    // 作业配置了特判程序时确保其已编译登记，key 返回特判程序标识（无特判时为空）
+    bool prepareChecker(const QJsonObject &problem, QByteArray *key, QString *error) const;
+
+    // 测试数据版本：作业、测试点与判定方式的哈希，任何改动都会得到新版本
+    static QByteArray testSetVersion(int homeworkId, const QJsonObject &problem, const TestSetPack *pack);
+    static QByteArray fileHash(const QString &path);
+
+    static QString compilerVersion(const QString &compiler);
+    static ResourceLimits problemLimits(const QJsonObject &problem);
+    static ResourceLimits sampleLimits(const QJsonObject &problem);
+    static QString caseVerdict(const RunResult &run, OutputComparator &comparator);
+
+    CompileCache *compileCache;
+    ZygotePool *zygotePool;
+    QThreadPool *casePool;
+    CheckerPool *checkerPool;
+    VerdictCache *verdictCache;
+    TestSetStore *testSetStore;
+    CaseCallback caseCallback;
+};
+
+#endif // JUDGER_H
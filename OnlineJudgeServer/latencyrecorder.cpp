@@ -0,0 +1,70 @@
+#include "latencyrecorder.h"
+#include <algorithm>
+
+namespace {
+
+qint64 percentileOf(QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    int index = qBound(0, int(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted[index];
+}
+
+} // namespace
+
+LatencyRecorder::LatencyRecorder(int capacity)
+    : maxSamples(qMax(1, capacity))
+    , next(0)
+    , total(0)
+{
+    samples.reserve(maxSamples);
+}
+
+void LatencyRecorder::record(qint64 value)
+{
+    QMutexLocker locker(&mutex);
+    if (samples.size() < maxSamples) {
+        samples.append(value);
+    } else {
+        samples[next] = value;
+        next = (next + 1) % samples.size();
+    }
+    ++total;
+}
+
+qint64 LatencyRecorder::count()
+{
+    QMutexLocker locker(&mutex);
+    return total;
+}
+
+qint64 LatencyRecorder::percentile(double p)
+{
+    QVector<qint64> sorted;
+    {
+        QMutexLocker locker(&mutex);
+        sorted = samples;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return percentileOf(sorted, p);
+}
+
+QJsonObject LatencyRecorder::summary()
+{
+    QVector<qint64> sorted;
+    qint64 n;
+    {
+        QMutexLocker locker(&mutex);
+        sorted = samples;
+        n = total;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return QJsonObject{
+        {"count", n},
+        {"p50", percentileOf(sorted, 0.50)},
+        {"p99", percentileOf(sorted, 0.99)},
+        {"max", sorted.isEmpty() ? 0 : sorted.last()}
+    };
+}
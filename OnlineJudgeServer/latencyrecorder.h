@@ -0,0 +1,30 @@
+#ifndef LATENCYRECORDER_H
+#define LATENCYRECORDER_H
+
+#include <QVector>
+#include <QMutex>
+#include <QJsonObject>
+
+// 延迟采样：保留最近 capacity 个样本，查询时再排序求分位数
+// 记录端只做一次加锁写入，适合每个测试点、每个请求级别的频率
+class LatencyRecorder
+{
+public:
+    explicit LatencyRecorder(int capacity = 4096);
+
+    void record(qint64 value);
+    qint64 count();
+    qint64 percentile(double p);
+
+    // {"count", "p50", "p99", "max"}，单位与记录值一致
+    QJsonObject summary();
+
+private:
+    QVector<qint64> samples;
+    int maxSamples;
+    int next;
+    qint64 total;
+    QMutex mutex;
+};
+
+#endif // LATENCYRECORDER_H
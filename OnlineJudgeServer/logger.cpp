@@ -1,30 +1,208 @@
 #include "logger.h"
 #include <QDir>
 #include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <zlib.h>
+
+// 异步模式的后台写线程
+class LogWriter : public QThread
+{
+public:
+    explicit LogWriter(Logger *logger) : logger(logger) {}
+
+protected:
+    void run() override { logger->writerLoop(); }
+
+private:
+    Logger *logger;
+};
+
+namespace {
+
+void appendJsonString(QByteArray &out, const QString &text)
+{
+    out.append('"');
+    for (QChar ch : text) {
+        ushort c = ch.unicode();
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    out.append(QByteArray("\\u00") + QByteArray::number(c, 16).rightJustified(2, '0'));
+                } else {
+                    out.append(QString(ch).toUtf8());
+                }
+        }
+    }
+    out.append('"');
+}
+
+bool isNumeric(const QVariant &value)
+{
+    switch (int(value.type())) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Double:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void appendJsonValue(QByteArray &out, const QVariant &value)
+{
+    if (!value.isValid() || value.isNull()) {
+        out.append("null");
+    } else if (value.type() == QVariant::Bool) {
+        out.append(value.toBool() ? "true" : "false");
+    } else if (isNumeric(value)) {
+        out.append(value.toString().toUtf8());
+    } else {
+        appendJsonString(out, value.toString());
+    }
+}
+
+// 文本格式的字段值：含空白、引号或等号时加引号
+void appendTextValue(QByteArray &out, const QVariant &value)
+{
+    QString text = value.toString();
+    bool quote = text.isEmpty();
+    for (QChar ch : text) {
+        if (ch.isSpace() || ch == '"' || ch == '=') {
+            quote = true;
+            break;
+        }
+    }
+    if (quote) {
+        appendJsonString(out, text);
+    } else {
+        out.append(text.toUtf8());
+    }
+}
+
+// 把轮转出的日志压缩为 .gz 并删除原文件，再按保留总量删除最旧的归档
+// 在归档线程池中执行，不占用写线程
+class ArchiveTask : public QRunnable
+{
+public:
+    ArchiveTask(const QString &path, const QString &dir, const QString &base, qint64 retentionBytes)
+        : path(path), dir(dir), base(base), retentionBytes(retentionBytes) {}
+
+    void run() override
+    {
+        if (!path.isEmpty()) {
+            compress();
+        }
+        enforceRetention();
+    }
+
+private:
+    void compress()
+    {
+        QFile source(path);
+        if (!source.open(QIODevice::ReadOnly)) {
+            qWarning() << "无法读取待归档日志:" << path;
+            return;
+        }
+        // 先写临时文件，完成后再改名，中途退出不会留下残缺的 .gz
+        QString target = path + ".gz";
+        QString partial = target + ".part";
+        gzFile gz = gzopen(QFile::encodeName(partial).constData(), "wb6");
+        if (!gz) {
+            qWarning() << "无法创建日志归档:" << partial;
+            return;
+        }
+        bool ok = true;
+        while (ok && !source.atEnd()) {
+            QByteArray chunk = source.read(256 * 1024);
+            ok = !chunk.isEmpty() && gzwrite(gz, chunk.constData(), unsigned(chunk.size())) == chunk.size();
+        }
+        ok = gzclose(gz) == Z_OK && ok;
+        source.close();
+        if (!ok || !QFile::rename(partial, target)) {
+            qWarning() << "日志归档失败:" << path;
+            QFile::remove(partial);
+            return;
+        }
+        QFile::remove(path);
+    }
+
+    void enforceRetention()
+    {
+        if (retentionBytes <= 0) {
+            return;
+        }
+        // 按修改时间从旧到新
+        QFileInfoList archives = QDir(dir).entryInfoList(QStringList{base + "_*.log.gz"}, QDir::Files,
+                                                          QDir::Time | QDir::Reversed);
+        qint64 total = 0;
+        for (const QFileInfo &info : archives) {
+            total += info.size();
+        }
+        for (const QFileInfo &info : archives) {
+            if (total <= retentionBytes) {
+                break;
+            }
+            if (QFile::remove(info.absoluteFilePath())) {
+                total -= info.size();
+            }
+        }
+    }
+
+    QString path;
+    QString dir;
+    QString base;
+    qint64 retentionBytes;
+};
+
+} // namespace
 
 Logger* Logger::instance = nullptr;
+QAtomicInt Logger::enabledLevel(Logger::Debug);
 
 Logger::Logger(QObject *parent)
     : QObject(parent)
-    , currentLevel(Debug)
+    , logDir("logs")
+    , logBase("server")
+    , directoryOpened(false)
+    , activeBytes(0)
+    , maxFileBytes(64LL << 20)
+    , retentionBytes(1LL << 30)
+    , outputFormat(Text)
+    , ring(nullptr)
+    , ringMask(0)
+    , enqueuePos(0)
+    , dequeuePos(0)
+    , asyncEnabled(0)
+    , activeProducers(0)
+    , dropped(0)
+    , overflowPolicy(DropNewest)
+    , flushIntervalMs(100)
+    , flushBytes(64 * 1024)
+    , writer(nullptr)
+    , writerStopping(0)
 {
-    // 默认日志文件路径
-    QString logDir = "logs";
-    QDir().mkpath(logDir);
-    
-    QString logPath = QString("%1/server_%2.log")
-        .arg(logDir)
-        .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd"));
-    
-    setLogFile(logPath);
+    // 不在这里打开文件：进程可能随后改用其他目录或文件名，提前打开会写入并归档别人的日志
+    archivePool.setMaxThreadCount(1);
 }
 
 Logger::~Logger()
 {
+    stopAsync();
+    delete[] ring;
     if (logFile.isOpen()) {
-        logStream.flush();
         logFile.close();
     }
+    archivePool.waitForDone();
 }
 
 Logger* Logger::getInstance()
@@ -35,49 +213,435 @@ Logger* Logger::getInstance()
     return instance;
 }
 
-void Logger::setLogFile(const QString &filePath)
+void Logger::setLogDirectory(const QString &dir, const QString &baseName)
 {
     QMutexLocker locker(&mutex);
-    
+
+    logDir = dir;
+    logBase = baseName;
+    openDirectory();
+}
+
+void Logger::openDirectory()
+{
+    directoryOpened = true;
+    QDir().mkpath(logDir);
+    openActive(QDate::currentDate());
+
+    // 上次运行中已轮转但未压缩完的日志（不含今天正在写的文件）
+    QFileInfoList leftovers = QDir(logDir).entryInfoList(QStringList{logBase + "_*.*.log"}, QDir::Files);
+    for (const QFileInfo &info : leftovers) {
+        archive(info.absoluteFilePath());
+    }
+}
+
+void Logger::setRotation(qint64 maxFile, qint64 retention)
+{
+    QMutexLocker locker(&mutex);
+    maxFileBytes = qMax<qint64>(0, maxFile);
+    retentionBytes = qMax<qint64>(0, retention);
+}
+
+QString Logger::activePath(const QDate &day) const
+{
+    return QString("%1/%2_%3.log").arg(logDir, logBase, day.toString("yyyy-MM-dd"));
+}
+
+void Logger::openActive(const QDate &day)
+{
     if (logFile.isOpen()) {
-        logStream.flush();
         logFile.close();
     }
-    
-    logFile.setFileName(filePath);
+
+    // 重启后继续追加到当天的文件
+    activeDay = day;
+    logFile.setFileName(activePath(day));
     if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        qDebug() << "无法打开日志文件:" << filePath;
+        qDebug() << "无法打开日志文件:" << logFile.fileName();
+    }
+    activeBytes = logFile.size();
+}
+
+void Logger::rotateIfNeeded(qint64 incomingBytes)
+{
+    // 未调用 setLogDirectory 时在第一次写入时按默认目录打开
+    if (!directoryOpened) {
+        openDirectory();
+    }
+
+    QDate today = QDate::currentDate();
+    bool full = maxFileBytes > 0 && activeBytes > 0 && activeBytes + incomingBytes > maxFileBytes;
+    if (today == activeDay && !full) {
+        return;
+    }
+
+    if (activeBytes == 0) {
+        openActive(today);
         return;
     }
-    
-    logStream.setDevice(&logFile);
+
+    // 当前文件改名为下一个空闲序号，再打开新文件；压缩交给归档线程
+    QString current = activePath(activeDay);
+    QString stem = current.left(current.size() - 4);
+    QString rotated;
+    for (int index = 1; ; ++index) {
+        rotated = QString("%1.%2.log").arg(stem).arg(index);
+        if (!QFile::exists(rotated) && !QFile::exists(rotated + ".gz")) {
+            break;
+        }
+    }
+    logFile.close();
+    if (QFile::rename(current, rotated)) {
+        archive(rotated);
+    } else {
+        qDebug() << "日志轮转失败，继续写入原文件:" << current;
+    }
+    openActive(today);
+}
+
+void Logger::archive(const QString &path)
+{
+    archivePool.start(new ArchiveTask(path, logDir, logBase, retentionBytes));
 }
 
 void Logger::setLogLevel(LogLevel level)
 {
-    currentLevel = level;
+    enabledLevel.storeRelease(level);
+}
+
+void Logger::setOutputFormat(OutputFormat format)
+{
+    // 须在启动异步模式前设置
+    outputFormat = format;
+}
+
+void Logger::startAsync(int capacity, OverflowPolicy policy, int flushInterval, int flushSize)
+{
+    if (asyncEnabled.loadAcquire()) {
+        return;
+    }
+
+    quint64 size = 64;
+    while (size < quint64(qMax(capacity, 64))) {
+        size <<= 1;
+    }
+    delete[] ring;
+    ring = new Record[size];
+    for (quint64 i = 0; i < size; ++i) {
+        ring[i].sequence.storeRelease(i);
+    }
+    ringMask = size - 1;
+    enqueuePos.storeRelease(0);
+    dequeuePos.storeRelease(0);
+    overflowPolicy = policy;
+    flushIntervalMs = qMax(1, flushInterval);
+    flushBytes = qMax(4096, flushSize);
+
+    writerStopping.storeRelease(0);
+    writer = new LogWriter(this);
+    writer->start();
+    asyncEnabled.storeRelease(1);
+}
+
+void Logger::stopAsync()
+{
+    if (!asyncEnabled.fetchAndStoreOrdered(0)) {
+        return;
+    }
+    writerStopping.storeRelease(1);
+    wakeWriter();
+    writer->wait();
+    delete writer;
+    writer = nullptr;
+
+    // 切换期间仍在入队的日志由当前线程补写：开关清除前已登记的生产者（见 enterAsync）
+    // 全部离开、且已占位的槽位都已发布并取出后，环形队列才不会再被使用
+    QByteArray rest;
+    StampCache cache;
+    bool urgent = false;
+    while (true) {
+        drain(rest, cache, &urgent);
+        if (activeProducers.fetchAndAddOrdered(0) == 0
+            && dequeuePos.loadAcquire() == enqueuePos.loadAcquire()) {
+            break;
+        }
+        QThread::yieldCurrentThread();
+    }
+    if (!rest.isEmpty()) {
+        writeBatch(rest);
+    }
+}
+
+QJsonObject Logger::stats()
+{
+    bool async = asyncEnabled.loadAcquire() != 0;
+    // 先读出队位置：出队位置不会超过入队位置，两次读之间的变化只会让积压偏大
+    quint64 dequeued = dequeuePos.loadAcquire();
+    quint64 enqueued = enqueuePos.loadAcquire();
+    return QJsonObject{
+        {"async", async},
+        {"queued", async ? qint64(enqueued - dequeued) : 0},
+        {"capacity", async ? qint64(ringMask + 1) : 0},
+        {"dropped", qint64(dropped.loadAcquire())},
+        {"archiving", archivePool.activeThreadCount()}
+    };
 }
 
 void Logger::log(LogLevel level, const QString &message)
 {
-    if (!shouldLog(level)) {
+    if (!isEnabled(level)) {
         return;
     }
-    
+    Entry entry;
+    entry.level = level;
+    entry.message = message;
+    write(entry);
+}
+
+void Logger::logFields(LogLevel level, const char *event, std::initializer_list<LogField> fields)
+{
+    if (!isEnabled(level)) {
+        return;
+    }
+    Entry entry;
+    entry.level = level;
+    entry.event = event;
+    entry.fields = QVector<LogField>(fields);
+    write(entry);
+}
+
+void Logger::write(Entry &entry)
+{
+    entry.timeMs = QDateTime::currentMSecsSinceEpoch();
+    if (entry.level < Fatal && enterAsync()) {
+        push(entry);
+        activeProducers.fetchAndAddOrdered(-1);
+        return;
+    }
+    if (entry.level >= Fatal) {
+        // 致命错误后进程随即退出，先排空队列再同步写入
+        stopAsync();
+    }
+    writeSync(entry);
+}
+
+bool Logger::enterAsync()
+{
+    if (!asyncEnabled.loadAcquire()) {
+        return false;
+    }
+    // 先登记再复查开关：stopAsync 清除开关后会等已登记的生产者离开，
+    // 复查时仍看到开关打开的生产者必然被它等到，看到关闭的改为同步写入
+    activeProducers.fetchAndAddOrdered(1);
+    if (asyncEnabled.fetchAndAddOrdered(0)) {
+        return true;
+    }
+    activeProducers.fetchAndAddOrdered(-1);
+    return false;
+}
+
+void Logger::wakeWriter()
+{
+    // 在 wakeMutex 下通知，与写线程的复查与等待互斥，通知不会落在复查和等待之间
+    QMutexLocker locker(&wakeMutex);
+    wakeCondition.wakeOne();
+}
+
+void Logger::writeSync(const Entry &entry)
+{
     QMutexLocker locker(&mutex);
-    
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    QString logEntry = QString("[%1] [%2] %3\n")
-        .arg(timestamp)
-        .arg(levelToString(level))
-        .arg(message);
-    
-    logStream << logEntry;
-    logStream.flush();
-    
+
+    QByteArray line;
+    StampCache cache;
+    appendEntry(line, cache, entry);
+    rotateIfNeeded(line.size());
+    logFile.write(line);
+    logFile.flush();
+    activeBytes += line.size();
+
     // 同时输出到控制台
-    if (level >= Warning) {
-        qDebug().noquote() << logEntry.trimmed();
+    if (entry.level >= Warning) {
+        qDebug().noquote() << QString::fromUtf8(line).trimmed();
+    }
+}
+
+bool Logger::push(Entry &entry)
+{
+    const quint64 capacity = ringMask + 1;
+    bool mustKeep = entry.level >= Error || overflowPolicy == Block;
+    quint64 pos = enqueuePos.loadAcquire();
+    Record *record;
+    while (true) {
+        record = &ring[pos & ringMask];
+        qint64 diff = qint64(record->sequence.loadAcquire()) - qint64(pos);
+        if (diff == 0) {
+            if (enqueuePos.testAndSetRelaxed(pos, pos + 1, pos)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 队列已满
+            if (!mustKeep) {
+                dropped.fetchAndAddRelaxed(1);
+                return false;
+            }
+            // 异步已停止时写线程不会再腾出空位，改为同步写入
+            if (!asyncEnabled.loadAcquire()) {
+                writeSync(entry);
+                return true;
+            }
+            wakeWriter();
+            QThread::yieldCurrentThread();
+            pos = enqueuePos.loadAcquire();
+        } else {
+            pos = enqueuePos.loadAcquire();
+        }
+    }
+
+    LogLevel level = entry.level;
+    record->entry.timeMs = entry.timeMs;
+    record->entry.level = level;
+    record->entry.message.swap(entry.message);
+    record->entry.event = entry.event;
+    record->entry.fields.swap(entry.fields);
+    record->sequence.storeRelease(pos + 1);
+
+    // 平时由写线程按时间间隔醒来；队列过半或有错误日志时立即唤醒
+    if (level >= Error || pos + 1 - dequeuePos.loadAcquire() >= capacity / 2) {
+        wakeWriter();
+    }
+    return true;
+}
+
+int Logger::drain(QByteArray &out, StampCache &cache, bool *urgent)
+{
+    int count = 0;
+    quint64 pos = dequeuePos.loadAcquire();
+    while (true) {
+        Record &record = ring[pos & ringMask];
+        if (record.sequence.loadAcquire() != pos + 1) {
+            break;
+        }
+        int start = out.size();
+        appendEntry(out, cache, record.entry);
+        if (record.entry.level >= Warning) {
+            qDebug().noquote() << QString::fromUtf8(out.constData() + start, out.size() - start - 1);
+        }
+        *urgent = *urgent || record.entry.level >= Error;
+        record.entry.message = QString();
+        record.entry.fields.clear();
+        record.sequence.storeRelease(pos + ringMask + 1);
+        ++pos;
+        dequeuePos.storeRelease(pos);
+        ++count;
+    }
+    return count;
+}
+
+void Logger::appendEntry(QByteArray &out, StampCache &cache, const Entry &entry) const
+{
+    qint64 second = entry.timeMs / 1000;
+    if (second != cache.second) {
+        cache.second = second;
+        cache.text = QDateTime::fromMSecsSinceEpoch(second * 1000)
+            .toString("yyyy-MM-dd hh:mm:ss").toLatin1();
+    }
+    int millis = int(entry.timeMs % 1000);
+    char ms[4] = {'.', char('0' + millis / 100), char('0' + millis / 10 % 10), char('0' + millis % 10)};
+
+    if (outputFormat == NdJson) {
+        out.append("{\"ts\":\"");
+        out.append(cache.text);
+        out.append(ms, 4);
+        out.append("\",\"level\":\"");
+        out.append(levelToString(entry.level).toLatin1());
+        out.append('"');
+        if (entry.event) {
+            out.append(",\"event\":");
+            appendJsonString(out, QString::fromUtf8(entry.event));
+            for (const LogField &field : entry.fields) {
+                out.append(',');
+                appendJsonString(out, QString::fromUtf8(field.key));
+                out.append(':');
+                appendJsonValue(out, field.value);
+            }
+        } else {
+            out.append(",\"msg\":");
+            appendJsonString(out, entry.message);
+        }
+        out.append("}\n");
+        return;
+    }
+
+    out.append('[');
+    out.append(cache.text);
+    out.append(ms, 4);
+    out.append("] [");
+    out.append(levelToString(entry.level).toLatin1());
+    out.append("] ");
+    if (entry.event) {
+        out.append(entry.event);
+        for (const LogField &field : entry.fields) {
+            out.append(' ');
+            out.append(field.key);
+            out.append('=');
+            appendTextValue(out, field.value);
+        }
+    } else {
+        out.append(entry.message.toUtf8());
+    }
+    out.append('\n');
+}
+
+void Logger::writeBatch(const QByteArray &batch)
+{
+    // 异步模式下轮转只发生在写线程，调用方不受影响
+    QMutexLocker locker(&mutex);
+    rotateIfNeeded(batch.size());
+    logFile.write(batch);
+    logFile.flush();
+    activeBytes += batch.size();
+}
+
+void Logger::writerLoop()
+{
+    QByteArray batch;
+    batch.reserve(flushBytes * 2);
+    StampCache cache;
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+
+    while (true) {
+        bool stopping = writerStopping.loadAcquire();
+        bool urgent = false;
+        int count = drain(batch, cache, &urgent);
+
+        qint64 lost = dropped.fetchAndStoreRelaxed(0);
+        if (lost > 0) {
+            Entry entry;
+            entry.timeMs = QDateTime::currentMSecsSinceEpoch();
+            entry.level = Warning;
+            entry.event = "log.dropped";
+            entry.fields.append(LogField{"count", lost});
+            appendEntry(batch, cache, entry);
+        }
+
+        if (!batch.isEmpty() && (urgent || stopping || batch.size() >= flushBytes
+                                 || sinceFlush.elapsed() >= flushIntervalMs)) {
+            writeBatch(batch);
+            batch.resize(0);  // 保留已分配的缓冲
+            sinceFlush.restart();
+        }
+        if (stopping && count == 0) {
+            break;
+        }
+        if (count == 0) {
+            // 持锁复查：生产者发布后在 wakeMutex 下通知，复查之后发布的记录一定能唤醒这里
+            QMutexLocker locker(&wakeMutex);
+            quint64 next = dequeuePos.loadAcquire();
+            if (!writerStopping.loadAcquire() && ring[next & ringMask].sequence.loadAcquire() != next + 1) {
+                wakeCondition.wait(&wakeMutex, flushIntervalMs);
+            }
+        }
     }
 }
 
@@ -92,8 +656,3 @@ QString Logger::levelToString(LogLevel level)
         default: return "UNKNOWN";
     }
 }
-
-bool Logger::shouldLog(LogLevel level)
-{
-    return level >= currentLevel;
-} 
\ No newline at end of file
@@ -3,9 +3,31 @@
 
 #include <QObject>
 #include <QFile>
-#include <QTextStream>
 #include <QDateTime>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QVariant>
+#include <QVector>
+#include <QDate>
+#include <QThreadPool>
+#include <QJsonObject>
+#include <initializer_list>
+
+// 编译期最低日志级别（0=Debug … 4=Fatal），低于此级别的日志语句整体被编译器消除
+// 例如发布构建在 .pro 中加入 DEFINES += LOG_MIN_LEVEL=1
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+class LogWriter;
+
+// 结构化日志的一个字段；key 须为字符串字面量（只保存指针）
+struct LogField
+{
+    const char *key;
+    QVariant value;
+};
 
 class Logger : public QObject
 {
@@ -19,30 +41,151 @@ public:
         Fatal
     };
 
+    // 异步模式下队列已满时的处理方式；Error 及以上级别总是等待，不会丢弃
+    enum OverflowPolicy {
+        DropNewest,  // 丢弃新日志并计数，写线程随后补记一条丢弃条数
+        Block        // 等待写线程腾出空间
+    };
+
+    // 输出格式
+    enum OutputFormat {
+        Text,   // [时间] [级别] 内容；结构化字段写作 key=value
+        NdJson  // 每行一个 JSON 对象：ts、level、msg 或 event 及各字段
+    };
+
     static Logger* getInstance();
     void log(LogLevel level, const QString &message);
-    void setLogFile(const QString &filePath);
+    // 结构化日志：字段原样入队，格式化推迟到写盘时进行
+    void logFields(LogLevel level, const char *event, std::initializer_list<LogField> fields);
+    // 日志写入 <dir>/<baseName>_<日期>.log；跨天或超过单文件上限时轮转，
+    // 旧文件改名为 <baseName>_<日期>.<序号>.log，在后台压缩为 .gz
+    // 须在第一条日志之前调用；未调用时第一次写入打开 logs/server_<日期>.log
+    void setLogDirectory(const QString &dir, const QString &baseName = "server");
+    // maxFileBytes 为单文件上限（0 表示只按天轮转）；retentionBytes 为压缩归档总量上限，超出时删除最旧的
+    void setRotation(qint64 maxFileBytes, qint64 retentionBytes);
     void setLogLevel(LogLevel level);
+    void setOutputFormat(OutputFormat format);
+
+    // 日志宏先调用此函数，被过滤的级别只付出一次原子读
+    static bool isEnabled(LogLevel level)
+    {
+        return int(level) >= enabledLevel.loadAcquire();
+    }
+
+    // 切换为异步写入：调用方只把日志放入预分配的无锁环形队列（多生产者单消费者），
+    // 由后台线程格式化并批量写盘；攒够 flushBytes 或距上次写盘超过 flushIntervalMs 时写盘
+    // capacity 向上取 2 的幂
+    void startAsync(int capacity = 8192, OverflowPolicy policy = DropNewest,
+                    int flushIntervalMs = 100, int flushBytes = 64 * 1024);
+    // 排空队列并切回同步写入，进程退出前调用
+    void stopAsync();
+    // 写入队列积压情况；不获取日志锁，不影响正在写日志的线程
+    QJsonObject stats();
 
 private:
+    friend class LogWriter;
+
+    // 一条待写日志；event 非空时为结构化日志
+    struct Entry
+    {
+        qint64 timeMs = 0;
+        LogLevel level = Info;
+        QString message;
+        const char *event = nullptr;
+        QVector<LogField> fields;
+    };
+
+    // 环形队列的一个槽位，sequence 标记槽位当前可写还是可读
+    struct Record
+    {
+        QAtomicInteger<quint64> sequence;
+        Entry entry;
+    };
+
+    // 时间戳前缀按秒缓存，写线程与同步写入各用一份
+    struct StampCache
+    {
+        qint64 second = -1;
+        QByteArray text;
+    };
+
     explicit Logger(QObject *parent = nullptr);
     ~Logger();
-    
+
     static Logger* instance;
+    static QAtomicInt enabledLevel;
     QFile logFile;
-    QTextStream logStream;
-    LogLevel currentLevel;
-    QMutex mutex;
-    
-    QString levelToString(LogLevel level);
-    bool shouldLog(LogLevel level);
+    QMutex mutex;  // 保护日志文件与轮转状态
+    QString logDir;
+    QString logBase;
+    bool directoryOpened;  // 已按 logDir/logBase 打开文件并处理过遗留的轮转文件
+    QDate activeDay;
+    qint64 activeBytes;
+    qint64 maxFileBytes;
+    qint64 retentionBytes;
+    QThreadPool archivePool;  // 单线程压缩归档
+    OutputFormat outputFormat;
+
+    static QString levelToString(LogLevel level);
+
+    void write(Entry &entry);
+    void writeSync(const Entry &entry);
+    bool push(Entry &entry);
+    bool enterAsync();
+    void wakeWriter();
+    // 写线程：取出所有就绪的日志追加到 out，返回条数
+    int drain(QByteArray &out, StampCache &cache, bool *urgent);
+    void appendEntry(QByteArray &out, StampCache &cache, const Entry &entry) const;
+    void writeBatch(const QByteArray &batch);
+    void writerLoop();
+
+    // 以下在持有 mutex 时调用
+    void openDirectory();
+    QString activePath(const QDate &day) const;
+    void openActive(const QDate &day);
+    void rotateIfNeeded(qint64 incomingBytes);
+    void archive(const QString &path);
+
+    Record *ring;
+    quint64 ringMask;
+    QAtomicInteger<quint64> enqueuePos;
+    QAtomicInteger<quint64> dequeuePos;
+    QAtomicInt asyncEnabled;
+    QAtomicInt activeProducers;  // 已通过 enterAsync、尚未写完的生产者数
+    QAtomicInteger<qint64> dropped;
+    OverflowPolicy overflowPolicy;
+    int flushIntervalMs;
+    int flushBytes;
+
+    LogWriter *writer;
+    QAtomicInt writerStopping;
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;
 };
 
-// 定义宏以方便使用
-#define LOG_DEBUG(msg) Logger::getInstance()->log(Logger::Debug, msg)
-#define LOG_INFO(msg) Logger::getInstance()->log(Logger::Info, msg)
-#define LOG_WARNING(msg) Logger::getInstance()->log(Logger::Warning, msg)
-#define LOG_ERROR(msg) Logger::getInstance()->log(Logger::Error, msg)
-#define LOG_FATAL(msg) Logger::getInstance()->log(Logger::Fatal, msg)
+// 定义宏以方便使用；参数只在级别启用时才求值
+#define LOG_AT(level, msg) \
+    do { \
+        if (int(level) >= LOG_MIN_LEVEL && Logger::isEnabled(level)) \
+            Logger::getInstance()->log(level, msg); \
+    } while (0)
+
+#define LOG_DEBUG(msg) LOG_AT(Logger::Debug, msg)
+#define LOG_INFO(msg) LOG_AT(Logger::Info, msg)
+#define LOG_WARNING(msg) LOG_AT(Logger::Warning, msg)
+#define LOG_ERROR(msg) LOG_AT(Logger::Error, msg)
+#define LOG_FATAL(msg) LOG_AT(Logger::Fatal, msg)
+
+// 结构化日志：LOG_INFO_KV("http.request", {{"method", method}, {"path", path}})
+#define LOG_KV_AT(level, event, ...) \
+    do { \
+        if (int(level) >= LOG_MIN_LEVEL && Logger::isEnabled(level)) \
+            Logger::getInstance()->logFields(level, event, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG_KV(event, ...) LOG_KV_AT(Logger::Debug, event, __VA_ARGS__)
+#define LOG_INFO_KV(event, ...) LOG_KV_AT(Logger::Info, event, __VA_ARGS__)
+#define LOG_WARNING_KV(event, ...) LOG_KV_AT(Logger::Warning, event, __VA_ARGS__)
+#define LOG_ERROR_KV(event, ...) LOG_KV_AT(Logger::Error, event, __VA_ARGS__)
 
-#endif // LOGGER_H 
\ No newline at end of file
+#endif // LOGGER_H
@@ -1,6 +1,53 @@
 #include <QCoreApplication>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
 #include "server.h"
 #include "logger.h"
+#include "tracer.h"
+#include "sandbox.h"
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// 信号处理函数中只能做异步信号安全的操作：写一个字节，由事件循环读到后再退出
+int quitSignalFds[2] = {-1, -1};
+
+void handleQuitSignal(int)
+{
+    char byte = 1;
+    ssize_t ignored = ::write(quitSignalFds[0], &byte, 1);
+    Q_UNUSED(ignored);
+}
+
+// SIGTERM / SIGINT 时退出事件循环，使 main 中的收尾代码得以执行
+bool installQuitSignals(QCoreApplication *app)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, quitSignalFds) != 0) {
+        return false;
+    }
+    QSocketNotifier *notifier = new QSocketNotifier(quitSignalFds[1], QSocketNotifier::Read, app);
+    QObject::connect(notifier, &QSocketNotifier::activated, app, [notifier]() {
+        notifier->setEnabled(false);
+        char byte;
+        ssize_t ignored = ::read(quitSignalFds[1], &byte, 1);
+        Q_UNUSED(ignored);
+        LOG_INFO("收到退出信号，正在停止服务器");
+        QCoreApplication::quit();
+    });
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handleQuitSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    return sigaction(SIGTERM, &sa, nullptr) == 0 && sigaction(SIGINT, &sa, nullptr) == 0;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
@@ -8,13 +55,47 @@ int main(int argc, char *argv[])
     
     // 初始化日志系统
     Logger::getInstance()->setLogLevel(Logger::Info);
+    // OJ_LOG_FORMAT=ndjson 时每行输出一个 JSON 对象，便于日志系统直接采集
+    if (qgetenv("OJ_LOG_FORMAT") == "ndjson") {
+        Logger::getInstance()->setOutputFormat(Logger::NdJson);
+    }
+    // 单文件超过 OJ_LOG_MAX_MB（默认 64）或跨天时轮转，归档总量不超过 OJ_LOG_RETENTION_MB（默认 1024）
+    qint64 maxLogMb = qEnvironmentVariableIsSet("OJ_LOG_MAX_MB") ? qgetenv("OJ_LOG_MAX_MB").toLongLong() : 64;
+    qint64 retentionMb = qEnvironmentVariableIsSet("OJ_LOG_RETENTION_MB") ? qgetenv("OJ_LOG_RETENTION_MB").toLongLong() : 1024;
+    Logger::getInstance()->setRotation(maxLogMb << 20, retentionMb << 20);
+    // OJ_TRACE_SAMPLE=N 时每 N 个请求记录一次各阶段耗时，写到 traces/ 下供 chrome://tracing 查看
+    Tracer::instance()->setSampling(qgetenv("OJ_TRACE_SAMPLE").toInt());
+    // 请求路径上只入队，由后台线程批量写盘
+    Logger::getInstance()->startAsync();
     LOG_INFO("服务器程序启动");
     
+    // 评测进程提前退出时写 stdin 会触发 SIGPIPE，由调用方按 EPIPE 处理
+    signal(SIGPIPE, SIG_IGN);
+    if (!installQuitSignals(&a)) {
+        LOG_WARNING("无法安装退出信号处理，进程被终止时可能丢失未写出的日志与追踪");
+    }
+    
+    // 管理员预先创建并委派 cgroup 目录时，评测进程改用 cgroup v2 限制内存与进程数
+    QString cgroupRoot = "/sys/fs/cgroup/onlinejudge";
+    if (QFile::exists(cgroupRoot)) {
+        Sandbox::setCgroupRoot(cgroupRoot);
+    }
+    
+    // 端口默认 8080，可用 OJ_PORT 指定（负载测试等在同一台机器上另起实例时使用）
+    quint16 port = qEnvironmentVariableIsSet("OJ_PORT") ? quint16(qgetenv("OJ_PORT").toUInt()) : 8080;
     Server server;
-    if (!server.start()) {
+    if (!server.start(port)) {
         LOG_FATAL("服务器启动失败！");
         return -1;
     }
     
-    return a.exec();
+    // 采样稀疏或请求停止后，已记录的追踪也按时写出
+    QTimer traceFlushTimer;
+    QObject::connect(&traceFlushTimer, &QTimer::timeout, []() { Tracer::instance()->flushStale(); });
+    traceFlushTimer.start(Tracer::flushIntervalMs());
+    
+    int ret = a.exec();
+    Tracer::instance()->stop();
+    Logger::getInstance()->stopAsync();
+    return ret;
 } 
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "metrics.h"
+#include <QtAlgorithms>
+#include "logger.h"
+
+namespace {
+
+// 导出时的 le 边界（微秒）；HDR 桶按桶内最大值归入
+const qint64 kExportBoundsUs[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+const qint64 kMaxValueUs = (qint64(1) << 41) - 1;
+
+QByteArray seconds(qint64 us)
+{
+    return QByteArray::number(double(us) / 1e6, 'g', 9);
+}
+
+QByteArray withLabel(const QByteArray &labels, const QByteArray &extra)
+{
+    if (labels.isEmpty()) {
+        return "{" + extra + "}";
+    }
+    return "{" + labels + "," + extra + "}";
+}
+
+QByteArray braced(const QByteArray &labels)
+{
+    return labels.isEmpty() ? QByteArray() : "{" + labels + "}";
+}
+
+} // namespace
+
+// 线程退出时把分片交回注册表
+struct ShardHandle
+{
+    Metrics::Shard *shard = nullptr;
+    ~ShardHandle()
+    {
+        if (shard) {
+            Metrics::instance()->releaseShard(shard);
+        }
+    }
+};
+
+namespace {
+thread_local ShardHandle localHandle;
+}
+
+Metrics *Metrics::instance()
+{
+    // 不析构：其他线程退出时仍可能访问
+    static Metrics *metrics = new Metrics();
+    return metrics;
+}
+
+Metrics::Metrics()
+{
+    slotCount[Counter] = 0;
+    slotCount[Gauge] = 0;
+    slotCount[Histogram] = 0;
+}
+
+int Metrics::counter(const char *name, const char *help, const QString &labels)
+{
+    return registerSeries(Counter, name, help, labels);
+}
+
+int Metrics::gauge(const char *name, const char *help, const QString &labels)
+{
+    return registerSeries(Gauge, name, help, labels);
+}
+
+int Metrics::histogram(const char *name, const char *help, const QString &labels)
+{
+    return registerSeries(Histogram, name, help, labels);
+}
+
+int Metrics::registerSeries(Kind kind, const char *name, const char *help, const QString &labels)
+{
+    QByteArray labelBytes = labels.toUtf8();
+    QByteArray key = QByteArray(name) + "{" + labelBytes + "}";
+
+    QMutexLocker locker(&mutex);
+    auto found = seriesIndex.constFind(key);
+    if (found != seriesIndex.constEnd()) {
+        return seriesList[found.value()].slot;
+    }
+
+    int familyId = familyIndex.value(name, -1);
+    if (familyId < 0) {
+        familyId = families.size();
+        families.append(Family{name, help, kind, {}});
+        familyIndex.insert(name, familyId);
+    } else if (families[familyId].kind != kind) {
+        LOG_ERROR(QString("指标 %1 重复注册为不同类型").arg(name));
+        return -1;
+    }
+
+    const int limits[] = {kMaxCounters, kMaxGauges, kMaxHistograms};
+    if (slotCount[kind] >= limits[kind]) {
+        LOG_WARNING(QString("指标数量已达上限，忽略 %1").arg(QString::fromUtf8(key)));
+        return -1;
+    }
+
+    int slot = slotCount[kind]++;
+    families[familyId].series.append(seriesList.size());
+    seriesIndex.insert(key, seriesList.size());
+    seriesList.append(Series{labelBytes, slot});
+    return slot;
+}
+
+Metrics::Shard *Metrics::localShard()
+{
+    if (!localHandle.shard) {
+        QMutexLocker locker(&mutex);
+        if (!freeShards.isEmpty()) {
+            localHandle.shard = freeShards.takeLast();
+        } else {
+            localHandle.shard = new Shard;
+            shards.append(localHandle.shard);
+        }
+    }
+    return localHandle.shard;
+}
+
+void Metrics::releaseShard(Shard *shard)
+{
+    QMutexLocker locker(&mutex);
+    freeShards.append(shard);
+}
+
+void Metrics::add(int counterId, qint64 delta)
+{
+    if (counterId < 0) {
+        return;
+    }
+    // 只有本线程写这个分片，读改写无需原子指令
+    QAtomicInteger<quint64> &value = localShard()->counters[counterId];
+    value.storeRelease(value.loadAcquire() + quint64(delta));
+}
+
+void Metrics::set(int gaugeId, qint64 value)
+{
+    if (gaugeId >= 0) {
+        gauges[gaugeId].storeRelease(value);
+    }
+}
+
+void Metrics::observe(int histogramId, qint64 valueUs)
+{
+    if (histogramId < 0) {
+        return;
+    }
+    Shard *shard = localShard();
+    HistogramShard *histogram = shard->histograms[histogramId].loadAcquire();
+    if (!histogram) {
+        histogram = new HistogramShard;
+        shard->histograms[histogramId].storeRelease(histogram);
+    }
+    valueUs = qBound<qint64>(0, valueUs, kMaxValueUs);
+    QAtomicInteger<quint64> &bucket = histogram->buckets[bucketOf(valueUs)];
+    bucket.storeRelease(bucket.loadAcquire() + 1);
+    histogram->sumUs.storeRelease(histogram->sumUs.loadAcquire() + quint64(valueUs));
+}
+
+int Metrics::bucketOf(qint64 valueUs)
+{
+    if (valueUs < kLinearBuckets) {
+        return int(valueUs);
+    }
+    int msb = 63 - int(qCountLeadingZeroBits(quint64(valueUs)));
+    int sub = int(valueUs >> (msb - 3)) & (kSubBuckets - 1);
+    return kLinearBuckets + (msb - 4) * kSubBuckets + sub;
+}
+
+qint64 Metrics::bucketMaxUs(int bucket)
+{
+    if (bucket < kLinearBuckets) {
+        return bucket;
+    }
+    int msb = (bucket - kLinearBuckets) / kSubBuckets + 4;
+    int sub = (bucket - kLinearBuckets) % kSubBuckets;
+    return (qint64(kSubBuckets + sub + 1) << (msb - 3)) - 1;
+}
+
+QString Metrics::label(const char *key, const QString &value)
+{
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("%1=\"%2\"").arg(key, escaped);
+}
+
+void Metrics::appendHistogram(QByteArray &out, const Family &family, const Series &series)
+{
+    quint64 counts[kBuckets] = {};
+    quint64 sumUs = 0;
+    for (Shard *shard : shards) {
+        HistogramShard *histogram = shard->histograms[series.slot].loadAcquire();
+        if (!histogram) {
+            continue;
+        }
+        for (int i = 0; i < kBuckets; ++i) {
+            counts[i] += histogram->buckets[i].loadAcquire();
+        }
+        sumUs += histogram->sumUs.loadAcquire();
+    }
+
+    quint64 cumulative = 0;
+    int bucket = 0;
+    for (qint64 bound : kExportBoundsUs) {
+        while (bucket < kBuckets && bucketMaxUs(bucket) <= bound) {
+            cumulative += counts[bucket++];
+        }
+        out += family.name + "_bucket" + withLabel(series.labels, "le=\"" + seconds(bound) + "\"")
+             + " " + QByteArray::number(cumulative) + "\n";
+    }
+    while (bucket < kBuckets) {
+        cumulative += counts[bucket++];
+    }
+    out += family.name + "_bucket" + withLabel(series.labels, "le=\"+Inf\"")
+         + " " + QByteArray::number(cumulative) + "\n";
+    out += family.name + "_sum" + braced(series.labels) + " " + seconds(qint64(sumUs)) + "\n";
+    out += family.name + "_count" + braced(series.labels) + " " + QByteArray::number(cumulative) + "\n";
+}
+
+QByteArray Metrics::exposition()
+{
+    static const char *const kTypeNames[] = {"counter", "gauge", "histogram"};
+
+    QByteArray out;
+    QMutexLocker locker(&mutex);
+    for (const Family &family : families) {
+        out += "# HELP " + family.name + " " + family.help + "\n";
+        out += "# TYPE " + family.name + " " + kTypeNames[family.kind] + "\n";
+        for (int index : family.series) {
+            const Series &series = seriesList[index];
+            switch (family.kind) {
+                case Counter: {
+                    quint64 total = 0;
+                    for (Shard *shard : shards) {
+                        total += shard->counters[series.slot].loadAcquire();
+                    }
+                    out += family.name + braced(series.labels) + " " + QByteArray::number(total) + "\n";
+                    break;
+                }
+                case Gauge:
+                    out += family.name + braced(series.labels) + " "
+                         + QByteArray::number(gauges[series.slot].loadAcquire()) + "\n";
+                    break;
+                case Histogram:
+                    appendHistogram(out, family, series);
+                    break;
+            }
+        }
+    }
+    return out;
+}
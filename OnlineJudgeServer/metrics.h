@@ -0,0 +1,101 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+
+// 进程内指标：计数器、仪表和 HDR 风格的耗时直方图，按 Prometheus 文本格式导出
+// 计数器与直方图按线程分片，记录时只写本线程的分片，不加锁也不与其他线程争用；
+// 导出时汇总所有分片。指标首次使用时注册并返回编号，调用方缓存编号，记录时不再查表
+class Metrics
+{
+public:
+    static Metrics *instance();
+
+    // labels 为已格式化的标签串，如 route="/api/login",status="200"；同名同标签返回同一编号
+    // 编号用尽时返回 -1，记录时忽略
+    int counter(const char *name, const char *help, const QString &labels = QString());
+    int gauge(const char *name, const char *help, const QString &labels = QString());
+    int histogram(const char *name, const char *help, const QString &labels = QString());
+
+    void add(int counterId, qint64 delta = 1);
+    void set(int gaugeId, qint64 value);
+    // 记录一次耗时（微秒），导出时换算为秒
+    void observe(int histogramId, qint64 valueUs);
+
+    // 文本格式 0.0.4
+    QByteArray exposition();
+
+    // 格式化一个标签，值中的反斜杠、引号和换行会被转义
+    static QString label(const char *key, const QString &value);
+
+private:
+    // 桶划分：0~15 微秒每微秒一个桶，之后每个 2 的幂区间再均分 8 个桶，相对误差不超过 12.5%
+    static const int kLinearBuckets = 16;
+    static const int kSubBuckets = 8;
+    static const int kBuckets = kLinearBuckets + 37 * kSubBuckets;
+    static const int kMaxCounters = 1024;
+    static const int kMaxGauges = 128;
+    static const int kMaxHistograms = 256;
+
+    enum Kind { Counter, Gauge, Histogram };
+
+    struct HistogramShard
+    {
+        QAtomicInteger<quint64> buckets[kBuckets];
+        QAtomicInteger<quint64> sumUs;
+    };
+
+    // 一个线程的分片：只有所属线程写入，导出线程只读
+    struct Shard
+    {
+        QAtomicInteger<quint64> counters[kMaxCounters];
+        QAtomicPointer<HistogramShard> histograms[kMaxHistograms];
+    };
+
+    struct Family
+    {
+        QByteArray name;
+        QByteArray help;
+        Kind kind;
+        QVector<int> series;  // 指向 seriesList 的下标
+    };
+
+    struct Series
+    {
+        QByteArray labels;
+        int slot;
+    };
+
+    friend struct ShardHandle;
+
+    Metrics();
+
+    int registerSeries(Kind kind, const char *name, const char *help, const QString &labels);
+    Shard *localShard();
+    void releaseShard(Shard *shard);
+
+    static int bucketOf(qint64 valueUs);
+    // 桶内最大值（微秒）
+    static qint64 bucketMaxUs(int bucket);
+
+    void appendHistogram(QByteArray &out, const Family &family, const Series &series);
+
+    QMutex mutex;  // 保护注册表与分片列表，记录路径不使用
+    QVector<Family> families;
+    QHash<QByteArray, int> familyIndex;
+    QVector<Series> seriesList;
+    QHash<QByteArray, int> seriesIndex;  // 名称{标签} -> 编号
+    int slotCount[3];
+
+    QVector<Shard*> shards;
+    QVector<Shard*> freeShards;  // 线程退出后留下的分片，计数保留，供新线程复用
+    QAtomicInteger<qint64> gauges[kMaxGauges];
+};
+
+#endif // METRICS_H
@@ -0,0 +1,387 @@
+#include "outputcomparator.h"
+#include <QtAlgorithms>
+#include <cmath>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Float 模式下超过该长度的记号不按数值解析
+const int kMaxNumberLength = 256;
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isLineSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+#if defined(__SSE2__)
+// 16 字节中空白字符（' ' 与 \t..\r）的位掩码
+inline quint32 spaceMask(__m128i v)
+{
+    __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i four = _mm_set1_epi8(4);
+    __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(offset, four), four);
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    return quint32(_mm_movemask_epi8(_mm_or_si128(control, space)));
+}
+#endif
+
+// [from, size) 中第一个非空白字符的位置，没有则返回 size
+qint64 skipSpaces(const char *p, qint64 from, qint64 size)
+{
+#if defined(__SSE2__)
+    while (from + 16 <= size) {
+        quint32 mask = spaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + from)));
+        if (mask != 0xFFFF) {
+            return from + qCountTrailingZeroBits(~mask & 0xFFFF);
+        }
+        from += 16;
+    }
+#endif
+    while (from < size && isSpace(p[from])) {
+        ++from;
+    }
+    return from;
+}
+
+// [from, size) 中第一个空白字符的位置，没有则返回 size
+qint64 findSpace(const char *p, qint64 from, qint64 size)
+{
+#if defined(__SSE2__)
+    while (from + 16 <= size) {
+        quint32 mask = spaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + from)));
+        if (mask != 0) {
+            return from + qCountTrailingZeroBits(mask);
+        }
+        from += 16;
+    }
+#endif
+    while (from < size && !isSpace(p[from])) {
+        ++from;
+    }
+    return from;
+}
+
+// a、b 前 n 字节中第一个不同字节的下标，全部相同返回 n
+qint64 firstMismatch(const char *a, const char *b, qint64 n)
+{
+    qint64 i = 0;
+#if defined(__SSE2__)
+    while (i + 16 <= n) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        quint32 equal = quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+        if (equal != 0xFFFF) {
+            return i + qCountTrailingZeroBits(~equal & 0xFFFF);
+        }
+        i += 16;
+    }
+#endif
+    while (i < n && a[i] == b[i]) {
+        ++i;
+    }
+    return i;
+}
+
+qint64 findNewline(const char *p, qint64 from, qint64 size)
+{
+    if (from >= size) {
+        return size;
+    }
+    const void *hit = memchr(p + from, '\n', size_t(size - from));
+    return hit ? static_cast<const char*>(hit) - p : size;
+}
+
+qint64 countNewlines(const char *p, qint64 size)
+{
+    qint64 count = 0;
+    qint64 i = 0;
+#if defined(__SSE2__)
+    __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        count += qPopulationCount(quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))));
+        i += 16;
+    }
+#endif
+    for (; i < size; ++i) {
+        count += p[i] == '\n';
+    }
+    return count;
+}
+
+bool numbersClose(const QByteArray &actual, const QByteArray &expected, double epsilon)
+{
+    bool okActual = false;
+    bool okExpected = false;
+    double a = actual.toDouble(&okActual);
+    double b = expected.toDouble(&okExpected);
+    if (!okActual || !okExpected) {
+        return false;
+    }
+    double diff = std::fabs(a - b);
+    return diff <= epsilon || diff <= epsilon * qMax(std::fabs(a), std::fabs(b));
+}
+
+} // namespace
+
+OutputComparator::OutputComparator(Mode mode, double epsilon)
+    : mode(mode)
+    , epsilon(epsilon)
+    , expected("")
+    , expectedSize(0)
+    , actualPos(0)
+    , expectedPos(0)
+    , mismatch(false)
+    , finished(false)
+    , mismatchActual(-1)
+    , mismatchExpected(-1)
+    , lineContentEnd(0)
+    , lineEnd(0)
+    , inToken(false)
+    , tokenBytewise(false)
+    , tokenStart(0)
+    , tokenEnd(0)
+    , tokenActualStart(0)
+{
+}
+
+OutputComparator::Mode OutputComparator::modeFromString(const QString &name)
+{
+    if (name == "exact") return Exact;
+    if (name == "token") return Token;
+    if (name == "float") return Float;
+    return Line;
+}
+
+void OutputComparator::setExpected(const char *data, qint64 size)
+{
+    expected = data;
+    expectedSize = size;
+    expectedPos = 0;
+    if (mode == Line) {
+        beginExpectedLine();
+    }
+}
+
+bool OutputComparator::consume(const char *data, qint64 size)
+{
+    if (mismatch) {
+        return false;
+    }
+    bool ok = true;
+    switch (mode) {
+        case Exact: ok = consumeExact(data, size); break;
+        case Line: ok = consumeLine(data, size); break;
+        case Token:
+        case Float: ok = consumeToken(data, size); break;
+    }
+    if (ok) {
+        actualPos += size;
+    }
+    return ok;
+}
+
+bool OutputComparator::finish()
+{
+    if (mismatch || finished) {
+        return !mismatch;
+    }
+    finished = true;
+
+    switch (mode) {
+        case Exact:
+            if (expectedPos < expectedSize) {
+                return fail(actualPos, expectedPos, "输出少于期望");
+            }
+            break;
+        case Line:
+            // 最后一行可以没有换行符；之后的期望内容只能是空行
+            if (expectedPos < lineContentEnd) {
+                return fail(actualPos, expectedPos, "最后一行输出不完整");
+            }
+            if (skipSpaces(expected, lineEnd, expectedSize) < expectedSize) {
+                return fail(actualPos, lineEnd, "输出少于期望");
+            }
+            break;
+        case Token:
+        case Float:
+            if (inToken && !endToken()) {
+                return false;
+            }
+            if (skipSpaces(expected, expectedPos, expectedSize) < expectedSize) {
+                return fail(actualPos, expectedPos, "输出少于期望");
+            }
+            break;
+    }
+    return true;
+}
+
+qint64 OutputComparator::expectedLine() const
+{
+    if (mismatchExpected < 0) {
+        return 0;
+    }
+    return countNewlines(expected, qMin(mismatchExpected, expectedSize)) + 1;
+}
+
+bool OutputComparator::fail(qint64 actualAt, qint64 expectedAt, const QString &why)
+{
+    mismatch = true;
+    mismatchActual = actualAt;
+    mismatchExpected = expectedAt;
+    reason = why;
+    return false;
+}
+
+bool OutputComparator::consumeExact(const char *data, qint64 size)
+{
+    qint64 available = expectedSize - expectedPos;
+    qint64 n = qMin(size, available);
+    qint64 k = firstMismatch(data, expected + expectedPos, n);
+    if (k < n) {
+        return fail(actualPos + k, expectedPos + k, "内容不一致");
+    }
+    if (size > available) {
+        return fail(actualPos + available, expectedSize, "输出多于期望");
+    }
+    expectedPos += size;
+    return true;
+}
+
+void OutputComparator::beginExpectedLine()
+{
+    lineEnd = findNewline(expected, expectedPos, expectedSize);
+    lineContentEnd = lineEnd;
+    while (lineContentEnd > expectedPos && isLineSpace(expected[lineContentEnd - 1])) {
+        --lineContentEnd;
+    }
+}
+
+bool OutputComparator::consumeLine(const char *data, qint64 size)
+{
+    qint64 i = 0;
+    while (i < size) {
+        if (expectedPos < lineContentEnd) {
+            // 期望行的有效内容部分逐字节比较
+            qint64 limit = qMin(size - i, lineContentEnd - expectedPos);
+            qint64 k = firstMismatch(data + i, expected + expectedPos, limit);
+            i += k;
+            expectedPos += k;
+            if (k < limit) {
+                return fail(actualPos + i, expectedPos,
+                            data[i] == '\n' ? "该行输出不完整" : "内容不一致");
+            }
+            continue;
+        }
+
+        // 有效内容已匹配完，该行剩余部分只允许行尾空白
+        char c = data[i];
+        if (c == '\n') {
+            expectedPos = lineEnd < expectedSize ? lineEnd + 1 : expectedSize;
+            beginExpectedLine();
+            ++i;
+        } else if (isLineSpace(c)) {
+            ++i;
+        } else {
+            return fail(actualPos + i, expectedPos,
+                        expectedPos >= expectedSize ? "输出多于期望" : "该行输出多于期望");
+        }
+    }
+    return true;
+}
+
+bool OutputComparator::consumeToken(const char *data, qint64 size)
+{
+    qint64 i = 0;
+    while (i < size) {
+        if (!inToken) {
+            i = skipSpaces(data, i, size);
+            if (i == size) {
+                break;
+            }
+            if (!beginToken()) {
+                return fail(actualPos + i, expectedSize, "输出多于期望");
+            }
+            tokenActualStart = actualPos + i;
+        }
+
+        qint64 j = findSpace(data, i, size);
+        if (!matchTokenBytes(data + i, j - i)) {
+            return false;
+        }
+        i = j;
+        if (j < size && !endToken()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OutputComparator::beginToken()
+{
+    tokenStart = skipSpaces(expected, expectedPos, expectedSize);
+    if (tokenStart >= expectedSize) {
+        return false;
+    }
+    tokenEnd = findSpace(expected, tokenStart, expectedSize);
+    expectedPos = tokenStart;
+    inToken = true;
+    tokenBytewise = (mode == Token);
+    numberBuffer.clear();
+    return true;
+}
+
+bool OutputComparator::matchTokenBytes(const char *data, qint64 size)
+{
+    if (!tokenBytewise) {
+        numberBuffer.append(data, int(size));
+        if (numberBuffer.size() <= kMaxNumberLength) {
+            return true;
+        }
+        // 过长的记号不可能是数值，改为与期望记号逐字节比较
+        tokenBytewise = true;
+        QByteArray buffered = numberBuffer;
+        numberBuffer.clear();
+        return matchTokenBytes(buffered.constData(), buffered.size());
+    }
+
+    qint64 available = tokenEnd - expectedPos;
+    qint64 n = qMin(size, available);
+    qint64 k = firstMismatch(data, expected + expectedPos, n);
+    if (k < n || size > available) {
+        return fail(tokenActualStart, tokenStart, "记号不一致");
+    }
+    expectedPos += size;
+    return true;
+}
+
+bool OutputComparator::endToken()
+{
+    inToken = false;
+    if (tokenBytewise) {
+        if (expectedPos != tokenEnd) {
+            return fail(tokenActualStart, tokenStart, "记号不一致");
+        }
+    } else {
+        QByteArray expectedToken = QByteArray::fromRawData(expected + tokenStart, int(tokenEnd - tokenStart));
+        if (numberBuffer != expectedToken) {
+            // fromRawData 不保证以 0 结尾，解析前复制
+            QByteArray expectedCopy(expectedToken.constData(), expectedToken.size());
+            if (expectedCopy.size() > kMaxNumberLength
+                || !numbersClose(numberBuffer, expectedCopy, epsilon)) {
+                return fail(tokenActualStart, tokenStart, "数值误差超出范围");
+            }
+        }
+    }
+    expectedPos = tokenEnd;
+    return true;
+}
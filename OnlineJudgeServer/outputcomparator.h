@@ -0,0 +1,78 @@
+#ifndef OUTPUTCOMPARATOR_H
+#define OUTPUTCOMPARATOR_H
+
+#include <QString>
+#include <QByteArray>
+#include "sandbox.h"
+
+// 流式输出比较器
+// 期望输出整体可随机访问（测试数据包的映射内存或调用方持有的内存），选手输出按块送入，
+// 两边都不需要完整缓存；发现第一处不一致后即停止
+class OutputComparator : public OutputSink
+{
+public:
+    enum Mode {
+        Exact,  // 逐字节一致
+        Line,   // 忽略行尾空白与末尾空行
+        Token,  // 按空白分隔的记号逐个比较
+        Float   // 同 Token，数值记号允许绝对或相对误差 epsilon
+    };
+
+    explicit OutputComparator(Mode mode = Line, double epsilon = 1e-6);
+
+    static Mode modeFromString(const QString &name);
+
+    // 期望输出由调用方保证在比较期间有效
+    void setExpected(const char *data, qint64 size);
+
+    // 送入一块选手输出，返回 false 表示已不一致，可以停止读取
+    bool consume(const char *data, qint64 size) override;
+    // 选手输出结束，返回最终是否一致
+    bool finish();
+
+    bool matched() const { return !mismatch; }
+    qint64 actualOffset() const { return mismatchActual; }
+    qint64 expectedOffset() const { return mismatchExpected; }
+    // 不一致位置在期望输出中的行号（从 1 开始）
+    qint64 expectedLine() const;
+    QString message() const { return reason; }
+
+private:
+    bool consumeExact(const char *data, qint64 size);
+    bool consumeLine(const char *data, qint64 size);
+    bool consumeToken(const char *data, qint64 size);
+
+    void beginExpectedLine();
+    bool beginToken();
+    bool endToken();
+    bool matchTokenBytes(const char *data, qint64 size);
+    bool fail(qint64 actualPos, qint64 expectedPos, const QString &why);
+
+    Mode mode;
+    double epsilon;
+
+    const char *expected;
+    qint64 expectedSize;
+
+    qint64 actualPos;     // 已消费的选手输出字节数
+    qint64 expectedPos;   // 期望输出中的当前位置
+    bool mismatch;
+    bool finished;
+    qint64 mismatchActual;
+    qint64 mismatchExpected;
+    QString reason;
+
+    // Line 模式：当前期望行去掉行尾空白后的结束位置与整行结束位置
+    qint64 lineContentEnd;
+    qint64 lineEnd;
+
+    // Token/Float 模式：当前记号状态
+    bool inToken;
+    bool tokenBytewise;   // Float 模式下过长的记号退化为逐字节比较
+    qint64 tokenStart;    // 期望记号的起止位置
+    qint64 tokenEnd;
+    qint64 tokenActualStart;  // 选手记号的起点，出错时报告
+    QByteArray numberBuffer;
+};
+
+#endif // OUTPUTCOMPARATOR_H
@@ -0,0 +1,348 @@
+#include "plagiarismindex.h"
+#include <QSet>
+#include <algorithm>
+
+namespace {
+
+// 每个指纹覆盖的记号数与 winnowing 窗口大小：长度不小于 k + w - 1 的相同片段一定会被检出
+const int kGramSize = 5;
+const int kWindowSize = 4;
+// 指纹过少的答案不参与比较
+const int kMinFingerprints = 4;
+// 低于该相似度的结果不保存
+const double kMinSimilarity = 0.3;
+// 倒排项超过此数量且超过半数提交时视为模板代码
+const int kMinCommonPostings = 8;
+
+const quint64 kRollingBase = 1000003;
+
+const char *const kKeywords[] = {
+    "auto", "bool", "break", "case", "catch", "char", "class", "const", "continue",
+    "default", "delete", "do", "double", "else", "enum", "false", "float", "for",
+    "if", "int", "long", "namespace", "new", "nullptr", "private", "protected",
+    "public", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+    "template", "this", "throw", "true", "try", "typedef", "unsigned", "using",
+    "virtual", "void", "while", "def", "elif", "in", "is", "not", "and", "or",
+    "import", "from", "lambda", "None", "True", "False", "pass", "yield", "with",
+    "final", "extends", "implements", "interface", "package", "boolean"
+};
+
+quint64 hashUnits(const QChar *data, int size)
+{
+    // FNV-1a，结果不依赖进程随机种子
+    quint64 hash = 14695981039346656037ULL;
+    for (int i = 0; i < size; ++i) {
+        hash ^= data[i].unicode();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+quint64 hashText(const char *text)
+{
+    QString s = QString::fromLatin1(text);
+    return hashUnits(s.constData(), s.size());
+}
+
+// 打散滚动哈希的低位结构，使窗口最小值在各位置上分布均匀
+quint64 mix(quint64 x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+const QSet<quint64> &keywordHashes()
+{
+    static const QSet<quint64> hashes = [] {
+        QSet<quint64> set;
+        for (const char *keyword : kKeywords) {
+            set.insert(hashText(keyword));
+        }
+        return set;
+    }();
+    return hashes;
+}
+
+bool isIdentifierStart(QChar ch)
+{
+    return ch.isLetter() || ch == '_';
+}
+
+bool isIdentifierPart(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == '_';
+}
+
+// 代码归一化：去掉注释、预处理行与空白；关键字保留，其余标识符、数字、字符串各归为一类
+QVector<quint64> codeTokens(const QString &answer)
+{
+    static const quint64 identifier = hashText("$id");
+    static const quint64 number = hashText("$num");
+    static const quint64 literal = hashText("$str");
+    const QSet<quint64> &keywords = keywordHashes();
+
+    QVector<quint64> tokens;
+    const QChar *p = answer.constData();
+    const int n = answer.size();
+    int i = 0;
+    bool lineStart = true;
+    while (i < n) {
+        QChar ch = p[i];
+        if (ch.isSpace()) {
+            lineStart = lineStart || ch == '\n';
+            ++i;
+            continue;
+        }
+        if (lineStart && ch == '#') {
+            while (i < n && p[i] != '\n') ++i;
+            continue;
+        }
+        lineStart = false;
+        if (ch == '/' && i + 1 < n && p[i + 1] == '/') {
+            while (i < n && p[i] != '\n') ++i;
+            continue;
+        }
+        if (ch == '/' && i + 1 < n && p[i + 1] == '*') {
+            i += 2;
+            while (i + 1 < n && !(p[i] == '*' && p[i + 1] == '/')) ++i;
+            i = qMin(n, i + 2);
+            continue;
+        }
+        if (isIdentifierStart(ch)) {
+            int start = i;
+            while (i < n && isIdentifierPart(p[i])) ++i;
+            quint64 word = hashUnits(p + start, i - start);
+            tokens.append(keywords.contains(word) ? word : identifier);
+            continue;
+        }
+        if (ch.isDigit()) {
+            while (i < n && (p[i].isLetterOrNumber() || p[i] == '.')) ++i;
+            tokens.append(number);
+            continue;
+        }
+        if (ch == '"' || ch == '\'') {
+            ++i;
+            while (i < n && p[i] != ch && p[i] != '\n') {
+                i += p[i] == '\\' ? 2 : 1;
+            }
+            i = qMin(n, i + 1);
+            tokens.append(literal);
+            continue;
+        }
+        tokens.append(hashUnits(&p[i], 1));
+        ++i;
+    }
+    return tokens;
+}
+
+// 文本归一化：按词切分并转小写，中日韩文字逐字成词，标点忽略
+QVector<quint64> textTokens(const QString &answer)
+{
+    QString text = answer.toLower();
+    QVector<quint64> tokens;
+    const QChar *p = text.constData();
+    const int n = text.size();
+    int i = 0;
+    while (i < n) {
+        if (!p[i].isLetterOrNumber()) {
+            ++i;
+            continue;
+        }
+        if (p[i].unicode() >= 0x2E80) {
+            tokens.append(hashUnits(&p[i], 1));
+            ++i;
+            continue;
+        }
+        int start = i;
+        while (i < n && p[i].isLetterOrNumber() && p[i].unicode() < 0x2E80) ++i;
+        tokens.append(hashUnits(p + start, i - start));
+    }
+    return tokens;
+}
+
+} // namespace
+
+PlagiarismIndex::PlagiarismIndex()
+{
+}
+
+QVector<quint64> PlagiarismIndex::fingerprints(const QString &answer, bool code)
+{
+    QVector<quint64> tokens = code ? codeTokens(answer) : textTokens(answer);
+    if (tokens.size() < kGramSize) {
+        return QVector<quint64>();
+    }
+
+    // k-gram 滚动哈希
+    quint64 highPower = 1;
+    for (int i = 1; i < kGramSize; ++i) {
+        highPower *= kRollingBase;
+    }
+    const int gramCount = tokens.size() - kGramSize + 1;
+    QVector<quint64> grams(gramCount);
+    quint64 rolling = 0;
+    for (int i = 0; i < kGramSize; ++i) {
+        rolling = rolling * kRollingBase + tokens[i];
+    }
+    grams[0] = mix(rolling);
+    for (int i = 1; i < gramCount; ++i) {
+        rolling = (rolling - tokens[i - 1] * highPower) * kRollingBase + tokens[i + kGramSize - 1];
+        grams[i] = mix(rolling);
+    }
+
+    // winnowing：单调队列求滑动窗口最小值，相等时取最右，同一位置只记录一次
+    QVector<quint64> prints;
+    QVector<int> window(gramCount);
+    int head = 0;
+    int tail = 0;
+    int lastSelected = -1;
+    for (int i = 0; i < gramCount; ++i) {
+        while (tail > head && grams[window[tail - 1]] >= grams[i]) {
+            --tail;
+        }
+        window[tail++] = i;
+        if (window[head] <= i - kWindowSize) {
+            ++head;
+        }
+        if ((i >= kWindowSize - 1 || i == gramCount - 1) && window[head] != lastSelected) {
+            lastSelected = window[head];
+            prints.append(grams[lastSelected]);
+        }
+    }
+
+    std::sort(prints.begin(), prints.end());
+    prints.erase(std::unique(prints.begin(), prints.end()), prints.end());
+    return prints;
+}
+
+quint64 PlagiarismIndex::pairKey(int a, int b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (quint64(quint32(a)) << 32) | quint32(b);
+}
+
+int PlagiarismIndex::remove(Homework &homework, int studentId)
+{
+    auto found = homework.documentOfStudent.find(studentId);
+    if (found == homework.documentOfStudent.end()) {
+        return -1;
+    }
+    int documentId = found.value();
+
+    Document &document = homework.documents[documentId];
+    for (quint64 print : document.prints) {
+        auto posting = homework.postings.find(print);
+        if (posting == homework.postings.end()) {
+            continue;
+        }
+        posting->removeOne(documentId);
+        if (posting->isEmpty()) {
+            homework.postings.erase(posting);
+        }
+    }
+    document.prints.clear();
+
+    for (auto it = homework.pairs.begin(); it != homework.pairs.end();) {
+        if (it->studentA == studentId || it->studentB == studentId) {
+            it = homework.pairs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return documentId;
+}
+
+QList<SimilarPair> PlagiarismIndex::add(int homeworkId, int studentId, const QString &answer, bool code)
+{
+    Homework &homework = homeworks[homeworkId];
+    // 重新提交时沿用原文档号，文档数不随提交次数增长
+    int documentId = remove(homework, studentId);
+    if (documentId < 0) {
+        documentId = homework.documents.size();
+        homework.documents.append(Document{studentId, QVector<quint64>()});
+        homework.documentOfStudent.insert(studentId, documentId);
+    }
+    homework.documents[documentId].prints = fingerprints(answer, code);
+    const QVector<quint64> &prints = homework.documents[documentId].prints;
+
+    // 只遍历新提交自身指纹的倒排项，与作业内提交总数无关
+    int commonLimit = qMax(kMinCommonPostings, homework.documentOfStudent.size() / 2);
+    bool comparable = prints.size() >= kMinFingerprints;
+    QHash<int, int> sharedCount;
+    for (quint64 print : prints) {
+        QVector<int> &posting = homework.postings[print];
+        if (comparable && posting.size() <= commonLimit) {
+            for (int other : posting) {
+                ++sharedCount[other];
+            }
+        }
+        posting.append(documentId);
+    }
+
+    QList<SimilarPair> matches;
+    for (auto it = sharedCount.cbegin(); it != sharedCount.cend(); ++it) {
+        const Document &other = homework.documents[it.key()];
+        if (other.prints.size() < kMinFingerprints) {
+            continue;
+        }
+        SimilarPair pair;
+        pair.studentA = qMin(studentId, other.studentId);
+        pair.studentB = qMax(studentId, other.studentId);
+        pair.shared = it.value();
+        pair.similarity = double(pair.shared) / qMin(prints.size(), other.prints.size());
+        if (pair.similarity < kMinSimilarity) {
+            continue;
+        }
+        homework.pairs.insert(pairKey(pair.studentA, pair.studentB), pair);
+        matches.append(pair);
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const SimilarPair &a, const SimilarPair &b) {
+        return a.similarity > b.similarity;
+    });
+    return matches;
+}
+
+QList<SimilarPair> PlagiarismIndex::topPairs(int homeworkId, int limit) const
+{
+    auto homework = homeworks.constFind(homeworkId);
+    if (homework == homeworks.constEnd()) {
+        return QList<SimilarPair>();
+    }
+    QList<SimilarPair> pairs = homework->pairs.values();
+    std::sort(pairs.begin(), pairs.end(), [](const SimilarPair &a, const SimilarPair &b) {
+        if (a.similarity != b.similarity) return a.similarity > b.similarity;
+        return a.shared > b.shared;
+    });
+    return pairs.mid(0, limit);
+}
+
+int PlagiarismIndex::documentCount(int homeworkId) const
+{
+    auto homework = homeworks.constFind(homeworkId);
+    return homework == homeworks.constEnd() ? 0 : homework->documentOfStudent.size();
+}
+
+QJsonObject PlagiarismIndex::stats() const
+{
+    qint64 documents = 0;
+    qint64 postings = 0;
+    qint64 pairs = 0;
+    for (const Homework &homework : homeworks) {
+        documents += homework.documentOfStudent.size();
+        postings += homework.postings.size();
+        pairs += homework.pairs.size();
+    }
+    return QJsonObject{
+        {"homeworks", homeworks.size()},
+        {"documents", documents},
+        {"fingerprints", postings},
+        {"pairs", pairs}
+    };
+}
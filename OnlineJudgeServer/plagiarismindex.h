@@ -0,0 +1,64 @@
+#ifndef PLAGIARISMINDEX_H
+#define PLAGIARISMINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QJsonObject>
+
+// 两份提交的相似度
+struct SimilarPair
+{
+    int studentA = 0;
+    int studentB = 0;
+    double similarity = 0;  // 共同指纹数 / 较短一方的指纹数
+    int shared = 0;
+};
+
+// 作业查重索引
+// 答案先做词法归一化（代码去掉注释与空白、标识符统一为一个记号，文本按词切分），
+// 对记号序列计算 k-gram 滚动哈希，再用 winnowing 在每个窗口取最小值作为指纹
+// 每个作业维护指纹 -> 提交的倒排表，新提交只需遍历自己指纹的倒排项即可找出相似的旧提交，
+// 出现在大多数提交中的指纹（题目模板）不参与计数
+// 仅在内存中保存，启动时由作业数据重建；只在主线程调用
+class PlagiarismIndex
+{
+public:
+    PlagiarismIndex();
+
+    // 登记（或替换）学生的答案，返回与已有提交的相似结果，按相似度降序
+    QList<SimilarPair> add(int homeworkId, int studentId, const QString &answer, bool code);
+
+    // 作业内相似度最高的 limit 对提交
+    QList<SimilarPair> topPairs(int homeworkId, int limit) const;
+    int documentCount(int homeworkId) const;
+    // 索引规模：作业、文档、倒排项与相似对的数量
+    QJsonObject stats() const;
+
+    // 答案的指纹集合（已排序去重）
+    static QVector<quint64> fingerprints(const QString &answer, bool code);
+
+private:
+    struct Document
+    {
+        int studentId;
+        QVector<quint64> prints;
+    };
+
+    struct Homework
+    {
+        QVector<Document> documents;          // 下标为文档号，每个学生一个，重新提交时原位替换
+        QHash<int, int> documentOfStudent;
+        QHash<quint64, QVector<int>> postings;  // 指纹 -> 文档号
+        QHash<quint64, SimilarPair> pairs;     // 只保存超过阈值的相似对
+    };
+
+    // 移除学生当前文档的指纹与相似对，返回其文档号，没有时返回 -1
+    int remove(Homework &homework, int studentId);
+    static quint64 pairKey(int a, int b);
+
+    QHash<int, Homework> homeworks;
+};
+
+#endif // PLAGIARISMINDEX_H
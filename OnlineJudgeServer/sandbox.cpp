@@ -0,0 +1,533 @@
+#include "sandbox.h"
+#include <QFile>
+#include <QDir>
+#include <QVector>
+#include <QCoreApplication>
+#include <QAtomicInteger>
+#include "logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+namespace {
+
+const int kErrorOutputLimit = 4096;
+const int kReadChunk = 64 * 1024;
+// 无 cgroup 时采样地址空间峰值的间隔
+const qint64 kMemorySampleUs = 10000;
+
+QString cgroupRootPath;
+QAtomicInteger<quint32> cgroupSeq(0);
+
+qint64 timevalToMs(const struct timeval &tv)
+{
+    return qint64(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+}
+
+void closeFd(int &fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool writeControlFile(const QString &path, const QByteArray &value)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(value) == value.size();
+}
+
+QByteArray readControlFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// 进程地址空间峰值（/proc/<pid>/status 的 VmPeak），读不到返回 0
+qint64 addressSpacePeak(pid_t pid)
+{
+    QByteArray status = readControlFile(QString("/proc/%1/status").arg(pid));
+    int pos = status.indexOf("VmPeak:");
+    if (pos < 0) {
+        return 0;
+    }
+    QByteArray value = status.mid(pos + 7, status.indexOf('\n', pos) - pos - 7).trimmed();
+    return value.left(value.indexOf(' ')).toLongLong() * 1024;
+}
+
+// 只受 RLIMIT_AS 限制时，内存申请被拒绝的进程表现为异常退出：
+// 运行时报告分配失败，或在地址空间接近上限时因段错误、abort 终止
+bool addressSpaceExhausted(const RunResult &result, qint64 peakBytes, qint64 limitBytes)
+{
+    static const char *const markers[] = {
+        "std::bad_alloc", "MemoryError", "OutOfMemoryError", "Cannot allocate memory"
+    };
+    if (result.exitCode == 0) {
+        return false;
+    }
+    for (const char *marker : markers) {
+        if (result.errorOutput.contains(marker)) {
+            return true;
+        }
+    }
+    bool crashed = result.termSignal == SIGSEGV || result.termSignal == SIGABRT || result.termSignal == SIGBUS;
+    return crashed && peakBytes >= limitBytes / 4 * 3;
+}
+
+void setLimit(int resource, rlim_t soft, rlim_t hard)
+{
+    struct rlimit rl;
+    rl.rlim_cur = soft;
+    rl.rlim_max = hard;
+    setrlimit(resource, &rl);
+}
+
+void closeRange(int first, int last)
+{
+    if (first > last) {
+        return;
+    }
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, first, last, 0) == 0) {
+        return;
+    }
+#endif
+    for (int fd = first; fd <= last && fd < 4096; ++fd) {
+        ::close(fd);
+    }
+}
+
+// 关闭继承来的其他描述符，keepFds 须升序排列
+void closeInheritedFds(const int *keepFds, int keepCount)
+{
+    int next = STDERR_FILENO + 1;
+    for (int i = 0; i < keepCount; ++i) {
+        closeRange(next, keepFds[i] - 1);
+        next = keepFds[i] + 1;
+    }
+    closeRange(next, INT_MAX);
+}
+
+void reportErrno(int fd)
+{
+    int err = errno;
+    ssize_t ignored = ::write(fd, &err, sizeof(err));
+    Q_UNUSED(ignored);
+}
+
+} // namespace
+
+QString ResourceLimits::key() const
+{
+    return QString("%1/%2/%3/%4/%5")
+        .arg(cpuTimeMs)
+        .arg(wallTimeMs)
+        .arg(memoryBytes)
+        .arg(outputBytes)
+        .arg(maxProcesses);
+}
+
+bool Sandbox::setCgroupRoot(const QString &path)
+{
+    if (!QFile::exists(path + "/cgroup.subtree_control")) {
+        LOG_WARNING(QString("cgroup 目录不可用：%1，仅使用 rlimit 限制").arg(path));
+        return false;
+    }
+    // 子 cgroup 需要 memory 与 pids 控制器
+    writeControlFile(path + "/cgroup.subtree_control", "+memory +pids");
+    cgroupRootPath = path;
+    LOG_INFO(QString("评测进程启用 cgroup v2：%1").arg(path));
+    return true;
+}
+
+QString Sandbox::cgroupRoot()
+{
+    return cgroupRootPath;
+}
+
+qint64 Sandbox::monotonicUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 为本次运行创建子 cgroup，失败时返回空串并退回纯 rlimit 模式
+QString Sandbox::createCgroup(const ResourceLimits &limits)
+{
+    if (cgroupRootPath.isEmpty()) {
+        return QString();
+    }
+
+    QString dir = QString("%1/run-%2-%3")
+        .arg(cgroupRootPath)
+        .arg(QCoreApplication::applicationPid())
+        .arg(cgroupSeq.fetchAndAddRelaxed(1));
+    if (!QDir().mkdir(dir)) {
+        return QString();
+    }
+
+    bool ok = writeControlFile(dir + "/memory.max", QByteArray::number(limits.memoryBytes))
+           && writeControlFile(dir + "/memory.swap.max", "0")
+           && writeControlFile(dir + "/pids.max", QByteArray::number(limits.maxProcesses));
+    if (!ok) {
+        QDir().rmdir(dir);
+        return QString();
+    }
+    return dir;
+}
+
+bool Sandbox::setupChild(const ResourceLimits &limits, int stdinFd, int stdoutFd, int stderrFd,
+                         const int *keepFds, int keepCount, int cgroupProcsFd)
+{
+    setpgid(0, 0);
+
+    if (cgroupProcsFd >= 0 && ::write(cgroupProcsFd, "0", 1) != 1) {
+        return false;
+    }
+
+    if (dup2(stdinFd, STDIN_FILENO) < 0 || dup2(stdoutFd, STDOUT_FILENO) < 0
+        || dup2(stderrFd, STDERR_FILENO) < 0) {
+        return false;
+    }
+    closeInheritedFds(keepFds, keepCount);
+
+    rlim_t cpuSeconds = rlim_t((limits.cpuTimeMs + 999) / 1000);
+    setLimit(RLIMIT_CPU, cpuSeconds, cpuSeconds + 1);
+    setLimit(RLIMIT_FSIZE, rlim_t(limits.outputBytes), rlim_t(limits.outputBytes));
+    setLimit(RLIMIT_STACK, rlim_t(limits.memoryBytes), rlim_t(limits.memoryBytes));
+    setLimit(RLIMIT_CORE, 0, 0);
+    // 有 cgroup 时由 memory.max 按实际占用限制，避免虚拟地址空间限制误伤
+    if (cgroupProcsFd < 0) {
+        setLimit(RLIMIT_AS, rlim_t(limits.memoryBytes), rlim_t(limits.memoryBytes));
+    }
+
+    // 恢复信号状态，忽略的 SIGPIPE 会跨 exec 继承
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, nullptr);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_DFL;
+    sigaction(SIGPIPE, &sa, nullptr);
+    return true;
+}
+
+RunResult Sandbox::run(const QStringList &command, const QByteArray &input,
+                       const ResourceLimits &limits, const QString &workDir,
+                       OutputSink *sink)
+{
+    RunResult result;
+    if (command.isEmpty()) {
+        result.error = "运行命令为空";
+        return result;
+    }
+
+    // fork 前准备好 argv，子进程中不再分配内存
+    QList<QByteArray> args;
+    for (const QString &arg : command) {
+        args.append(QFile::encodeName(arg));
+    }
+    QVector<char*> argv;
+    for (QByteArray &arg : args) {
+        argv.append(arg.data());
+    }
+    argv.append(nullptr);
+    QByteArray dir = QFile::encodeName(workDir);
+
+    int inPipe[2] = {-1, -1};
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    int execPipe[2] = {-1, -1};
+    if (pipe2(inPipe, O_CLOEXEC) < 0 || pipe2(outPipe, O_CLOEXEC) < 0
+        || pipe2(errPipe, O_CLOEXEC) < 0 || pipe2(execPipe, O_CLOEXEC) < 0) {
+        result.error = QString("创建管道失败：%1").arg(strerror(errno));
+        for (int *p : {inPipe, outPipe, errPipe, execPipe}) {
+            closeFd(p[0]);
+            closeFd(p[1]);
+        }
+        return result;
+    }
+
+    SandboxProcess process;
+    process.cgroupDir = createCgroup(limits);
+    int procsFd = -1;
+    if (!process.cgroupDir.isEmpty()) {
+        procsFd = ::open(QFile::encodeName(process.cgroupDir + "/cgroup.procs").constData(),
+                         O_WRONLY | O_CLOEXEC);
+        // 进不了 cgroup 时按无 cgroup 处理：由 RLIMIT_AS 限制，不读取空 cgroup 的统计
+        if (procsFd < 0) {
+            QDir().rmdir(process.cgroupDir);
+            process.cgroupDir.clear();
+        }
+    }
+
+    process.startUs = monotonicUs();
+    process.pid = fork();
+    if (process.pid == 0) {
+        // execPipe 依赖 O_CLOEXEC 在 exec 成功时关闭
+        int keep[] = {execPipe[1]};
+        if (setupChild(limits, inPipe[0], outPipe[1], errPipe[1], keep, 1, procsFd)
+            && chdir(dir.constData()) == 0) {
+            execvp(argv[0], argv.data());
+        }
+        reportErrno(execPipe[1]);
+        _exit(127);
+    }
+
+    closeFd(inPipe[0]);
+    closeFd(outPipe[1]);
+    closeFd(errPipe[1]);
+    closeFd(execPipe[1]);
+    closeFd(procsFd);
+    process.stdinFd = inPipe[1];
+    process.stdoutFd = outPipe[0];
+    process.stderrFd = errPipe[0];
+
+    if (process.pid < 0) {
+        result.error = QString("fork 失败：%1").arg(strerror(errno));
+        closeFd(process.stdinFd);
+        closeFd(process.stdoutFd);
+        closeFd(process.stderrFd);
+        closeFd(execPipe[0]);
+        if (!process.cgroupDir.isEmpty()) {
+            QDir().rmdir(process.cgroupDir);
+        }
+        return result;
+    }
+
+    // exec 成功后管道随 O_CLOEXEC 关闭，读到 EOF；失败则读到 errno
+    int childErrno = 0;
+    ssize_t n;
+    do {
+        n = ::read(execPipe[0], &childErrno, sizeof(childErrno));
+    } while (n < 0 && errno == EINTR);
+    closeFd(execPipe[0]);
+    qint64 spawnUs = monotonicUs() - process.startUs;
+
+    result = supervise(process, input, limits, n == sizeof(childErrno) ? childErrno : 0, sink);
+    result.spawnUs = spawnUs;
+    if (result.status == RunResult::SystemError) {
+        result.error = QString("无法执行 %1：%2").arg(command.first()).arg(result.error);
+    }
+    return result;
+}
+
+RunResult Sandbox::supervise(SandboxProcess &process, const QByteArray &input,
+                             const ResourceLimits &limits, int execErrno,
+                             OutputSink *sink)
+{
+    RunResult result;
+    bool timedOut = false;
+    bool outputExceeded = false;
+    qint64 outputBytes = 0;
+    pid_t pid = process.pid;
+    // 没有 cgroup 时内存只受 RLIMIT_AS 限制，运行期间定期采样地址空间峰值
+    bool sampleMemory = process.cgroupDir.isEmpty();
+    qint64 peakAddressSpace = 0;
+    qint64 nextSampleUs = 0;
+    auto sampleAddressSpace = [&]() {
+        qint64 now = monotonicUs();
+        if (sampleMemory && now >= nextSampleUs) {
+            peakAddressSpace = qMax(peakAddressSpace, addressSpacePeak(pid));
+            nextSampleUs = now + kMemorySampleUs;
+        }
+    };
+
+    if (execErrno == 0) {
+        fcntl(process.stdinFd, F_SETFL, O_NONBLOCK);
+        fcntl(process.stdoutFd, F_SETFL, O_NONBLOCK);
+        fcntl(process.stderrFd, F_SETFL, O_NONBLOCK);
+        if (input.isEmpty()) {
+            closeFd(process.stdinFd);
+        }
+
+        qint64 deadline = process.startUs + limits.wallTimeMs * 1000;
+        qint64 inputOffset = 0;
+        char buffer[kReadChunk];
+
+        while (process.stdoutFd >= 0 || process.stderrFd >= 0) {
+            qint64 remainingMs = (deadline - monotonicUs()) / 1000;
+            if (remainingMs <= 0) {
+                timedOut = true;
+                break;
+            }
+
+            struct pollfd fds[3];
+            int count = 0;
+            int inIndex = -1, outIndex = -1, errIndex = -1;
+            if (process.stdinFd >= 0) {
+                inIndex = count;
+                fds[count++] = {process.stdinFd, POLLOUT, 0};
+            }
+            if (process.stdoutFd >= 0) {
+                outIndex = count;
+                fds[count++] = {process.stdoutFd, POLLIN, 0};
+            }
+            if (process.stderrFd >= 0) {
+                errIndex = count;
+                fds[count++] = {process.stderrFd, POLLIN, 0};
+            }
+
+            sampleAddressSpace();
+            int ready = poll(fds, count, int(qMin<qint64>(remainingMs, sampleMemory ? kMemorySampleUs / 1000 : 1000)));
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+
+            if (inIndex >= 0 && fds[inIndex].revents) {
+                ssize_t written = ::write(process.stdinFd, input.constData() + inputOffset,
+                                          size_t(input.size() - inputOffset));
+                if (written > 0) {
+                    inputOffset += written;
+                }
+                // 写完或子进程不再读取（EPIPE）时关闭 stdin
+                if (inputOffset >= input.size() || (written < 0 && errno != EAGAIN)) {
+                    closeFd(process.stdinFd);
+                }
+            }
+
+            if (outIndex >= 0 && fds[outIndex].revents) {
+                ssize_t got = ::read(process.stdoutFd, buffer, sizeof(buffer));
+                if (got > 0) {
+                    outputBytes += got;
+                    if (outputBytes > limits.outputBytes) {
+                        outputExceeded = true;
+                        break;
+                    }
+                    if (!sink) {
+                        result.output.append(buffer, int(got));
+                    } else if (!sink->consume(buffer, got)) {
+                        result.outputRejected = true;
+                        break;
+                    }
+                } else if (got == 0 || errno != EAGAIN) {
+                    closeFd(process.stdoutFd);
+                }
+            }
+
+            if (errIndex >= 0 && fds[errIndex].revents) {
+                ssize_t got = ::read(process.stderrFd, buffer, sizeof(buffer));
+                if (got > 0) {
+                    int room = kErrorOutputLimit - result.errorOutput.size();
+                    if (room > 0) {
+                        result.errorOutput.append(buffer, int(qMin<ssize_t>(got, room)));
+                    }
+                } else if (got == 0 || errno != EAGAIN) {
+                    closeFd(process.stderrFd);
+                }
+            }
+        }
+
+        // 输出已关闭时等待进程退出，但不超过墙钟时限；WNOWAIT 保留僵尸以便清理进程组
+        while (!timedOut && !outputExceeded && !result.outputRejected) {
+            siginfo_t info;
+            memset(&info, 0, sizeof(info));
+            if (waitid(P_PID, id_t(pid), &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0) {
+                break;
+            }
+            sampleAddressSpace();
+            if (monotonicUs() >= deadline) {
+                timedOut = true;
+                break;
+            }
+            usleep(500);
+        }
+    }
+
+    // 同时清理进程组内遗留的子进程
+    kill(-pid, SIGKILL);
+    kill(pid, SIGKILL);
+    closeFd(process.stdinFd);
+    closeFd(process.stdoutFd);
+    closeFd(process.stderrFd);
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    result.wallTimeMs = (monotonicUs() - process.startUs) / 1000;
+    result.cpuTimeMs = timevalToMs(usage.ru_utime) + timevalToMs(usage.ru_stime);
+    // ru_maxrss 还包含 exec 前从服务器进程继承的常驻内存，不能代表选手程序的占用；
+    // 只有 cgroup 的 memory.peak 可信，没有 cgroup 时内存占用记为未知（-1）
+    result.peakMemoryKb = -1;
+
+    bool oomKilled = false;
+    bool peakExceeded = false;
+    if (!process.cgroupDir.isEmpty()) {
+        QByteArray peak = readControlFile(process.cgroupDir + "/memory.peak").trimmed();
+        if (!peak.isEmpty()) {
+            qint64 peakBytes = peak.toLongLong();
+            result.peakMemoryKb = peakBytes / 1024;
+            peakExceeded = peakBytes > limits.memoryBytes;
+        }
+        QByteArray events = readControlFile(process.cgroupDir + "/memory.events");
+        int pos = events.indexOf("oom_kill ");
+        if (pos >= 0) {
+            oomKilled = events.mid(pos + 9, events.indexOf('\n', pos) - pos - 9).toLongLong() > 0;
+        }
+        QDir().rmdir(process.cgroupDir);
+    }
+
+    if (execErrno != 0) {
+        result.status = RunResult::SystemError;
+        result.error = QString::fromLocal8Bit(strerror(execErrno));
+        return result;
+    }
+
+    bool signaled = WIFSIGNALED(status);
+    result.termSignal = signaled ? WTERMSIG(status) : 0;
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    if (outputExceeded || result.termSignal == SIGXFSZ) {
+        result.status = RunResult::OutputLimitExceeded;
+    } else if (timedOut || result.termSignal == SIGXCPU || result.cpuTimeMs > limits.cpuTimeMs) {
+        result.status = RunResult::TimeLimitExceeded;
+    } else if (oomKilled || peakExceeded
+               || (sampleMemory && !result.outputRejected
+                   && addressSpaceExhausted(result, peakAddressSpace, limits.memoryBytes))) {
+        result.status = RunResult::MemoryLimitExceeded;
+    } else if (result.outputRejected) {
+        // 进程是被我们提前终止的，退出状态没有意义
+        result.status = RunResult::Ok;
+    } else if (signaled || result.exitCode != 0) {
+        result.status = RunResult::RuntimeError;
+    } else {
+        result.status = RunResult::Ok;
+    }
+    return result;
+}
+
+QString Sandbox::statusName(RunResult::Status status)
+{
+    switch (status) {
+        case RunResult::Ok: return "OK";
+        case RunResult::TimeLimitExceeded: return "TLE";
+        case RunResult::MemoryLimitExceeded: return "MLE";
+        case RunResult::OutputLimitExceeded: return "OLE";
+        case RunResult::RuntimeError: return "RE";
+        case RunResult::SystemError: return "SE";
+        default: return "UNKNOWN";
+    }
+}
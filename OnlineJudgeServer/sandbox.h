@@ -0,0 +1,98 @@
+#ifndef SANDBOX_H
+#define SANDBOX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <sys/types.h>
+
+// 单次运行的资源限制
+struct ResourceLimits
+{
+    qint64 cpuTimeMs = 1000;
+    qint64 wallTimeMs = 3000;
+    qint64 memoryBytes = 256LL << 20;
+    qint64 outputBytes = 64LL << 20;
+    int maxProcesses = 1;  // 仅在启用 cgroup 时生效
+
+    // 相同限制的运行可共用预派生的进程
+    QString key() const;
+};
+
+// 单次运行结果，时间与内存取自 wait4 返回的 rusage
+struct RunResult
+{
+    enum Status {
+        Ok,
+        TimeLimitExceeded,
+        MemoryLimitExceeded,
+        OutputLimitExceeded,
+        RuntimeError,
+        SystemError
+    };
+
+    Status status = SystemError;
+    int exitCode = -1;
+    int termSignal = 0;
+    qint64 cpuTimeMs = 0;
+    qint64 wallTimeMs = 0;
+    qint64 peakMemoryKb = 0;  // 没有 cgroup 时无法可靠测量，为 -1
+    qint64 spawnUs = 0;      // 从发起运行到 exec 成功的耗时
+    bool outputRejected = false;  // 输出接收方提前判定不一致，进程已被终止
+    QByteArray output;       // 指定 OutputSink 时为空
+    QByteArray errorOutput;  // 只保留前 4KB
+    QString error;
+};
+
+// 标准输出的接收方，边运行边处理，不在内存中保留完整输出
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+    // 返回 false 表示不再需要后续输出，子进程将被提前终止
+    virtual bool consume(const char *data, qint64 size) = 0;
+};
+
+// 已 fork 的子进程，由 Sandbox::supervise 喂输入、收输出并回收
+struct SandboxProcess
+{
+    pid_t pid = -1;
+    int stdinFd = -1;
+    int stdoutFd = -1;
+    int stderrFd = -1;
+    qint64 startUs = 0;  // 墙钟计时起点
+    QString cgroupDir;
+};
+
+// 在子进程中运行命令并施加 rlimit（可选 cgroup v2）限制
+// 注意：这里只做资源限制，不做系统调用过滤
+class Sandbox
+{
+public:
+    // 启用 cgroup v2，path 须是已委派给当前用户的 cgroup 目录
+    static bool setCgroupRoot(const QString &path);
+    static QString cgroupRoot();
+
+    // sink 为空时标准输出收集到 RunResult::output
+    static RunResult run(const QStringList &command, const QByteArray &input,
+                         const ResourceLimits &limits, const QString &workDir,
+                         OutputSink *sink = nullptr);
+
+    static QString statusName(RunResult::Status status);
+
+    // 以下供预派生进程池复用
+    static qint64 monotonicUs();
+    static QString createCgroup(const ResourceLimits &limits);
+
+    // fork 之后在子进程中调用，只含 async-signal-safe 操作
+    // 重定向标准输入输出、关闭除 keepFds 外的描述符并施加限制，失败返回 false
+    static bool setupChild(const ResourceLimits &limits, int stdinFd, int stdoutFd, int stderrFd,
+                           const int *keepFds, int keepCount, int cgroupProcsFd);
+
+    // execErrno 非 0 表示 exec 失败，此时只回收进程
+    static RunResult supervise(SandboxProcess &process, const QByteArray &input,
+                               const ResourceLimits &limits, int execErrno,
+                               OutputSink *sink = nullptr);
+};
+
+#endif // SANDBOX_H
@@ -1,27 +1,266 @@
 #include "server.h"
+#include <QRunnable>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include "logger.h"
+#include "tracer.h"
 #include <QFile>
 
+namespace {
+
+// 指标中的路由标签只取已知路由，其余归为 other，避免任意路径撑大指标数量
+// 重测批次在这么久没有收到任何结果、且队列与远程租约都已空时，认为剩余任务已丢失
+const qint64 kRejudgeStallMs = 5 * 60 * 1000;
+// 队列一直不空时也不能无限等待
+const qint64 kRejudgeAbandonMs = 30 * 60 * 1000;
+
+const char *const kKnownRoutes[] = {
+    "/api/login", "/api/submit", "/api/publish", "/api/homeworks", "/api/grade",
+    "/api/users/list", "/api/users/add", "/api/users/edit", "/api/users/delete",
+    "/api/judge/stats", "/api/rejudge", "/api/worker/lease", "/api/worker/heartbeat",
+    "/api/worker/result", "/api/plagiarism", "/api/run", "/api/testset/update", "/metrics",
+    "/api/admin/introspect", "/api/logout"
+};
+
+QString routeLabel(const QString &path)
+{
+    for (const char *route : kKnownRoutes) {
+        if (path == QLatin1String(route)) {
+            return path;
+        }
+    }
+    return "other";
+}
+
+// 各路由要求的身份；未列出的路由都需要登录
+enum RouteAccess {
+    AccessPublic,    // 登录、指标抓取；远程评测节点与运维接口有各自的令牌
+    AccessUser,
+    AccessStudent,
+    AccessStaff,     // 教师或管理员
+    AccessAdmin
+};
+
+RouteAccess routeAccess(const QString &path)
+{
+    if (path == "/api/login" || path == "/metrics" || path.startsWith("/api/worker/")
+        || path == "/api/admin/introspect") {
+        return AccessPublic;
+    }
+    if (path == "/api/submit") {
+        return AccessStudent;
+    }
+    if (path == "/api/publish" || path == "/api/grade" || path == "/api/rejudge" || path == "/api/plagiarism"
+        || path == "/api/testset/update" || path == "/api/judge/stats") {
+        return AccessStaff;
+    }
+    if (path.startsWith("/api/users/")) {
+        return AccessAdmin;
+    }
+    return AccessUser;
+}
+
+// Authorization: Bearer <令牌>
+QByteArray bearerToken(const QByteArray &authorization)
+{
+    if (!authorization.startsWith("Bearer ")) {
+        return QByteArray();
+    }
+    return authorization.mid(7).trimmed();
+}
+
+struct StorageMetric
+{
+    int durationUs;
+    int bytes;
+    const char *span;
+    const char *store;
+};
+
+StorageMetric storageMetric(const char *op, const char *store)
+{
+    Metrics *metrics = Metrics::instance();
+    QString labels = Metrics::label("op", op) + "," + Metrics::label("store", store);
+    return StorageMetric{
+        metrics->histogram("oj_storage_duration_seconds", "JSON 数据文件读写耗时", labels),
+        metrics->counter("oj_storage_bytes_total", "JSON 数据文件读写字节数", labels),
+        qstrcmp(op, "load") == 0 ? "storage.load" : "storage.save",
+        store
+    };
+}
+
+// 作用域结束时记录一次数据文件读写的耗时与字节数，并累加到当前请求的对应阶段；
+// 被采样的请求同时记一个追踪阶段
+class StorageTimer
+{
+public:
+    StorageTimer(const StorageMetric &metric, qint64 *phaseUs)
+        : metric(metric), phaseUs(phaseUs), span(metric.span, QLatin1String(metric.store)) { timer.start(); }
+    ~StorageTimer()
+    {
+        qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        Metrics::instance()->observe(metric.durationUs, elapsedUs);
+        Metrics::instance()->add(metric.bytes, bytes);
+        *phaseUs += elapsedUs;
+    }
+
+    qint64 bytes = 0;
+
+private:
+    StorageMetric metric;
+    qint64 *phaseUs;
+    TraceSpan span;
+    QElapsedTimer timer;
+};
+
+// 慢请求日志中的用户：登录名或请求中携带的用户ID
+QString requestUser(const QJsonObject &request)
+{
+    for (const char *key : {"username", "studentId", "teacherId", "userId"}) {
+        QJsonValue value = request.value(QLatin1String(key));
+        if (value.isString()) {
+            return value.toString();
+        }
+        if (value.isDouble()) {
+            return QString::number(value.toInt());
+        }
+    }
+    return QString();
+}
+
+// 在后台写入测试数据包，结果经信号排队回到主线程
+class TestSetPublishTask : public QRunnable
+{
+public:
+    TestSetPublishTask(Server *server, TestSetStore *store, qint64 publishId, int homeworkId,
+                       const QJsonArray &testCases)
+        : server(server), store(store), publishId(publishId), homeworkId(homeworkId), testCases(testCases) {}
+
+    void run() override
+    {
+        QList<int> changed;
+        int version = store->publish(homeworkId, testCases, &changed);
+        QJsonArray changedCases;
+        for (int index : changed) {
+            changedCases.append(index);
+        }
+        emit server->testSetPublished(publishId, version, changedCases);
+    }
+
+private:
+    Server *server;
+    TestSetStore *store;
+    qint64 publishId;
+    int homeworkId;
+    QJsonArray testCases;
+};
+
+// 比较令牌所用时间只取决于长度，不因前面相同的字节多少而变化
+bool sameToken(const QByteArray &a, const QByteArray &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    volatile unsigned char diff = 0;
+    for (int i = 0; i < a.size(); ++i) {
+        diff = diff | (unsigned char)(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+} // namespace
+
 
 Server::Server(QObject *parent)
     : QObject(parent)
     , tcpServer(new QTcpServer(this))
+    , lagTimer(new QTimer(this))
+    , loopLagMs(0)
+    , lastLagCheckMs(0)
+    , responseStatus(0)
+    , responseBytes(0)
+    , streamBytesMetric(Metrics::instance()->counter("oj_http_stream_bytes_total",
+                                                     "流式响应发出的数据块字节数"))
+    , lastRequestEndUs(0)
+    , judgeQueue(new JudgeQueue(1024, 0, this))
+    , compileCache(new CompileCache("judge_cache", 1LL << 30))
+    , checkerPool(new CheckerPool("judge_checkers"))
+    , verdictCache(new VerdictCache(4096))
+    , testSetStore(new TestSetStore("judge_testsets"))
+    , zygotePool(new ZygotePool(judgeQueue->workerCount(), this))
+    , runQueue(new JudgeQueue(64, qMax(2, QThread::idealThreadCount() / 4), this))
+    , runZygotePool(new ZygotePool(runQueue->workerCount(), this))
+    , leaseTimer(new QTimer(this))
+    , workerToken(qgetenv("OJ_WORKER_TOKEN"))
+    , adminToken(qgetenv("OJ_ADMIN_TOKEN"))
+    , authenticated(false)
+    , nextBatchId(1)
+    , rejudgeTimer(new QTimer(this))
+    , reservedHomeworkId(0)
+    , nextPublishId(1)
 {
     dbFilePath = "users.json";
     homeworkDbPath = "homeworks.json";  // 新增作业数据文件路径
     initDatabase();
     initHomeworkDatabase();  // 新增作业数据库初始化
+
+    // 登录会话有效期 OJ_SESSION_TTL_MIN 分钟，默认 8 小时
+    if (qEnvironmentVariableIsSet("OJ_SESSION_TTL_MIN")) {
+        sessions.setTtlMs(qgetenv("OJ_SESSION_TTL_MIN").toLongLong() * 60 * 1000);
+    }
+
+    // 总耗时超过 OJ_SLOW_MS（默认 500ms，0 为关闭）的请求写入慢请求日志
+    if (qEnvironmentVariableIsSet("OJ_SLOW_MS")) {
+        slowLog.setThresholdMs(qgetenv("OJ_SLOW_MS").toLongLong());
+    }
+
+    judgeQueue->setCompileCache(compileCache);
+    judgeQueue->setCheckerPool(checkerPool);
+    judgeQueue->setVerdictCache(verdictCache);
+    judgeQueue->setTestSetStore(testSetStore);
+    judgeQueue->setZygotePool(zygotePool);
+
+    // 样例运行只共享编译缓存，不读写评测结果缓存与测试数据包
+    runQueue->setCompileCache(compileCache);
+    runQueue->setZygotePool(runZygotePool);
+
+    // 评测结果由评测线程发出，排队回到主线程写回提交记录
+    connect(judgeQueue, &JudgeQueue::jobFinished, this, &Server::handleJudgeFinished);
+    connect(runQueue, &JudgeQueue::caseFinished, this, &Server::handleRunCase);
+    connect(runQueue, &JudgeQueue::jobFinished, this, &Server::handleRunFinished);
+    // 测试数据包由后台线程写入，一次只写一个，完成后回到主线程更新作业记录
+    testSetPool.setMaxThreadCount(1);
+    connect(this, &Server::testSetPublished, this, &Server::handleTestSetPublished, Qt::QueuedConnection);
+
+    serverClock.start();
+    lagTimer->setInterval(100);
+    connect(lagTimer, &QTimer::timeout, this, &Server::measureLoopLag);
+
+    leaseTimer->setInterval(1000);
+    connect(leaseTimer, &QTimer::timeout, this, &Server::expireWorkerLeases);
+
+    rejudgeTimer->setInterval(10000);
+    connect(rejudgeTimer, &QTimer::timeout, this, &Server::expireRejudgeBatches);
 }
 
 Server::~Server()
 {
+    // 先停评测线程与数据包写入，再释放它们使用的编译缓存和进程池
+    testSetPool.waitForDone();
+    judgeQueue->stop();
+    runQueue->stop();
+    zygotePool->stop();
+    runZygotePool->stop();
+    delete compileCache;
+    delete checkerPool;
+    delete verdictCache;
+    delete testSetStore;
 }
 
 bool Server::start(quint16 port)
@@ -33,6 +272,19 @@ bool Server::start(quint16 port)
     
     connect(tcpServer, &QTcpServer::newConnection, this, &Server::handleNewConnection);
     LOG_INFO(QString("服务器启动成功，监听端口：%1").arg(port));
+
+    lagTimer->start();
+    zygotePool->start();
+    runZygotePool->start();
+    judgeQueue->start();
+    runQueue->start();
+    if (!workerToken.isEmpty()) {
+        leaseTimer->start();
+        LOG_INFO("已启用远程评测节点");
+    }
+    rejudgeTimer->start();
+    resumePendingJudges();
+    rebuildPlagiarismIndex();
     return true;
 }
 
@@ -55,11 +307,13 @@ bool Server::initDatabase()
         return initTestUsers();
     }
     
-    return true;
+    return assignMissingUserIds();
 }
 
 QJsonObject Server::loadDatabase()
 {
+    static const StorageMetric metric = storageMetric("load", "users");
+    StorageTimer timer(metric, &profile.readUs);
     QFile file(dbFilePath);
     if (!file.open(QIODevice::ReadOnly)) {
         LOG_ERROR(QString("无法打开数据文件：%1").arg(file.errorString()));
@@ -68,6 +322,7 @@ QJsonObject Server::loadDatabase()
     
     QByteArray data = file.readAll();
     file.close();
+    timer.bytes = data.size();
     
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull() || !doc.isObject()) {
@@ -80,6 +335,8 @@ QJsonObject Server::loadDatabase()
 
 bool Server::saveDatabase(const QJsonObject &data)
 {
+    static const StorageMetric metric = storageMetric("save", "users");
+    StorageTimer timer(metric, &profile.persistUs);
     QFile file(dbFilePath);
     if (!file.open(QIODevice::WriteOnly)) {
         LOG_ERROR(QString("无法写入数据文件：%1").arg(file.errorString()));
@@ -87,7 +344,7 @@ bool Server::saveDatabase(const QJsonObject &data)
     }
     
     QJsonDocument doc(data);
-    file.write(doc.toJson(QJsonDocument::Indented));
+    timer.bytes = file.write(doc.toJson(QJsonDocument::Indented));
     file.close();
     
     return true;
@@ -113,6 +370,7 @@ bool Server::initTestUsers()
     
     for (const auto &user : testUsers) {
         QJsonObject userObj;
+        userObj["id"] = users.size() + 1;
         userObj["username"] = user.first;
         userObj["password"] = "123456";
         userObj["role"] = user.second;
@@ -127,11 +385,45 @@ bool Server::initTestUsers()
     return saveDatabase(db);
 }
 
+bool Server::assignMissingUserIds()
+{
+    // 旧版本创建的测试用户没有 ID，会话以用户 ID 区分身份，按新增用户的规则补上
+    QJsonObject db = loadDatabase();
+    QJsonArray users = db["users"].toArray();
+    
+    int maxId = 0;
+    for (const QJsonValue &val : users) {
+        maxId = qMax(maxId, val.toObject()["id"].toInt());
+    }
+    
+    bool changed = false;
+    for (int i = 0; i < users.size(); ++i) {
+        QJsonObject user = users[i].toObject();
+        if (user["id"].toInt() > 0) {
+            continue;
+        }
+        user["id"] = ++maxId;
+        users[i] = user;
+        changed = true;
+        LOG_INFO(QString("为用户 %1 分配ID：%2").arg(user["username"].toString()).arg(maxId));
+    }
+    
+    if (!changed) {
+        return true;
+    }
+    db["users"] = users;
+    return saveDatabase(db);
+}
+
 void Server::handleNewConnection()
 {
     QTcpSocket *socket = tcpServer->nextPendingConnection();
     connect(socket, &QTcpSocket::readyRead, this, &Server::handleReadyRead);
     connect(socket, &QTcpSocket::disconnected, this, &Server::handleDisconnected);
+    ConnectionInfo info;
+    info.peer = QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+    info.connectedAtUs = serverClock.nsecsElapsed() / 1000;
+    connections.insert(socket, info);
     LOG_INFO(QString("新客户端连接：%1").arg(socket->peerAddress().toString()));
 }
 
@@ -140,78 +432,188 @@ void Server::handleReadyRead()
     QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
     if (!socket) return;
     
-    QByteArray &buffer = buffers[socket];
-    buffer.append(socket->readAll());
-    
-    // 检查是否收到完整的 HTTP 请求
-    if (!buffer.contains("\r\n\r\n")) {
-        return; // 等待更多数据
-    }
-    
-    // 解析 HTTP 请求
-    QString httpRequest = QString::fromUtf8(buffer);
-    QStringList requestLines = httpRequest.split("\r\n");
-    
-    if (requestLines.isEmpty()) {
-        LOG_ERROR("收到空的 HTTP 请求");
-        socket->disconnectFromHost();
-        return;
-    }
-    
-    // 解析请求行
-    QStringList requestLine = requestLines[0].split(" ");
-    if (requestLine.size() < 3) {
-        LOG_ERROR("无效的 HTTP 请求行");
-        socket->disconnectFromHost();
-        return;
+    qint64 readyAtUs = serverClock.nsecsElapsed() / 1000;
+    HttpRequestParser &parser = parsers[socket];
+    if (parser.isIdle()) {
+        requestStartUs.insert(socket, readyAtUs);
     }
+    parser.append(socket->readAll());
     
-    QString method = requestLine[0];
-    QString path = requestLine[1];
-    
-    // 查找请求体
-    int bodyStart = buffer.indexOf("\r\n\r\n") + 4;
-    QByteArray body = buffer.mid(bodyStart);
-    
-    // 解析 Content-Length
-    int contentLength = 0;
-    for (const QString &line : requestLines) {
-        if (line.startsWith("Content-Length: ")) {
-            contentLength = line.mid(16).toInt();
-            break;
+    // 一次可能收到多个请求（流水线），逐个处理；处理过程中连接可能被关闭
+    while (socket->state() == QAbstractSocket::ConnectedState) {
+        auto it = parsers.find(socket);
+        if (it == parsers.end()) {
+            return;
         }
-    }
-    
-    // 检查是否收到完整的请求体
-    if (body.length() < contentLength) {
-        return; // 等待更多数据
-    }
-    
-    LOG_INFO(QString("收到 HTTP %1 请求: %2").arg(method).arg(path));
-    
-    // 处理请求
-    if (method == "POST") {
-        QJsonDocument doc = QJsonDocument::fromJson(body);
-        if (doc.isNull() || !doc.isObject()) {
-            sendHttpError(socket, 400, "无效的 JSON 数据");
+        HttpRequest httpRequest;
+        QString error;
+        HttpRequestParser::Status status = it->next(&httpRequest, &error);
+        if (status == HttpRequestParser::NeedMore) {
+            return; // 等待更多数据
+        }
+        if (status == HttpRequestParser::Invalid) {
+            LOG_ERROR(QString("无效的 HTTP 请求：%1").arg(error));
+            socket->disconnectFromHost();
             return;
         }
         
-        QJsonObject request = doc.object();
-        processRequest(socket, request, path);
-    } else {
-        sendHttpError(socket, 405, "方法不允许");
+        // 请求完整后才分配追踪ID，未收完的数据不占用采样名额
+        RequestTrace trace;
+        TraceSpan parseSpan("http.parse");
+        ++connections[socket].requests;
+        QString method = QString::fromLatin1(httpRequest.method);
+        QString path = QString::fromUtf8(httpRequest.path);
+        LOG_INFO_KV("http.request", {{"method", method}, {"path", path}, {"bytes", httpRequest.contentLength},
+                                     {"trace", trace.id()}});
+        Metrics::instance()->add(metricsFor(path).bytesIn, httpRequest.wireBytes);
+        profile = RequestProfile();
+        profile.readyAtUs = readyAtUs;
+        profile.payloadBytes = httpRequest.contentLength;
+        session = Session();
+        sessionToken = bearerToken(httpRequest.authorization);
+        authenticated = sessions.lookup(sessionToken, &session);
+        
+        // 处理请求；GET 只用于指标抓取
+        if (method == "POST") {
+            QJsonDocument doc = QJsonDocument::fromJson(httpRequest.body);
+            if (doc.isNull() || !doc.isObject()) {
+                sendHttpError(socket, 400, "无效的 JSON 数据");
+            } else {
+                QJsonObject request = doc.object();
+                parseSpan.end();
+                profile.parseUs = serverClock.nsecsElapsed() / 1000 - readyAtUs;
+                processRequest(socket, request, path);
+            }
+        } else if (method == "GET" && path == "/metrics") {
+            parseSpan.end();
+            profile.parseUs = serverClock.nsecsElapsed() / 1000 - readyAtUs;
+            processRequest(socket, QJsonObject(), path);
+        } else {
+            sendHttpError(socket, 405, "方法不允许");
+        }
+        
+        // 同一批数据中的下一个请求从本次数据到达时开始计时，排队时间计入其延迟
+        it = parsers.find(socket);
+        if (it == parsers.end() || it->isIdle()) {
+            requestStartUs.remove(socket);
+        } else {
+            requestStartUs.insert(socket, readyAtUs);
+        }
     }
-    
-    // 清除已处理的数据
-    buffer.clear();
 }
 
 void Server::processRequest(QTcpSocket *socket, const QJsonObject &request, const QString &path)
 {
+    AdmissionControl::RouteClass routeClass = AdmissionControl::classify(path);
+    AdmissionControl::Load load;
+    load.loopLagMs = loopLagMs;
+    load.pendingRequests = requestStartUs.size() - 1;
+    load.judgeBacklog = judgeQueue->pendingCount();
+    load.judgeCapacity = judgeQueue->capacity();
+    responseStatus = 0;
+    responseBytes = 0;
+    qint64 handlerStartUs = serverClock.nsecsElapsed() / 1000;
+    qint64 startUs = requestStartUs.value(socket, handlerStartUs);
+    int retryAfter = admission.admit(routeClass, path, load);
+    if (retryAfter > 0) {
+        sendHttpError(socket, 503, "服务器繁忙，请稍后重试", retryAfter);
+    } else {
+        TraceSpan dispatchSpan("http.dispatch", path);
+        dispatchRequest(socket, request, path);
+    }
+    qint64 endUs = serverClock.nsecsElapsed() / 1000;
+    if (retryAfter == 0) {
+        admission.record(routeClass, endUs - startUs);
+    }
+
+    // 处理函数可能只建立了流式响应或留待评测完成后回复，此时按 200 计
+    Metrics *metrics = Metrics::instance();
+    RouteMetrics &route = metricsFor(path);
+    int status = responseStatus > 0 ? responseStatus : 200;
+    auto counter = route.requests.find(status);
+    if (counter == route.requests.end()) {
+        QString labels = Metrics::label("route", routeLabel(path)) + ","
+            + Metrics::label("status", QString::number(status));
+        counter = route.requests.insert(status, metrics->counter(
+            "oj_http_requests_total", "按路由与状态码统计的请求数", labels));
+    }
+    metrics->add(counter.value());
+    metrics->add(route.bytesOut, responseBytes);
+    metrics->observe(route.handlerUs, endUs - handlerStartUs);
+    metrics->observe(route.totalUs, endUs - startUs);
+
+    if (slowLog.isSlow(endUs - startUs)) {
+        // 上一个请求结束后 1ms 内才开始处理本请求的数据，说明数据已到达却在等事件循环
+        bool queuedBehind = lastRequestEndUs > 0 && profile.readyAtUs >= lastRequestEndUs
+            && profile.readyAtUs - lastRequestEndUs < 1000;
+        qint64 handlerUs = endUs - handlerStartUs;
+        qint64 mutationUs = qMax<qint64>(0, handlerUs - profile.readUs - profile.persistUs - profile.writeUs);
+        QJsonObject entry{
+            {"route", path},
+            {"user", authenticated ? session.username : requestUser(request)},
+            {"status", status},
+            {"payloadBytes", profile.payloadBytes},
+            {"totalMs", SlowRequestLog::toMs(endUs - startUs)},
+            {"waitMs", SlowRequestLog::toMs(qMax<qint64>(0, handlerStartUs - startUs - profile.parseUs))},
+            {"phasesMs", QJsonObject{
+                {"parse", SlowRequestLog::toMs(profile.parseUs)},
+                {"read", SlowRequestLog::toMs(profile.readUs)},
+                {"mutation", SlowRequestLog::toMs(mutationUs)},
+                {"persist", SlowRequestLog::toMs(profile.persistUs)},
+                {"write", SlowRequestLog::toMs(profile.writeUs)}
+            }},
+            {"queuedBehind", queuedBehind},
+            {"loopLagMs", loopLagMs},
+            {"trace", QString::number(Tracer::currentTraceId())}
+        };
+        if (queuedBehind) {
+            entry["behind"] = lastRoute;
+        }
+        slowLog.record(entry);
+    }
+    lastRequestEndUs = serverClock.nsecsElapsed() / 1000;
+    lastRoute = path;
+}
+
+Server::RouteMetrics &Server::metricsFor(const QString &path)
+{
+    QString route = routeLabel(path);
+    auto it = routeMetrics.find(route);
+    if (it == routeMetrics.end()) {
+        Metrics *metrics = Metrics::instance();
+        QString labels = Metrics::label("route", route);
+        RouteMetrics entry;
+        entry.handlerUs = metrics->histogram("oj_http_handler_duration_seconds",
+                                             "处理函数耗时，不含排队", labels);
+        entry.totalUs = metrics->histogram("oj_http_request_duration_seconds",
+                                           "从收到第一个字节到处理完成的耗时", labels);
+        entry.bytesIn = metrics->counter("oj_http_request_bytes_total", "请求字节数（含请求头）", labels);
+        entry.bytesOut = metrics->counter("oj_http_response_bytes_total", "响应字节数（含响应头）", labels);
+        it = routeMetrics.insert(route, entry);
+    }
+    return it.value();
+}
+
+void Server::noteResponse(int statusCode, qint64 bytes)
+{
+    if (responseStatus == 0) {
+        responseStatus = statusCode;
+    }
+    responseBytes += bytes;
+}
+
+void Server::dispatchRequest(QTcpSocket *socket, const QJsonObject &request, const QString &path)
+{
+    if (!authorize(socket, path)) {
+        return;
+    }
+
     if (path == "/api/login") {
         handleLogin(socket, request);
     }
+    else if (path == "/api/logout") {
+        handleLogout(socket, request);
+    }
     else if (path == "/api/submit") {
         handleSubmission(socket, request);
     }
@@ -236,6 +638,36 @@ void Server::processRequest(QTcpSocket *socket, const QJsonObject &request, cons
     else if (path == "/api/users/delete") {
         handleUserDelete(socket, request);
     }
+    else if (path == "/api/judge/stats") {
+        handleJudgeStats(socket, request);
+    }
+    else if (path == "/api/rejudge") {
+        handleRejudge(socket, request);
+    }
+    else if (path == "/api/worker/lease") {
+        handleWorkerLease(socket, request);
+    }
+    else if (path == "/api/worker/heartbeat") {
+        handleWorkerHeartbeat(socket, request);
+    }
+    else if (path == "/api/worker/result") {
+        handleWorkerResult(socket, request);
+    }
+    else if (path == "/api/plagiarism") {
+        handlePlagiarism(socket, request);
+    }
+    else if (path == "/api/run") {
+        handleRun(socket, request);
+    }
+    else if (path == "/api/testset/update") {
+        handleTestSetUpdate(socket, request);
+    }
+    else if (path == "/metrics") {
+        handleMetrics(socket, request);
+    }
+    else if (path == "/api/admin/introspect") {
+        handleIntrospect(socket, request);
+    }
     else {
         sendHttpError(socket, 404, "未找到请求的资源");
     }
@@ -243,15 +675,19 @@ void Server::processRequest(QTcpSocket *socket, const QJsonObject &request, cons
 
 void Server::handleSubmission(QTcpSocket *socket, const QJsonObject &data)
 {
+    // 提交人取自登录会话，忽略客户端填写的学生信息
     int homeworkId = data["homeworkId"].toInt();
-    int studentId = data["studentId"].toInt();
-    QString studentName = data["studentName"].toString();
+    int studentId = session.userId;
+    QString studentName = session.username;
     QString answer = data["answer"].toString();
+    QString language = data["language"].toString();
     
     // 从作业数据库中获取作业信息
     QJsonObject homeworkDb = loadHomeworkDatabase();
     QJsonArray homeworks = homeworkDb["homeworks"].toArray();
     bool found = false;
+    bool codeAnswer = false;
+    qint64 jobId = -1;
     
     // 查找对应的作业
     for (int i = 0; i < homeworks.size(); ++i) {
@@ -277,10 +713,25 @@ void Server::handleSubmission(QTcpSocket *socket, const QJsonObject &data)
             newSubmission["studentId"] = studentId;
             newSubmission["studentName"] = studentName;
             newSubmission["answer"] = answer;
+            if (homework["judgeType"].toString() == "code") {
+                newSubmission["language"] = Judger::isSupportedLanguage(language)
+                    ? language : homework["language"].toString("cpp");
+            }
             newSubmission["submitTime"] = QDateTime::currentDateTime().toString(Qt::ISODate);
             newSubmission["status"] = "已提交";
             newSubmission["score"] = QJsonValue::Null;
             
+            // 配置了评测数据的作业进入评测队列，结果稍后异步写回
+            if (Judger::canJudge(homework)) {
+                jobId = enqueueJudge(homework, newSubmission);
+                if (jobId >= 0) {
+                    newSubmission["status"] = "评测中";
+                    newSubmission["jobId"] = QString::number(jobId);
+                } else {
+                    LOG_WARNING(QString("评测队列已满，学生 %1 的提交转为人工评阅").arg(studentName));
+                }
+            }
+            
             // 更新或添加提交记录
             if (submissionIndex >= 0) {
                 submissions.replace(submissionIndex, newSubmission);
@@ -292,6 +743,7 @@ void Server::handleSubmission(QTcpSocket *socket, const QJsonObject &data)
             
             homework["submissions"] = submissions;
             homeworks[i] = homework;
+            codeAnswer = homework["judgeType"].toString() == "code";
             found = true;
             break;
         }
@@ -300,9 +752,11 @@ void Server::handleSubmission(QTcpSocket *socket, const QJsonObject &data)
     if (found) {
         homeworkDb["homeworks"] = homeworks;
         if (saveHomeworkDatabase(homeworkDb)) {
+            checkPlagiarism(homeworkId, studentId, studentName, answer, codeAnswer);
             sendHttpResponse(socket, {
                 {"success", true},
-                {"message", "作业提交成功"}
+                {"message", "作业提交成功"},
+                {"jobId", jobId >= 0 ? QJsonValue(QString::number(jobId)) : QJsonValue()}
             });
         } else {
             LOG_ERROR(QString("保存学生 %1 的提交记录失败").arg(studentName));
@@ -330,6 +784,13 @@ void Server::handleHomeworkList(QTcpSocket *socket, const QJsonObject &data)
             if (!homework.contains("submissions")) {
                 homework["submissions"] = QJsonArray();
             }
+            // 标准答案与测试数据不下发给客户端
+            homework.remove("referenceAnswer");
+            homework.remove("checker");
+            if (homework.contains("testCases")) {
+                homework["testCaseCount"] = homework["testCases"].toArray().size();
+                homework.remove("testCases");
+            }
             filteredHomeworks.append(homework);
         }
     }
@@ -353,11 +814,26 @@ void Server::handleLogin(QTcpSocket *socket, const QJsonObject &data)
         if (user["username"].toString() == username) {
             if (user["password"].toString() == password) {
                 if (user["status"].toString() != "disabled") {
+                    // 会话以用户 ID 区分身份，没有有效 ID 的用户不能登录
+                    int userId = user["id"].toInt();
+                    if (userId <= 0) {
+                        LOG_ERROR(QString("用户 %1 没有有效的ID，拒绝登录").arg(username));
+                        sendHttpError(socket, 500, "用户数据缺少ID");
+                        return;
+                    }
+                    // 之后的请求凭令牌取得身份，不再读用户数据文件
+                    QByteArray token = sessions.issue(userId, username, user["role"].toString());
+                    if (token.isEmpty()) {
+                        sendHttpError(socket, 500, "创建会话失败");
+                        return;
+                    }
                     LOG_INFO(QString("用户 %1 登录成功").arg(username));
                     sendHttpResponse(socket, {
                         {"success", true},
-                        {"userId", user["id"].toInt()},  // 返回正确的用户ID
-                        {"role", user["role"].toString()}
+                        {"userId", userId},  // 返回正确的用户ID
+                        {"role", user["role"].toString()},
+                        {"token", QString::fromLatin1(token)},
+                        {"expiresIn", sessions.ttlMs() / 1000}
                     });
                     return;
                 } else {
@@ -373,11 +849,21 @@ void Server::handleLogin(QTcpSocket *socket, const QJsonObject &data)
     sendHttpError(socket, 404, "用户不存在");
 }
 
+void Server::handleLogout(QTcpSocket *socket, const QJsonObject &data)
+{
+    Q_UNUSED(data);
+    sessions.revoke(sessionToken);
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"message", "已退出登录"}
+    });
+}
+
 void Server::handlePublishHomework(QTcpSocket *socket, const QJsonObject &data)
 {
-    // 直接使用客户端传来的教师信息
-    int teacherId = data["teacherId"].toInt();
-    QString teacherName = data["teacherName"].toString();
+    // 发布人取自登录会话
+    int teacherId = session.userId;
+    QString teacherName = session.username;
     
     // 从请求中获取作业信息
     QString title = data["title"].toString();
@@ -385,12 +871,15 @@ void Server::handlePublishHomework(QTcpSocket *socket, const QJsonObject &data)
     QString deadline = data["deadline"].toString();
     int courseId = data["courseId"].toInt();
     
-    // 将作业信息保存到作业数据库
-    QJsonObject homeworkDb = loadHomeworkDatabase();
-    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    // 作业ID：测试数据包在后台写入期间，已分配但尚未写入的ID不能再分给别的作业
+    int homeworkId = reservedHomeworkId;
+    for (const QJsonValue &val : loadHomeworkDatabase()["homeworks"].toArray()) {
+        homeworkId = qMax(homeworkId, val.toObject()["id"].toInt());
+    }
+    reservedHomeworkId = ++homeworkId;
     
     QJsonObject homework;
-    homework["id"] = homeworks.size() + 1;
+    homework["id"] = homeworkId;
     homework["title"] = title;
     homework["description"] = description;
     homework["deadline"] = deadline;
@@ -399,18 +888,74 @@ void Server::handlePublishHomework(QTcpSocket *socket, const QJsonObject &data)
     homework["teacherName"] = teacherName;
     homework["createdAt"] = QDateTime::currentDateTime().toString(Qt::ISODate);
     
+    // 可选的自动评测配置
+    if (data["judgeType"].toString() == "code") {
+        homework["judgeType"] = "code";
+        homework["language"] = data["language"].toString("cpp");
+        homework["timeLimitMs"] = data["timeLimitMs"].toInt(1000);
+        homework["memoryLimitMb"] = data["memoryLimitMb"].toInt(256);
+        // 公开样例：[{"input": "...", "output": "..."}]，随作业下发，供学生提交前试运行
+        QJsonArray sampleCases = data["sampleCases"].toArray();
+        if (!sampleCases.isEmpty()) {
+            homework["sampleCases"] = sampleCases;
+        }
+        // 输出比较方式：exact / line / token / float
+        homework["checkMode"] = data["checkMode"].toString("line");
+        if (data.contains("floatEpsilon")) {
+            homework["floatEpsilon"] = data["floatEpsilon"].toDouble();
+        }
+        // 特判程序：{"language": "cpp", "source": "..."}，配置后取代 checkMode
+        QJsonObject checker = data["checker"].toObject();
+        if (!checker["source"].toString().isEmpty()) {
+            homework["checker"] = QJsonObject{
+                {"language", checker["language"].toString("cpp")},
+                {"source", checker["source"].toString()}
+            };
+        }
+        homework["fullScore"] = data["fullScore"].toInt(100);
+    } else if (data.contains("referenceAnswer")) {
+        homework["referenceAnswer"] = data["referenceAnswer"].toString();
+        homework["fullScore"] = data["fullScore"].toInt(100);
+    }
+    
+    // 测试数据写入版本化的数据包，作业记录只保存版本号；数据包在后台写入，完成后再保存作业并回复
+    QJsonArray testCases = data["testCases"].toArray();
+    if (homework["judgeType"].toString() == "code" && !testCases.isEmpty()) {
+        publishTestSet(socket, homeworkId, testCases, homework);
+        return;
+    }
+    saveNewHomework(socket, homework);
+}
+
+void Server::saveNewHomework(QTcpSocket *socket, QJsonObject homework)
+{
+    QString teacherName = homework["teacherName"].toString();
+    QString title = homework["title"].toString();
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
     homeworks.append(homework);
     homeworkDb["homeworks"] = homeworks;
     
-    if (saveHomeworkDatabase(homeworkDb)) {
+    bool saved = saveHomeworkDatabase(homeworkDb);
+    if (saved) {
         LOG_INFO(QString("教师 %1 发布新作业：%2").arg(teacherName).arg(title));
+    } else {
+        LOG_ERROR(QString("教师 %1 发布作业失败：%2").arg(teacherName).arg(title));
+    }
+    // 测试数据写入期间客户端可能已断开
+    if (!socket) {
+        return;
+    }
+    if (saved) {
+        homework.remove("referenceAnswer");
+        homework.remove("testCases");
+        homework.remove("checker");
         sendHttpResponse(socket, {
             {"success", true},
             {"message", "作业发布成功"},
             {"homework", homework}
         });
     } else {
-        LOG_ERROR(QString("教师 %1 发布作业失败：%2").arg(teacherName).arg(title));
         sendHttpError(socket, 500, "保存作业信息失败");
     }
 }
@@ -564,6 +1109,8 @@ void Server::handleUserEdit(QTcpSocket *socket, const QJsonObject &data)
     if (found) {
         db["users"] = users;
         if (saveDatabase(db)) {
+            // 密码、角色或状态变化后需要重新登录
+            sessions.revokeUser(userId);
             LOG_INFO(QString("用户 %1 更新成功").arg(userId));
             sendHttpResponse(socket, {
                 {"success", true},
@@ -598,6 +1145,7 @@ void Server::handleUserDelete(QTcpSocket *socket, const QJsonObject &data)
     if (found) {
         db["users"] = users;
         if (saveDatabase(db)) {
+            sessions.revokeUser(userId);
             LOG_INFO(QString("用户 %1 删除成功").arg(userId));
             sendHttpResponse(socket, {
                 {"success", true},
@@ -613,10 +1161,163 @@ void Server::handleUserDelete(QTcpSocket *socket, const QJsonObject &data)
     }
 }
 
+void Server::handleJudgeStats(QTcpSocket *socket, const QJsonObject &data)
+{
+    Q_UNUSED(data);
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"queue", QJsonObject{
+            {"pending", judgeQueue->pendingCount()},
+            {"capacity", judgeQueue->capacity()},
+            {"workers", judgeQueue->workerCount()},
+            {"scheduler", judgeQueue->stats()}
+        }},
+        {"compileCache", compileCache->stats()},
+        {"checkers", checkerPool->stats()},
+        {"verdictCache", verdictCache->stats()},
+        {"spawn", zygotePool->stats()},
+        {"runQueue", QJsonObject{
+            {"pending", runQueue->pendingCount()},
+            {"capacity", runQueue->capacity()},
+            {"workers", runQueue->workerCount()},
+            {"streams", runStreams.size()},
+            {"spawn", runZygotePool->stats()}
+        }},
+        {"remote", workerLeases.stats()},
+        {"admission", admission.stats()},
+        {"loopLagMs", loopLagMs}
+    });
+}
+
+void Server::handleMetrics(QTcpSocket *socket, const QJsonObject &data)
+{
+    Q_UNUSED(data);
+    Metrics *metrics = Metrics::instance();
+    static const int connectionsGauge = metrics->gauge("oj_http_open_connections", "打开的客户端连接数");
+    static const int buffersGauge = metrics->gauge("oj_http_buffers", "有未处理完请求数据的连接数");
+    static const int bufferedGauge = metrics->gauge("oj_http_buffered_bytes", "接收缓冲区中的请求字节数");
+    static const int reservedGauge = metrics->gauge("oj_http_buffer_capacity_bytes", "接收缓冲区已分配的字节数");
+    static const int pendingGauge = metrics->gauge("oj_judge_queue_pending", "等待评测的任务数");
+    static const int lagGauge = metrics->gauge("oj_event_loop_lag_ms", "事件循环延迟（毫秒）");
+
+    // 仪表在抓取时取值
+    qint64 buffered = 0;
+    qint64 reserved = 0;
+    int pending = 0;
+    for (const HttpRequestParser &parser : parsers) {
+        buffered += parser.buffered();
+        reserved += parser.capacity();
+        pending += parser.isIdle() ? 0 : 1;
+    }
+    metrics->set(connectionsGauge, connections.size());
+    metrics->set(buffersGauge, pending);
+    metrics->set(bufferedGauge, buffered);
+    metrics->set(reservedGauge, reserved);
+    metrics->set(pendingGauge, judgeQueue->pendingCount());
+    metrics->set(lagGauge, loopLagMs);
+
+    QByteArray body = metrics->exposition();
+    QByteArray httpResponse = "HTTP/1.1 200 OK\r\n"
+                             "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                             "Content-Length: " + QByteArray::number(body.length()) + "\r\n"
+                             "\r\n";
+    httpResponse.append(body);
+
+    socket->write(httpResponse);
+    socket->flush();
+    noteResponse(200, httpResponse.size());
+}
+
+bool Server::verifyAdmin(QTcpSocket *socket, const QJsonObject &data)
+{
+    // 管理员登录会话，或运维脚本使用的 OJ_ADMIN_TOKEN
+    if (authenticated && session.role == "admin") {
+        return true;
+    }
+    if (adminToken.isEmpty()) {
+        sendHttpError(socket, 403, "未启用运维接口");
+        return false;
+    }
+    if (!sameToken(data["token"].toString().toUtf8(), adminToken)) {
+        sendHttpError(socket, 401, "运维接口认证失败");
+        return false;
+    }
+    return true;
+}
+
+void Server::handleIntrospect(QTcpSocket *socket, const QJsonObject &data)
+{
+    if (!verifyAdmin(socket, data)) {
+        return;
+    }
+
+    // 只读取内存中的计数与各组件自己的统计，不读数据文件，也不长时间持有评测线程使用的锁
+    qint64 nowUs = serverClock.nsecsElapsed() / 1000;
+    int limit = qMax(0, data["limit"].toInt(200));
+    QJsonArray connectionList;
+    for (auto it = connections.constBegin(); it != connections.constEnd(); ++it) {
+        if (connectionList.size() >= limit) {
+            break;
+        }
+        QTcpSocket *peer = it.key();
+        auto parser = parsers.constFind(peer);
+        qint64 unparsed = parser == parsers.constEnd() ? 0 : parser->buffered();
+        connectionList.append(QJsonObject{
+            {"peer", it->peer},
+            {"ageMs", (nowUs - it->connectedAtUs) / 1000},
+            {"requests", it->requests},
+            {"bufferedIn", unparsed + peer->bytesAvailable()},
+            {"bufferedOut", peer->bytesToWrite()},
+            {"inRequest", requestStartUs.contains(peer)}
+        });
+    }
+
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"uptimeMs", serverClock.elapsed()},
+        {"loopLagMs", loopLagMs},
+        {"connections", QJsonObject{
+            {"open", connections.size()},
+            {"list", connectionList},
+            {"truncated", connections.size() > connectionList.size()}
+        }},
+        {"stores", QJsonObject{
+            {"usersFileBytes", QFileInfo(dbFilePath).size()},
+            {"homeworksFileBytes", QFileInfo(homeworkDbPath).size()},
+            {"plagiarismIndex", plagiarismIndex.stats()},
+            {"openTestPacks", testSetStore->openPackCount()},
+            {"sessions", sessions.stats()},
+            {"rejudgeBatches", rejudgeBatches.size()},
+            {"runStreams", runStreams.size()},
+            {"workerLeases", workerLeases.stats()}
+        }},
+        {"judge", QJsonObject{
+            {"pending", judgeQueue->pendingCount()},
+            {"capacity", judgeQueue->capacity()},
+            {"workers", judgeQueue->workerCount()},
+            {"runPending", runQueue->pendingCount()},
+            {"runCapacity", runQueue->capacity()}
+        }},
+        {"caches", QJsonObject{
+            {"compile", compileCache->stats()},
+            {"verdict", verdictCache->stats()}
+        }},
+        {"writers", QJsonObject{
+            {"log", Logger::getInstance()->stats()},
+            {"trace", Tracer::instance()->stats()},
+            {"slowLog", slowLog.stats()}
+        }},
+        {"admission", admission.stats()}
+    });
+}
+
 void Server::sendHttpResponse(QTcpSocket *socket, const QJsonObject &response)
 {
+    qint64 startUs = serverClock.nsecsElapsed() / 1000;
+    TraceSpan serializeSpan("http.serialize");
     QJsonDocument doc(response);
     QByteArray jsonData = doc.toJson();
+    serializeSpan.end();
     
     QByteArray httpResponse = "HTTP/1.1 200 OK\r\n"
                              "Content-Type: application/json\r\n"
@@ -625,12 +1326,16 @@ void Server::sendHttpResponse(QTcpSocket *socket, const QJsonObject &response)
                              "\r\n";
     httpResponse.append(jsonData);
     
+    TraceSpan writeSpan("http.write");
     socket->write(httpResponse);
     socket->flush();
+    noteResponse(200, httpResponse.size());
+    profile.writeUs += serverClock.nsecsElapsed() / 1000 - startUs;
 }
 
-void Server::sendHttpError(QTcpSocket *socket, int statusCode, const QString &message)
+void Server::sendHttpError(QTcpSocket *socket, int statusCode, const QString &message, int retryAfter)
 {
+    qint64 startUs = serverClock.nsecsElapsed() / 1000;
     QJsonObject errorResponse;
     errorResponse["success"] = false;
     errorResponse["error"] = message;
@@ -642,17 +1347,51 @@ void Server::sendHttpError(QTcpSocket *socket, int statusCode, const QString &me
                                     "Content-Type: application/json\r\n"
                                     "Content-Length: %3\r\n"
                                     "Access-Control-Allow-Origin: *\r\n"
+                                    "%4"
                                     "\r\n")
                                     .arg(statusCode)
                                     .arg(getStatusText(statusCode))
                                     .arg(jsonData.length())
+                                    .arg(retryAfter > 0 ? QString("Retry-After: %1\r\n").arg(retryAfter) : QString())
                                     .toUtf8();
     httpResponse.append(jsonData);
     
+    TraceSpan writeSpan("http.write");
     socket->write(httpResponse);
     socket->flush();
+    writeSpan.end();
+    noteResponse(statusCode, httpResponse.size());
+    profile.writeUs += serverClock.nsecsElapsed() / 1000 - startUs;
     
-    LOG_WARNING(QString("发送 HTTP 错误 %1: %2").arg(statusCode).arg(message));
+    // 过载拒绝由 AdmissionControl 汇总记录，避免过载时日志本身成为负担
+    if (statusCode != 503 || retryAfter == 0) {
+        LOG_WARNING(QString("发送 HTTP 错误 %1: %2").arg(statusCode).arg(message));
+    }
+}
+
+void Server::beginChunkedResponse(QTcpSocket *socket)
+{
+    noteResponse(200, qMax<qint64>(0, socket->write("HTTP/1.1 200 OK\r\n"
+                                    "Content-Type: application/x-ndjson\r\n"
+                                    "Transfer-Encoding: chunked\r\n"
+                                    "Access-Control-Allow-Origin: *\r\n"
+                                    "\r\n")));
+    socket->flush();
+}
+
+// 数据块多在处理函数返回后发出，不计入所属路由，单独统计
+void Server::sendChunk(QTcpSocket *socket, const QJsonObject &object)
+{
+    QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact) + "\n";
+    Metrics::instance()->add(streamBytesMetric, qMax<qint64>(0,
+        socket->write(QByteArray::number(line.size(), 16) + "\r\n" + line + "\r\n")));
+    socket->flush();
+}
+
+void Server::endChunkedResponse(QTcpSocket *socket)
+{
+    Metrics::instance()->add(streamBytesMetric, qMax<qint64>(0, socket->write("0\r\n\r\n")));
+    socket->flush();
 }
 
 QString Server::getStatusText(int statusCode)
@@ -664,7 +1403,9 @@ QString Server::getStatusText(int statusCode)
         case 403: return "Forbidden";
         case 404: return "Not Found";
         case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
         case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
         default: return "Unknown";
     }
 }
@@ -673,7 +1414,9 @@ void Server::handleDisconnected()
 {
     QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
     if (socket) {
-        buffers.remove(socket);
+        parsers.remove(socket);
+        requestStartUs.remove(socket);
+        connections.remove(socket);
         socket->deleteLater();
         qDebug() << "客户端断开连接";
     }
@@ -694,6 +1437,26 @@ bool Server::verifyUser(const QString &username, const QString &password)
     return false;
 }
 
+bool Server::authorize(QTcpSocket *socket, const QString &path)
+{
+    RouteAccess access = routeAccess(path);
+    if (access == AccessPublic) {
+        return true;
+    }
+    if (!authenticated) {
+        sendHttpError(socket, 401, "未登录或登录已过期");
+        return false;
+    }
+    bool allowed = access == AccessUser
+        || (access == AccessStudent && session.role == "student")
+        || (access == AccessStaff && (session.role == "teacher" || session.role == "admin"))
+        || (access == AccessAdmin && session.role == "admin");
+    if (!allowed) {
+        sendHttpError(socket, 403, "没有权限执行此操作");
+    }
+    return allowed;
+}
+
 bool Server::initHomeworkDatabase()
 {
     QFile file(homeworkDbPath);
@@ -712,6 +1475,8 @@ bool Server::initHomeworkDatabase()
 
 QJsonObject Server::loadHomeworkDatabase()
 {
+    static const StorageMetric metric = storageMetric("load", "homeworks");
+    StorageTimer timer(metric, &profile.readUs);
     QFile file(homeworkDbPath);
     if (!file.open(QIODevice::ReadOnly)) {
         LOG_ERROR(QString("无法打开作业数据文件：%1").arg(file.errorString()));
@@ -720,6 +1485,7 @@ QJsonObject Server::loadHomeworkDatabase()
     
     QByteArray data = file.readAll();
     file.close();
+    timer.bytes = data.size();
     
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull() || !doc.isObject()) {
@@ -732,6 +1498,8 @@ QJsonObject Server::loadHomeworkDatabase()
 
 bool Server::saveHomeworkDatabase(const QJsonObject &data)
 {
+    static const StorageMetric metric = storageMetric("save", "homeworks");
+    StorageTimer timer(metric, &profile.persistUs);
     QFile file(homeworkDbPath);
     if (!file.open(QIODevice::WriteOnly)) {
         LOG_ERROR(QString("无法写入作业数据文件：%1").arg(file.errorString()));
@@ -739,8 +1507,878 @@ bool Server::saveHomeworkDatabase(const QJsonObject &data)
     }
     
     QJsonDocument doc(data);
-    file.write(doc.toJson(QJsonDocument::Indented));
+    timer.bytes = file.write(doc.toJson(QJsonDocument::Indented));
     file.close();
     
     return true;
-} 
+}
+
+qint64 Server::enqueueJudge(const QJsonObject &homework, const QJsonObject &submission,
+                            JudgeJob::Priority priority)
+{
+    JudgeJob job;
+    job.priority = priority;
+    QDateTime deadline = QDateTime::fromString(homework["deadline"].toString(), Qt::ISODate);
+    job.deadlineMs = deadline.isValid() ? deadline.toMSecsSinceEpoch() : 0;
+    job.homeworkId = homework["id"].toInt();
+    job.submissionId = submission["id"].toInt();
+    job.studentId = submission["studentId"].toInt();
+    job.language = submission["language"].toString();
+    job.answer = submission["answer"].toString();
+    job.problem = homework;
+    job.problem.remove("submissions");
+    // 重测时带上上次的逐点结果，测试数据未变的测试点不再运行
+    if (priority == JudgeJob::Rejudge) {
+        job.previousTestSet = submission["testSetVersion"].toInt();
+        job.previousConfig = submission["caseConfig"].toString();
+        job.previousCases = submission["caseResults"].toArray();
+    }
+    return judgeQueue->enqueue(job);
+}
+
+void Server::resumePendingJudges()
+{
+    // 上次退出时仍在评测中的提交重新入队；属于重测的提交重新组成重测批次，仍以最低优先级评测
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    bool changed = false;
+    QMap<int, QList<int>> rejudging;  // 作业ID -> 学生ID
+
+    for (int i = 0; i < homeworks.size(); ++i) {
+        QJsonObject homework = homeworks[i].toObject();
+        QJsonArray submissions = homework["submissions"].toArray();
+        bool homeworkChanged = false;
+
+        for (int j = 0; j < submissions.size(); ++j) {
+            QJsonObject submission = submissions[j].toObject();
+            if (submission["status"].toString() != "评测中") {
+                continue;
+            }
+            if (submission["rejudging"].toBool()) {
+                rejudging[homework["id"].toInt()].append(submission["studentId"].toInt());
+                continue;
+            }
+
+            qint64 jobId = enqueueJudge(homework, submission);
+            if (jobId >= 0) {
+                submission["jobId"] = QString::number(jobId);
+            } else {
+                submission["status"] = "已提交";
+                submission.remove("jobId");
+            }
+            submissions[j] = submission;
+            homeworkChanged = true;
+        }
+
+        if (homeworkChanged) {
+            homework["submissions"] = submissions;
+            homeworks[i] = homework;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        homeworkDb["homeworks"] = homeworks;
+        if (saveHomeworkDatabase(homeworkDb)) {
+            LOG_INFO("已恢复未完成的评测任务");
+        } else {
+            LOG_ERROR("恢复未完成的评测任务时保存作业信息失败");
+        }
+    }
+
+    for (auto it = rejudging.cbegin(); it != rejudging.cend(); ++it) {
+        int batchId = createRejudgeBatch(it.key(), it.value(), nullptr);
+        if (!fillRejudgeBatch(batchId, rejudgeBatches[batchId])) {
+            takeRejudgeJobs(batchId);
+            rejudgeBatches.remove(batchId);
+            continue;
+        }
+        LOG_INFO(QString("作业 %1 恢复未完成的重测：%2 份提交").arg(it.key()).arg(it.value().size()));
+    }
+}
+
+bool Server::applyJudgeResult(QJsonArray &homeworks, const JudgeResult &result)
+{
+    QString jobId = QString::number(result.jobId);
+
+    for (int i = 0; i < homeworks.size(); ++i) {
+        QJsonObject homework = homeworks[i].toObject();
+        if (homework["id"].toInt() != result.homeworkId) {
+            continue;
+        }
+
+        QJsonArray submissions = homework["submissions"].toArray();
+        for (int j = 0; j < submissions.size(); ++j) {
+            QJsonObject submission = submissions[j].toObject();
+            if (submission["studentId"].toInt() != result.studentId) {
+                continue;
+            }
+
+            // 评测期间学生重新提交过，旧结果作废
+            if (submission["jobId"].toString() != jobId) {
+                LOG_INFO(QString("评测任务 %1 已过期，丢弃结果").arg(jobId));
+                return false;
+            }
+
+            submission["status"] = "已评测";
+            submission.remove("rejudging");
+            submission["verdict"] = result.verdict;
+            submission["score"] = result.score;
+            submission["judgeMessage"] = result.message;
+            submission["judgeTimeMs"] = result.judgeTimeMs;
+            submission["caseResults"] = result.cases;
+            submission["timing"] = result.timing;
+            submission["testSetVersion"] = result.testSetVersion;
+            submission["caseConfig"] = result.caseConfig;
+            submission["judgedAt"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+            submissions[j] = submission;
+            homework["submissions"] = submissions;
+            homeworks[i] = homework;
+            return true;
+        }
+    }
+
+    LOG_WARNING(QString("评测任务 %1 对应的提交记录不存在").arg(jobId));
+    return false;
+}
+
+void Server::handleJudgeFinished(const JudgeResult &result)
+{
+    // 无论由本地还是远程节点评完，任务都已结束，不再需要租出次数
+    workerLeases.forget(result.jobId);
+
+    auto batch = rejudgeJobs.find(result.jobId);
+    if (batch != rejudgeJobs.end()) {
+        int batchId = batch.value();
+        rejudgeJobs.erase(batch);
+        handleRejudgeResult(batchId, result);
+        return;
+    }
+
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    if (!applyJudgeResult(homeworks, result)) {
+        return;
+    }
+
+    homeworkDb["homeworks"] = homeworks;
+    if (saveHomeworkDatabase(homeworkDb)) {
+        LOG_INFO(QString("评测任务 %1 完成：%2").arg(result.jobId).arg(result.verdict));
+    } else {
+        LOG_ERROR(QString("评测任务 %1 结果保存失败").arg(result.jobId));
+    }
+}
+
+void Server::handleTestSetUpdate(QTcpSocket *socket, const QJsonObject &data)
+{
+    int homeworkId = data["homeworkId"].toInt();
+    QJsonArray testCases = data["testCases"].toArray();
+    if (testCases.isEmpty()) {
+        sendHttpError(socket, 400, "测试数据不能为空");
+        return;
+    }
+
+    for (const QJsonValue &val : loadHomeworkDatabase()["homeworks"].toArray()) {
+        QJsonObject homework = val.toObject();
+        if (homework["id"].toInt() != homeworkId) {
+            continue;
+        }
+        if (homework["judgeType"].toString() != "code") {
+            sendHttpError(socket, 400, "该作业不是编程作业");
+            return;
+        }
+        publishTestSet(socket, homeworkId, testCases, QJsonObject());
+        return;
+    }
+
+    sendHttpError(socket, 404, "未找到对应的作业");
+}
+
+void Server::publishTestSet(QTcpSocket *socket, int homeworkId, const QJsonArray &testCases,
+                            const QJsonObject &newHomework)
+{
+    TestSetPublish pending;
+    pending.socket = socket;
+    pending.homeworkId = homeworkId;
+    pending.caseCount = testCases.size();
+    pending.newHomework = newHomework;
+    qint64 publishId = nextPublishId++;
+    testSetPublishes.insert(publishId, pending);
+    testSetPool.start(new TestSetPublishTask(this, testSetStore, publishId, homeworkId, testCases));
+}
+
+void Server::handleTestSetPublished(qint64 publishId, int version, const QJsonArray &changedCases)
+{
+    TestSetPublish pending = testSetPublishes.take(publishId);
+    // 客户端已断开时仍要把新版本写入作业记录，只是不再回复
+    QTcpSocket *socket = pending.socket.data();
+    if (version < 0) {
+        if (socket) {
+            sendHttpError(socket, 500, "保存测试数据失败");
+        }
+        return;
+    }
+
+    if (!pending.newHomework.isEmpty()) {
+        pending.newHomework["testSetVersion"] = version;
+        pending.newHomework["testCaseCount"] = pending.caseCount;
+        saveNewHomework(socket, pending.newHomework);
+        return;
+    }
+
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    for (int i = 0; i < homeworks.size(); ++i) {
+        QJsonObject homework = homeworks[i].toObject();
+        if (homework["id"].toInt() != pending.homeworkId) {
+            continue;
+        }
+        // 早期作业的内联测试数据迁移到数据包
+        homework.remove("testCases");
+        homework["testSetVersion"] = version;
+        homework["testCaseCount"] = pending.caseCount;
+        homeworks[i] = homework;
+        homeworkDb["homeworks"] = homeworks;
+        if (!saveHomeworkDatabase(homeworkDb)) {
+            if (socket) {
+                sendHttpError(socket, 500, "保存作业信息失败");
+            }
+            return;
+        }
+        verdictCache->invalidate(pending.homeworkId);
+
+        if (socket) {
+            sendHttpResponse(socket, {
+                {"success", true},
+                {"version", version},
+                {"caseCount", pending.caseCount},
+                {"changedCases", changedCases}
+            });
+        }
+        return;
+    }
+
+    if (socket) {
+        sendHttpError(socket, 404, "未找到对应的作业");
+    }
+}
+
+void Server::handleRejudge(QTcpSocket *socket, const QJsonObject &data)
+{
+    int homeworkId = data["homeworkId"].toInt();
+
+    for (const RejudgeBatch &batch : rejudgeBatches) {
+        if (batch.homeworkId == homeworkId) {
+            sendHttpError(socket, 409, "该作业正在重测中");
+            return;
+        }
+    }
+
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    int index = -1;
+    for (int i = 0; i < homeworks.size(); ++i) {
+        if (homeworks[i].toObject()["id"].toInt() == homeworkId) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        sendHttpError(socket, 404, "未找到对应的作业");
+        return;
+    }
+
+    QJsonObject homework = homeworks[index].toObject();
+    if (!Judger::canJudge(homework)) {
+        sendHttpError(socket, 400, "该作业未配置自动评测");
+        return;
+    }
+
+    QList<int> studentIds;
+    for (const QJsonValue &val : homework["submissions"].toArray()) {
+        studentIds.append(val.toObject()["studentId"].toInt());
+    }
+    if (studentIds.isEmpty()) {
+        sendHttpResponse(socket, {
+            {"success", true},
+            {"total", 0},
+            {"message", "该作业暂无提交"}
+        });
+        return;
+    }
+
+    int batchId = createRejudgeBatch(homeworkId, studentIds, socket);
+    RejudgeBatch &batch = rejudgeBatches[batchId];
+    if (!fillRejudgeBatch(batchId, batch)) {
+        // 任务ID没能写回，已入队的任务评完后会被当作过期结果丢弃
+        takeRejudgeJobs(batchId);
+        rejudgeBatches.remove(batchId);
+        sendHttpError(socket, 500, "保存作业信息失败");
+        return;
+    }
+
+    LOG_INFO(QString("作业 %1 开始重测：%2 份提交，%3 份等待入队")
+        .arg(homeworkId)
+        .arg(batch.total)
+        .arg(batch.backlog.size()));
+
+    beginChunkedResponse(socket);
+    sendChunk(socket, rejudgeProgress(batch));
+    if (batch.done == batch.total) {
+        finishRejudgeBatch(batchId);
+    }
+}
+
+int Server::createRejudgeBatch(int homeworkId, const QList<int> &studentIds, QTcpSocket *socket)
+{
+    int batchId = nextBatchId++;
+    RejudgeBatch &batch = rejudgeBatches[batchId];
+    batch.homeworkId = homeworkId;
+    batch.total = studentIds.size();
+    batch.backlog = studentIds;
+    batch.socket = socket;
+    batch.lastProgress.start();
+    batch.lastResult.start();
+    return batchId;
+}
+
+bool Server::fillRejudgeBatch(int batchId, RejudgeBatch &batch)
+{
+    // 重测以最低优先级入队，且最多占用队列容量的一半，不挤占学生的正式提交；
+    // 已入队的任务完成过半时再补一批，每批只写一次作业数据库
+    int window = qMax(1, judgeQueue->capacity() / 2);
+    int queued = batch.total - batch.done - batch.backlog.size();
+    if (batch.backlog.isEmpty() || queued > window / 2) {
+        return true;
+    }
+
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    int index = -1;
+    for (int i = 0; i < homeworks.size(); ++i) {
+        if (homeworks[i].toObject()["id"].toInt() == batch.homeworkId) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        batch.skipped += batch.backlog.size();
+        batch.done += batch.backlog.size();
+        batch.backlog.clear();
+        return true;
+    }
+
+    QJsonObject homework = homeworks[index].toObject();
+    QJsonArray submissions = homework["submissions"].toArray();
+    bool changed = false;
+    while (!batch.backlog.isEmpty() && queued < window) {
+        int studentId = batch.backlog.first();
+        int j = 0;
+        while (j < submissions.size() && submissions[j].toObject()["studentId"].toInt() != studentId) {
+            ++j;
+        }
+        QJsonObject submission = j < submissions.size() ? submissions[j].toObject() : QJsonObject();
+        // 提交已被删除，或学生重新提交后正在评测，新结果会覆盖重测
+        if (submission.isEmpty()
+            || (submission["status"].toString() == "评测中" && !submission["rejudging"].toBool())) {
+            batch.backlog.removeFirst();
+            ++batch.skipped;
+            ++batch.done;
+            continue;
+        }
+
+        qint64 jobId = enqueueJudge(homework, submission, JudgeJob::Rejudge);
+        if (jobId < 0) {
+            break;  // 队列已满，等已入队的任务完成或定时器触发时再补
+        }
+        batch.backlog.removeFirst();
+        submission["status"] = "评测中";
+        submission["jobId"] = QString::number(jobId);
+        submission["rejudging"] = true;
+        submissions[j] = submission;
+        rejudgeJobs.insert(jobId, batchId);
+        ++queued;
+        changed = true;
+    }
+    if (!changed) {
+        return true;
+    }
+
+    // 任务ID先写回，期间学生重新提交会使对应的重测结果作废
+    homework["submissions"] = submissions;
+    homeworks[index] = homework;
+    homeworkDb["homeworks"] = homeworks;
+    if (!saveHomeworkDatabase(homeworkDb)) {
+        LOG_ERROR(QString("作业 %1 重测任务写回失败").arg(batch.homeworkId));
+        return false;
+    }
+    return true;
+}
+
+QSet<qint64> Server::takeRejudgeJobs(int batchId)
+{
+    QSet<qint64> jobIds;
+    for (auto it = rejudgeJobs.begin(); it != rejudgeJobs.end();) {
+        if (it.value() == batchId) {
+            jobIds.insert(it.key());
+            it = rejudgeJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return jobIds;
+}
+
+void Server::handleRejudgeResult(int batchId, const JudgeResult &result)
+{
+    auto it = rejudgeBatches.find(batchId);
+    if (it == rejudgeBatches.end()) {
+        return;
+    }
+    RejudgeBatch &batch = it.value();
+    batch.results.append(result);
+    ++batch.done;
+    ++batch.verdicts[result.verdict];
+    batch.lastResult.restart();
+    // 写回失败的这批任务评完后按过期结果丢弃，不影响其余提交
+    fillRejudgeBatch(batchId, batch);
+
+    // 进度最多每 200ms 推送一次
+    if (batch.done < batch.total) {
+        if (batch.socket && batch.lastProgress.elapsed() >= 200) {
+            sendChunk(batch.socket, rejudgeProgress(batch));
+            batch.lastProgress.restart();
+        }
+        return;
+    }
+    finishRejudgeBatch(batchId);
+}
+
+void Server::finishRejudgeBatch(int batchId)
+{
+    RejudgeBatch batch = rejudgeBatches.take(batchId);
+    // 超时放弃的任务不再计入批次，之后若评完按过期结果丢弃
+    QSet<QString> abandonedJobs;
+    for (qint64 jobId : takeRejudgeJobs(batchId)) {
+        abandonedJobs.insert(QString::number(jobId));
+    }
+
+    // 全部完成后一次性写回
+    QJsonObject homeworkDb = loadHomeworkDatabase();
+    QJsonArray homeworks = homeworkDb["homeworks"].toArray();
+    int applied = 0;
+    for (const JudgeResult &judged : batch.results) {
+        if (applyJudgeResult(homeworks, judged)) {
+            ++applied;
+        }
+    }
+    // 放弃的提交恢复为重测前的状态，保留原有结果
+    for (int i = 0; !abandonedJobs.isEmpty() && i < homeworks.size(); ++i) {
+        QJsonObject homework = homeworks[i].toObject();
+        if (homework["id"].toInt() != batch.homeworkId) {
+            continue;
+        }
+        QJsonArray submissions = homework["submissions"].toArray();
+        for (int j = 0; j < submissions.size(); ++j) {
+            QJsonObject submission = submissions[j].toObject();
+            if (!abandonedJobs.contains(submission["jobId"].toString())) {
+                continue;
+            }
+            submission["status"] = submission.contains("verdict") ? "已评测" : "已提交";
+            submission.remove("jobId");
+            submission.remove("rejudging");
+            submissions[j] = submission;
+        }
+        homework["submissions"] = submissions;
+        homeworks[i] = homework;
+    }
+    homeworkDb["homeworks"] = homeworks;
+    bool saved = saveHomeworkDatabase(homeworkDb);
+    if (saved) {
+        LOG_INFO(QString("作业 %1 重测完成：%2 份结果已写回，%3 份跳过，%4 份任务丢失")
+            .arg(batch.homeworkId)
+            .arg(applied)
+            .arg(batch.skipped)
+            .arg(batch.abandoned));
+    } else {
+        LOG_ERROR(QString("作业 %1 重测结果保存失败").arg(batch.homeworkId));
+    }
+
+    if (batch.socket) {
+        QJsonObject progress = rejudgeProgress(batch);
+        progress["applied"] = applied;
+        progress["committed"] = saved;
+        sendChunk(batch.socket, progress);
+        endChunkedResponse(batch.socket);
+    }
+}
+
+void Server::expireRejudgeBatches()
+{
+    bool idle = judgeQueue->pendingCount() == 0 && workerLeases.activeCount() == 0;
+    for (int batchId : rejudgeBatches.keys()) {
+        RejudgeBatch &batch = rejudgeBatches[batchId];
+        // 入队时队列已满的提交在这里补上
+        fillRejudgeBatch(batchId, batch);
+
+        qint64 quietMs = batch.lastResult.elapsed();
+        if (quietMs < kRejudgeStallMs || (!idle && quietMs < kRejudgeAbandonMs)) {
+            continue;
+        }
+        LOG_WARNING(QString("作业 %1 的重测已 %2 秒没有进展，剩余 %3 份按任务丢失结束")
+            .arg(batch.homeworkId)
+            .arg(quietMs / 1000)
+            .arg(batch.total - batch.done));
+        batch.abandoned += batch.total - batch.done;
+        batch.done = batch.total;
+        batch.backlog.clear();
+        finishRejudgeBatch(batchId);
+    }
+}
+
+QJsonObject Server::rejudgeProgress(const RejudgeBatch &batch) const
+{
+    QJsonObject verdicts;
+    for (auto it = batch.verdicts.cbegin(); it != batch.verdicts.cend(); ++it) {
+        verdicts[it.key()] = it.value();
+    }
+    return QJsonObject{
+        {"homeworkId", batch.homeworkId},
+        {"done", batch.done},
+        {"total", batch.total},
+        {"waiting", batch.backlog.size()},
+        {"skipped", batch.skipped},
+        {"abandoned", batch.abandoned},
+        {"verdicts", verdicts}
+    };
+}
+
+void Server::handleRun(QTcpSocket *socket, const QJsonObject &data)
+{
+    int homeworkId = data["homeworkId"].toInt();
+    QString answer = data["answer"].toString();
+    if (answer.isEmpty()) {
+        sendHttpError(socket, 400, "代码不能为空");
+        return;
+    }
+
+    // 只读作业配置，不写提交记录
+    QJsonObject homework;
+    QJsonArray homeworks = loadHomeworkDatabase()["homeworks"].toArray();
+    for (const QJsonValue &val : homeworks) {
+        if (val.toObject()["id"].toInt() == homeworkId) {
+            homework = val.toObject();
+            break;
+        }
+    }
+    if (homework.isEmpty()) {
+        sendHttpError(socket, 404, "未找到对应的作业");
+        return;
+    }
+    if (homework["judgeType"].toString() != "code") {
+        sendHttpError(socket, 400, "该作业不是编程题");
+        return;
+    }
+
+    // 公开样例之后可附加一组自定义输入，只运行不比较
+    QJsonArray samples = homework["sampleCases"].toArray();
+    if (data.contains("input")) {
+        samples.append(QJsonObject{{"input", data["input"].toString()}});
+    }
+    if (samples.isEmpty()) {
+        sendHttpError(socket, 400, "该作业没有公开样例");
+        return;
+    }
+
+    JudgeJob job;
+    job.priority = JudgeJob::Sample;
+    job.homeworkId = homeworkId;
+    job.studentId = session.userId;
+    job.language = data["language"].toString(homework["language"].toString("cpp"));
+    job.answer = answer;
+    job.problem = homework;
+    job.problem.remove("submissions");
+    job.problem.remove("testCases");
+    job.problem["sampleCases"] = samples;
+
+    qint64 jobId = runQueue->enqueue(job);
+    if (jobId < 0) {
+        sendHttpError(socket, 503, "运行队列已满，请稍后重试");
+        return;
+    }
+
+    runStreams.insert(jobId, socket);
+    beginChunkedResponse(socket);
+    sendChunk(socket, {
+        {"event", "queued"},
+        {"jobId", QString::number(jobId)},
+        {"samples", samples.size()}
+    });
+}
+
+void Server::handleRunCase(qint64 jobId, int index, const QJsonObject &caseResult)
+{
+    QPointer<QTcpSocket> socket = runStreams.value(jobId);
+    if (!socket) {
+        return;
+    }
+    QJsonObject event = caseResult;
+    event["event"] = "case";
+    event["index"] = index;
+    sendChunk(socket, event);
+}
+
+void Server::handleRunFinished(const JudgeResult &result)
+{
+    QPointer<QTcpSocket> socket = runStreams.take(result.jobId);
+    if (!socket) {
+        return;
+    }
+    QJsonObject done{
+        {"event", "done"},
+        {"verdict", result.verdict},
+        {"message", result.message},
+        {"judgeTimeMs", result.judgeTimeMs}
+    };
+    if (result.timing.contains("compileMs")) {
+        done["compileMs"] = result.timing["compileMs"];
+        done["compileCached"] = result.timing["compileCached"];
+    }
+    sendChunk(socket, done);
+    endChunkedResponse(socket);
+}
+
+void Server::rebuildPlagiarismIndex()
+{
+    QJsonArray homeworks = loadHomeworkDatabase()["homeworks"].toArray();
+    int documents = 0;
+    for (const QJsonValue &val : homeworks) {
+        QJsonObject homework = val.toObject();
+        bool code = homework["judgeType"].toString() == "code";
+        for (const QJsonValue &sub : homework["submissions"].toArray()) {
+            QJsonObject submission = sub.toObject();
+            plagiarismIndex.add(homework["id"].toInt(), submission["studentId"].toInt(),
+                                submission["answer"].toString(), code);
+            ++documents;
+        }
+    }
+    LOG_INFO(QString("查重索引已建立：%1 份提交").arg(documents));
+}
+
+void Server::checkPlagiarism(int homeworkId, int studentId, const QString &studentName,
+                             const QString &answer, bool code)
+{
+    QList<SimilarPair> matches = plagiarismIndex.add(homeworkId, studentId, answer, code);
+    if (!matches.isEmpty() && matches.first().similarity >= 0.8) {
+        const SimilarPair &top = matches.first();
+        LOG_WARNING(QString("学生 %1 的作业 %2 提交与学生 %3 高度相似（%4%）")
+            .arg(studentName)
+            .arg(homeworkId)
+            .arg(top.studentA == studentId ? top.studentB : top.studentA)
+            .arg(int(top.similarity * 100)));
+    }
+}
+
+void Server::handlePlagiarism(QTcpSocket *socket, const QJsonObject &data)
+{
+    int homeworkId = data["homeworkId"].toInt();
+    int limit = qBound(1, data["limit"].toInt(20), 500);
+
+    // 学生姓名取自提交记录
+    QHash<int, QString> names;
+    QJsonArray homeworks = loadHomeworkDatabase()["homeworks"].toArray();
+    for (const QJsonValue &val : homeworks) {
+        QJsonObject homework = val.toObject();
+        if (homework["id"].toInt() != homeworkId) {
+            continue;
+        }
+        for (const QJsonValue &sub : homework["submissions"].toArray()) {
+            QJsonObject submission = sub.toObject();
+            names.insert(submission["studentId"].toInt(), submission["studentName"].toString());
+        }
+        break;
+    }
+
+    QJsonArray pairs;
+    for (const SimilarPair &pair : plagiarismIndex.topPairs(homeworkId, limit)) {
+        pairs.append(QJsonObject{
+            {"studentA", pair.studentA},
+            {"studentNameA", names.value(pair.studentA)},
+            {"studentB", pair.studentB},
+            {"studentNameB", names.value(pair.studentB)},
+            {"similarity", qRound(pair.similarity * 1000) / 1000.0},
+            {"sharedFingerprints", pair.shared}
+        });
+    }
+
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"homeworkId", homeworkId},
+        {"submissions", plagiarismIndex.documentCount(homeworkId)},
+        {"pairs", pairs}
+    });
+}
+
+bool Server::verifyWorker(QTcpSocket *socket, const QJsonObject &data)
+{
+    if (workerToken.isEmpty()) {
+        sendHttpError(socket, 403, "未启用远程评测节点");
+        return false;
+    }
+    if (!sameToken(data["token"].toString().toUtf8(), workerToken) || data["workerId"].toString().isEmpty()) {
+        sendHttpError(socket, 401, "评测节点认证失败");
+        return false;
+    }
+    return true;
+}
+
+void Server::handleWorkerLease(QTcpSocket *socket, const QJsonObject &data)
+{
+    if (!verifyWorker(socket, data)) {
+        return;
+    }
+    QString workerId = data["workerId"].toString();
+    int max = qBound(1, data["max"].toInt(1), 8);
+
+    QJsonArray jobs;
+    JudgeJob job;
+    while (jobs.size() < max && judgeQueue->takeRemote(&job)) {
+        // 节点没有测试数据包，把当前版本的测试点内联进任务
+        QJsonObject jobJson = job.toJson();
+        int packVersion = job.problem["testSetVersion"].toInt();
+        if (packVersion > 0) {
+            QJsonArray cases;
+            if (!leasePayload(job.homeworkId, packVersion, &cases)) {
+                // 数据包缺失或损坏时不能交给节点按残缺的测试点评测
+                JudgeResult result;
+                result.jobId = job.jobId;
+                result.homeworkId = job.homeworkId;
+                result.studentId = job.studentId;
+                result.verdict = "SE";
+                result.message = QString("测试数据版本 %1 不可用").arg(packVersion);
+                handleJudgeFinished(result);
+                continue;
+            }
+            jobJson["packCases"] = cases;
+        }
+        qint64 leaseId = workerLeases.grant(workerId, job);
+        jobs.append(QJsonObject{
+            {"leaseId", QString::number(leaseId)},
+            {"job", jobJson}
+        });
+    }
+
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"leaseMs", workerLeases.leaseMs()},
+        {"jobs", jobs}
+    });
+}
+
+bool Server::leasePayload(int homeworkId, int version, QJsonArray *cases)
+{
+    QPair<int, int> key(homeworkId, version);
+    auto cached = leasePayloads.constFind(key);
+    if (cached != leasePayloads.constEnd()) {
+        *cases = cached.value();
+        return true;
+    }
+
+    QSharedPointer<TestSetPack> pack = testSetStore->open(homeworkId, version);
+    if (!pack || pack->caseCount() == 0) {
+        return false;
+    }
+    JudgeJob encoded;
+    for (int i = 0; i < pack->caseCount(); ++i) {
+        QByteArray input;
+        QByteArray output;
+        if (!pack->readCase(i, &input, &output)) {
+            LOG_ERROR(QString("作业 %1 测试数据版本 %2 的测试点 %3 损坏").arg(homeworkId).arg(version).arg(i + 1));
+            return false;
+        }
+        encoded.packCases.append(qMakePair(input, output));
+    }
+    *cases = encoded.toJson()["packCases"].toArray();
+
+    // 只保留少量最近用到的版本；旧版本的任务很少再被租出
+    if (leasePayloads.size() >= 8) {
+        leasePayloads.clear();
+    }
+    leasePayloads.insert(key, *cases);
+    return true;
+}
+
+void Server::handleWorkerHeartbeat(QTcpSocket *socket, const QJsonObject &data)
+{
+    if (!verifyWorker(socket, data)) {
+        return;
+    }
+    QList<qint64> leaseIds;
+    for (const QJsonValue &val : data["leases"].toArray()) {
+        leaseIds.append(val.toString().toLongLong());
+    }
+    QJsonArray lost;
+    for (qint64 leaseId : workerLeases.renew(data["workerId"].toString(), leaseIds)) {
+        lost.append(QString::number(leaseId));
+    }
+    sendHttpResponse(socket, {
+        {"success", true},
+        {"lost", lost}
+    });
+}
+
+void Server::handleWorkerResult(QTcpSocket *socket, const QJsonObject &data)
+{
+    if (!verifyWorker(socket, data)) {
+        return;
+    }
+    QString workerId = data["workerId"].toString();
+    JudgeJob job;
+    if (!workerLeases.complete(workerId, data["leaseId"].toString().toLongLong(), &job)) {
+        // 租约已过期，任务已交给其他节点
+        sendHttpError(socket, 409, "租约已失效");
+        return;
+    }
+
+    // 任务归属以服务器登记的为准
+    JudgeResult result = JudgeResult::fromJson(data["result"].toObject());
+    result.jobId = job.jobId;
+    result.homeworkId = job.homeworkId;
+    result.studentId = job.studentId;
+    if (result.verdict.isEmpty()) {
+        result.verdict = "SE";
+        result.message = "评测节点返回的结果无效";
+    }
+    sendHttpResponse(socket, {{"success", true}});
+    handleJudgeFinished(result);
+}
+
+void Server::expireWorkerLeases()
+{
+    const int maxAttempts = 3;
+    for (const JudgeJob &job : workerLeases.expire()) {
+        if (workerLeases.attempts(job.jobId) >= maxAttempts) {
+            // 反复导致节点失联的任务不再重试
+            LOG_ERROR(QString("评测任务 %1 在远程节点上连续 %2 次超时，放弃评测").arg(job.jobId).arg(maxAttempts));
+            JudgeResult result;
+            result.jobId = job.jobId;
+            result.homeworkId = job.homeworkId;
+            result.studentId = job.studentId;
+            result.verdict = "SE";
+            result.message = "评测节点多次失联";
+            handleJudgeFinished(result);
+            continue;
+        }
+        LOG_WARNING(QString("评测任务 %1 的租约过期，重新排队").arg(job.jobId));
+        judgeQueue->requeue(job);
+    }
+}
+
+void Server::measureLoopLag()
+{
+    // 定时器每 100ms 触发，超出部分即事件循环被阻塞的时间；取衰减峰值，避免抖动
+    qint64 nowMs = serverClock.elapsed();
+    qint64 lag = lastLagCheckMs > 0 ? qMax<qint64>(0, nowMs - lastLagCheckMs - lagTimer->interval()) : 0;
+    lastLagCheckMs = nowMs;
+    loopLagMs = qMax(lag, loopLagMs / 2);
+}
@@ -8,10 +8,47 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QThreadPool>
+#include <QSet>
+#include "judgequeue.h"
+#include "compilecache.h"
+#include "zygotepool.h"
+#include "checkerpool.h"
+#include "verdictcache.h"
+#include "testsetstore.h"
+#include "plagiarismindex.h"
+#include "workerlease.h"
+#include "admissioncontrol.h"
+#include "metrics.h"
+#include "slowlog.h"
+#include "httprequestparser.h"
+#include "sessionstore.h"
+
+// 一次批量重测：结果先收集在内存中，全部完成后一次写回作业数据库
+// 提交分批入队，只占用评测队列的一部分，其余留在 backlog 中等前面的完成后再补
+struct RejudgeBatch
+{
+    int homeworkId = 0;
+    int total = 0;
+    int done = 0;                  // 含 skipped 与 abandoned
+    int skipped = 0;               // 入队前已被删除或正在评测新提交，不再重测
+    int abandoned = 0;             // 任务丢失，超时后按完成计入
+    QList<int> backlog;            // 尚未入队的提交（学生ID）
+    QMap<QString, int> verdicts;   // 各评测结果的数量
+    QList<JudgeResult> results;
+    QPointer<QTcpSocket> socket;   // 进度流；客户端断开后评测照常进行
+    QElapsedTimer lastProgress;
+    QElapsedTimer lastResult;      // 最近一次收到结果，用于发现丢失的任务
+};
 
 class Server : public QObject
 {
     Q_OBJECT
+    // 存储基准测试直接调用数据文件读写与接口处理函数
+    friend class StorageBenchmark;
 public:
     explicit Server(QObject *parent = nullptr);
     ~Server();
@@ -19,46 +56,173 @@ public:
     bool start(quint16 port = 8080);
     bool initDatabase();
 
+signals:
+    // 测试数据包写入完成（version 为 -1 表示失败），由后台线程发出
+    void testSetPublished(qint64 publishId, int version, const QJsonArray &changedCases);
+
 private slots:
     void handleNewConnection();
     void handleReadyRead();
     void handleDisconnected();
+    void handleJudgeFinished(const JudgeResult &result);
+    void handleRunCase(qint64 jobId, int index, const QJsonObject &caseResult);
+    void handleRunFinished(const JudgeResult &result);
+    void expireWorkerLeases();
+    void expireRejudgeBatches();
+    void measureLoopLag();
+    void handleTestSetPublished(qint64 publishId, int version, const QJsonArray &changedCases);
 
 private:
     QTcpServer *tcpServer;
-    QMap<QTcpSocket*, QByteArray> buffers;
+    QHash<QTcpSocket*, HttpRequestParser> parsers;
+    // 过载保护：请求从第一个字节到达起计时，事件循环延迟由定时器测量
+    AdmissionControl admission;
+    QHash<QTcpSocket*, qint64> requestStartUs;
+    QElapsedTimer serverClock;
+    QTimer *lagTimer;
+    qint64 loopLagMs;
+    qint64 lastLagCheckMs;
+    // 指标：每个路由的指标编号在首次请求时注册并缓存
+    struct RouteMetrics
+    {
+        int handlerUs = -1;
+        int totalUs = -1;
+        int bytesIn = -1;
+        int bytesOut = -1;
+        QHash<int, int> requests;  // 状态码 -> 计数器编号
+    };
+    QHash<QString, RouteMetrics> routeMetrics;
+    int responseStatus;     // 当前请求处理期间发出的第一个状态码
+    qint64 responseBytes;   // 当前请求处理期间发出的字节数（不含流式数据块）
+    int streamBytesMetric;
+    // 打开的连接，供运维接口查看
+    struct ConnectionInfo
+    {
+        QString peer;
+        qint64 connectedAtUs = 0;
+        qint64 requests = 0;
+    };
+    QHash<QTcpSocket*, ConnectionInfo> connections;
+    // 慢请求日志：当前请求的各阶段耗时，以及上一个请求在事件循环上结束的时刻
+    RequestProfile profile;
+    SlowRequestLog slowLog;
+    qint64 lastRequestEndUs;
+    QString lastRoute;
     QString dbFilePath;
     QString homeworkDbPath;  // 新增
+    JudgeQueue *judgeQueue;
+    CompileCache *compileCache;
+    CheckerPool *checkerPool;
+    VerdictCache *verdictCache;
+    TestSetStore *testSetStore;
+    ZygotePool *zygotePool;
+    // 样例运行专用通道：独立的评测线程与预热进程，不与正式评测排队
+    JudgeQueue *runQueue;
+    ZygotePool *runZygotePool;
+    QHash<qint64, QPointer<QTcpSocket>> runStreams;  // 任务ID -> 结果流
+    PlagiarismIndex plagiarismIndex;
+    // 远程评测节点：共用主评测队列，按租约拉取任务
+    WorkerLeases workerLeases;
+    QTimer *leaseTimer;
+    // （作业ID, 数据包版本）-> 内联给远程节点的测试点，同一版本只编码一次
+    QHash<QPair<int, int>, QJsonArray> leasePayloads;
+    QByteArray workerToken;  // 环境变量 OJ_WORKER_TOKEN，未设置时不接受远程节点
+    QByteArray adminToken;   // 环境变量 OJ_ADMIN_TOKEN，未设置时关闭运维接口
+    // 登录会话：当前请求携带的令牌对应的身份，在解析请求时查出
+    SessionStore sessions;
+    QByteArray sessionToken;
+    Session session;
+    bool authenticated;
+    QHash<qint64, int> rejudgeJobs;        // 任务ID -> 批次ID
+    QHash<int, RejudgeBatch> rejudgeBatches;
+    int nextBatchId;
+    QTimer *rejudgeTimer;
+    // 正在后台写入的测试数据包：新发布的作业在写完后才保存，其ID先行保留
+    struct TestSetPublish
+    {
+        QPointer<QTcpSocket> socket;
+        int homeworkId = 0;
+        int caseCount = 0;
+        QJsonObject newHomework;  // 新发布的作业的完整记录；更新已有作业的测试数据时为空
+    };
+    QHash<qint64, TestSetPublish> testSetPublishes;
+    QThreadPool testSetPool;
+    int reservedHomeworkId;
+    qint64 nextPublishId;
 
     // API处理函数
     void handleSubmission(QTcpSocket *socket, const QJsonObject &data);
     void handleHomeworkList(QTcpSocket *socket, const QJsonObject &data);
     void handleLogin(QTcpSocket *socket, const QJsonObject &data);
+    void handleLogout(QTcpSocket *socket, const QJsonObject &data);
     void handlePublishHomework(QTcpSocket *socket, const QJsonObject &data);
     void handleGrade(QTcpSocket *socket, const QJsonObject &data);  // 新增评分处理函数
     void handleUserList(QTcpSocket *socket, const QJsonObject &data);
     void handleUserAdd(QTcpSocket *socket, const QJsonObject &data);
     void handleUserEdit(QTcpSocket *socket, const QJsonObject &data);
     void handleUserDelete(QTcpSocket *socket, const QJsonObject &data);
+    void handleJudgeStats(QTcpSocket *socket, const QJsonObject &data);
+    void handleRejudge(QTcpSocket *socket, const QJsonObject &data);
+    void handleTestSetUpdate(QTcpSocket *socket, const QJsonObject &data);
+    // 在后台写入测试数据包；newHomework 非空时写完后保存为新作业
+    void publishTestSet(QTcpSocket *socket, int homeworkId, const QJsonArray &testCases,
+                        const QJsonObject &newHomework);
+    void saveNewHomework(QTcpSocket *socket, QJsonObject homework);
+    void handleRun(QTcpSocket *socket, const QJsonObject &data);
+    void handlePlagiarism(QTcpSocket *socket, const QJsonObject &data);
+    void handleWorkerLease(QTcpSocket *socket, const QJsonObject &data);
+    void handleWorkerHeartbeat(QTcpSocket *socket, const QJsonObject &data);
+    void handleWorkerResult(QTcpSocket *socket, const QJsonObject &data);
+    bool verifyWorker(QTcpSocket *socket, const QJsonObject &data);
+    bool leasePayload(int homeworkId, int version, QJsonArray *cases);
+    void handleMetrics(QTcpSocket *socket, const QJsonObject &data);
+    bool verifyAdmin(QTcpSocket *socket, const QJsonObject &data);
+    void handleIntrospect(QTcpSocket *socket, const QJsonObject &data);
 
     // HTTP请求处理
     void processRequest(QTcpSocket *socket, const QJsonObject &request, const QString &path);
+    void dispatchRequest(QTcpSocket *socket, const QJsonObject &request, const QString &path);
     void sendHttpResponse(QTcpSocket *socket, const QJsonObject &response);
-    void sendHttpError(QTcpSocket *socket, int statusCode, const QString &message);
+    // retryAfter 大于 0 时附带 Retry-After 头（秒）
+    void sendHttpError(QTcpSocket *socket, int statusCode, const QString &message, int retryAfter = 0);
+    // 分块传输：先发响应头，之后每个对象作为一行 JSON 发出，最后发结束块
+    void beginChunkedResponse(QTcpSocket *socket);
+    void sendChunk(QTcpSocket *socket, const QJsonObject &object);
+    void endChunkedResponse(QTcpSocket *socket);
     QString getStatusText(int statusCode);
+    RouteMetrics &metricsFor(const QString &path);
+    void noteResponse(int statusCode, qint64 bytes);
 
     // 辅助函数
     bool verifyUser(const QString &username, const QString &password);
+    // 按路由要求的角色检查当前会话，不满足时回复 401/403
+    bool authorize(QTcpSocket *socket, const QString &path);
 
     // JSON文件操作
     QJsonObject loadDatabase();
     bool saveDatabase(const QJsonObject &data);
     bool initTestUsers();
+    bool assignMissingUserIds();
 
     // 作业数据库操作
     bool initHomeworkDatabase();
     QJsonObject loadHomeworkDatabase();
     bool saveHomeworkDatabase(const QJsonObject &data);
+
+    // 自动评测
+    qint64 enqueueJudge(const QJsonObject &homework, const QJsonObject &submission,
+                        JudgeJob::Priority priority = JudgeJob::Live);
+    void resumePendingJudges();
+    void rebuildPlagiarismIndex();
+    void checkPlagiarism(int homeworkId, int studentId, const QString &studentName,
+                         const QString &answer, bool code);
+    static bool applyJudgeResult(QJsonArray &homeworks, const JudgeResult &result);
+    int createRejudgeBatch(int homeworkId, const QList<int> &studentIds, QTcpSocket *socket);
+    bool fillRejudgeBatch(int batchId, RejudgeBatch &batch);
+    QSet<qint64> takeRejudgeJobs(int batchId);
+    void handleRejudgeResult(int batchId, const JudgeResult &result);
+    void finishRejudgeBatch(int batchId);
+    QJsonObject rejudgeProgress(const RejudgeBatch &batch) const;
 };
 
 #endif // SERVER_H
@@ -0,0 +1,138 @@
+#include "sessionstore.h"
+#include "logger.h"
+#include <QFile>
+#include <QMutexLocker>
+
+namespace {
+
+// 令牌的随机字节数
+const int kTokenBytes = 32;
+
+} // namespace
+
+SessionStore::SessionStore(qint64 ttlMs)
+    : ttl(ttlMs)
+    , shards(new Shard[kShardCount])
+{
+    clock.start();
+}
+
+SessionStore::~SessionStore()
+{
+    delete[] shards;
+}
+
+void SessionStore::setTtlMs(qint64 ttlMs)
+{
+    ttl = qMax<qint64>(1000, ttlMs);
+}
+
+SessionStore::Shard &SessionStore::shardFor(const QByteArray &token)
+{
+    return shards[qHash(token) % kShardCount];
+}
+
+QByteArray SessionStore::randomToken()
+{
+    QFile random("/dev/urandom");
+    if (!random.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        LOG_ERROR(QString("无法打开随机源：%1").arg(random.errorString()));
+        return QByteArray();
+    }
+    QByteArray bytes = random.read(kTokenBytes);
+    if (bytes.size() != kTokenBytes) {
+        LOG_ERROR("读取随机源失败");
+        return QByteArray();
+    }
+    return bytes.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
+
+QByteArray SessionStore::issue(int userId, const QString &username, const QString &role)
+{
+    QByteArray token = randomToken();
+    if (token.isEmpty()) {
+        return token;
+    }
+
+    Session session;
+    session.userId = userId;
+    session.username = username;
+    session.role = role;
+    qint64 now = nowMs();
+    session.expiresAtMs = now + ttl;
+
+    Shard &shard = shardFor(token);
+    QMutexLocker locker(&shard.mutex);
+    // 每个分片至多每 1/4 个有效期整体清理一次过期会话
+    if (now >= shard.nextSweepMs) {
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ) {
+            if (it->expiresAtMs <= now) {
+                it = shard.sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        shard.nextSweepMs = now + ttl / 4;
+    }
+    shard.sessions.insert(token, session);
+    return token;
+}
+
+bool SessionStore::lookup(const QByteArray &token, Session *session)
+{
+    if (token.isEmpty()) {
+        return false;
+    }
+    Shard &shard = shardFor(token);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.sessions.find(token);
+    if (it == shard.sessions.end()) {
+        return false;
+    }
+    if (it->expiresAtMs <= nowMs()) {
+        shard.sessions.erase(it);
+        return false;
+    }
+    *session = it.value();
+    return true;
+}
+
+void SessionStore::revoke(const QByteArray &token)
+{
+    Shard &shard = shardFor(token);
+    QMutexLocker locker(&shard.mutex);
+    shard.sessions.remove(token);
+}
+
+int SessionStore::revokeUser(int userId)
+{
+    int revoked = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        QMutexLocker locker(&shards[i].mutex);
+        QHash<QByteArray, Session> &sessions = shards[i].sessions;
+        for (auto it = sessions.begin(); it != sessions.end(); ) {
+            if (it->userId == userId) {
+                it = sessions.erase(it);
+                ++revoked;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return revoked;
+}
+
+QJsonObject SessionStore::stats()
+{
+    // 未被清理的过期会话也计入，数量只是近似值
+    int sessions = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        QMutexLocker locker(&shards[i].mutex);
+        sessions += shards[i].sessions.size();
+    }
+    return QJsonObject{
+        {"sessions", sessions},
+        {"shards", kShardCount},
+        {"ttlSec", ttl / 1000}
+    };
+}
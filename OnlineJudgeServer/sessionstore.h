@@ -0,0 +1,62 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+// 登录会话对应的身份
+struct Session
+{
+    int userId = -1;
+    QString username;
+    QString role;
+    qint64 expiresAtMs = 0;   // SessionStore 内部单调时钟
+};
+
+// 会话令牌表：登录时签发不透明的随机令牌，之后每个请求按令牌取出身份，不再读用户数据文件
+// 按令牌哈希分片，每个分片一把锁；过期的会话在被查到时删除，
+// 签发时顺带清理所在分片，令牌从不再使用的会话也不会一直占用内存
+// 可被多个线程同时调用
+class SessionStore
+{
+public:
+    explicit SessionStore(qint64 ttlMs = qint64(8) * 60 * 60 * 1000);
+    ~SessionStore();
+
+    void setTtlMs(qint64 ttlMs);
+    qint64 ttlMs() const { return ttl; }
+
+    // 签发新令牌；随机源不可用时返回空
+    QByteArray issue(int userId, const QString &username, const QString &role);
+    // 令牌有效时填入身份并返回 true
+    bool lookup(const QByteArray &token, Session *session);
+    void revoke(const QByteArray &token);
+    // 用户被删除、禁用或修改角色与密码后，使其所有会话失效，返回失效的数量
+    int revokeUser(int userId);
+
+    QJsonObject stats();
+
+private:
+    static const int kShardCount = 16;
+
+    struct Shard
+    {
+        QMutex mutex;
+        QHash<QByteArray, Session> sessions;
+        qint64 nextSweepMs = 0;
+    };
+
+    Shard &shardFor(const QByteArray &token);
+    qint64 nowMs() const { return clock.elapsed(); }
+    static QByteArray randomToken();
+
+    qint64 ttl;
+    QElapsedTimer clock;
+    Shard *shards;
+};
+
+#endif // SESSIONSTORE_H
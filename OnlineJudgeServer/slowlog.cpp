@@ -0,0 +1,87 @@
+#include "slowlog.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QRunnable>
+#include "logger.h"
+
+// 把积攒的慢请求记录一次写入文件
+class SlowLogWriteTask : public QRunnable
+{
+public:
+    explicit SlowLogWriteTask(SlowRequestLog *log) : log(log) {}
+    void run() override { log->writePending(); }
+
+private:
+    SlowRequestLog *log;
+};
+
+SlowRequestLog::SlowRequestLog(const QString &dir)
+    : dir(dir)
+    , thresholdUs(500 * 1000)
+    , writeScheduled(false)
+{
+    writerPool.setMaxThreadCount(1);
+}
+
+SlowRequestLog::~SlowRequestLog()
+{
+    writerPool.waitForDone();
+    writePending();
+}
+
+void SlowRequestLog::setThresholdMs(qint64 ms)
+{
+    thresholdUs = qMax<qint64>(0, ms) * 1000;
+}
+
+double SlowRequestLog::toMs(qint64 us)
+{
+    return qRound64(us / 100.0) / 10.0;
+}
+
+void SlowRequestLog::record(QJsonObject entry)
+{
+    entry["ts"] = QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ss.zzz");
+    QByteArray line = QJsonDocument(entry).toJson(QJsonDocument::Compact) + "\n";
+
+    // 写线程正忙时只追加到缓冲，由它一并写出
+    QMutexLocker locker(&mutex);
+    pending.append(line);
+    if (!writeScheduled) {
+        writeScheduled = true;
+        writerPool.start(new SlowLogWriteTask(this));
+    }
+}
+
+QJsonObject SlowRequestLog::stats()
+{
+    QMutexLocker locker(&mutex);
+    return QJsonObject{
+        {"thresholdMs", thresholdUs / 1000},
+        {"pendingBytes", pending.size()},
+        {"writing", writeScheduled}
+    };
+}
+
+void SlowRequestLog::writePending()
+{
+    QByteArray batch;
+    {
+        QMutexLocker locker(&mutex);
+        batch.swap(pending);
+        writeScheduled = false;
+    }
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    QDir().mkpath(dir);
+    QFile file(QString("%1/slow_%2.log").arg(dir).arg(QDate::currentDate().toString("yyyy-MM-dd")));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        LOG_ERROR(QString("无法写入慢请求日志：%1").arg(file.errorString()));
+        return;
+    }
+    file.write(batch);
+}
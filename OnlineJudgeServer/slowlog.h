@@ -0,0 +1,55 @@
+#ifndef SLOWLOG_H
+#define SLOWLOG_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QThreadPool>
+#include <QJsonObject>
+
+// 一个请求的处理过程：各阶段累计耗时（微秒），每个请求都记录，只在超过阈值时才格式化
+struct RequestProfile
+{
+    qint64 readyAtUs = 0;     // 收到最后一段数据、开始解析的时刻
+    qint64 payloadBytes = 0;
+    qint64 parseUs = 0;
+    qint64 readUs = 0;        // 读取数据文件
+    qint64 persistUs = 0;     // 写回数据文件
+    qint64 writeUs = 0;       // 序列化响应并写入套接字
+};
+
+// 慢请求日志：总耗时超过阈值的请求写入单独的日志文件 <dir>/slow_<日期>.log，每行一个 JSON 对象
+// 写文件在后台线程进行；只在主线程调用
+class SlowRequestLog
+{
+public:
+    explicit SlowRequestLog(const QString &dir = "logs");
+    ~SlowRequestLog();
+
+    // 0 表示关闭
+    void setThresholdMs(qint64 ms);
+    bool isSlow(qint64 totalUs) const { return thresholdUs > 0 && totalUs >= thresholdUs; }
+
+    // entry 由调用方组装；写入时补上时间戳
+    void record(QJsonObject entry);
+
+    // 等待写出的字节数
+    QJsonObject stats();
+
+    // 微秒换算为保留一位小数的毫秒
+    static double toMs(qint64 us);
+
+private:
+    friend class SlowLogWriteTask;
+
+    void writePending();
+
+    QString dir;
+    qint64 thresholdUs;
+    QMutex mutex;  // 保护 pending 与 writeScheduled
+    QByteArray pending;
+    bool writeScheduled;
+    QThreadPool writerPool;
+};
+
+#endif // SLOWLOG_H
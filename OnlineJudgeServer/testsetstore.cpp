@@ -0,0 +1,350 @@
+#include "testsetstore.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <QJsonObject>
+#include <QtEndian>
+#include "logger.h"
+
+#include <limits.h>
+#include <string.h>
+
+namespace {
+
+const char kMagic[4] = {'O', 'J', 'T', 'S'};
+// 版本 1：各段为 qCompress 的结果；版本 2：各段为原始字节，可直接映射使用
+const quint32 kCompressedFormat = 1;
+const quint32 kFormatVersion = 2;
+const int kHeaderSize = 48;
+const int kEntrySize = 72;
+const int kDigestSize = 32;
+// 校验与写入时每次处理的字节数
+const qint64 kChunkBytes = 1 << 20;
+// 同时保持映射的数据包上限
+const int kMaxOpenPacks = 64;
+
+void appendU32(QByteArray &out, quint32 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendU64(QByteArray &out, quint64 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+quint32 readU32(const uchar *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+quint64 readU64(const uchar *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+QByteArray caseDigest(const QByteArray &input, const QByteArray &output)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(input);
+    hash.addData("\0", 1);
+    hash.addData(output);
+    return hash.result();
+}
+
+// 分块计算摘要，避免超过 2GB 的数据在 int 长度上溢出
+void addData(QCryptographicHash &hash, const char *data, qint64 size)
+{
+    for (qint64 done = 0; done < size; done += kChunkBytes) {
+        hash.addData(data + done, int(qMin(kChunkBytes, size - done)));
+    }
+}
+
+bool writeAll(QFile &file, const char *data, qint64 size)
+{
+    for (qint64 done = 0; done < size;) {
+        qint64 written = file.write(data + done, qMin(kChunkBytes, size - done));
+        if (written <= 0) {
+            return false;
+        }
+        done += written;
+    }
+    return true;
+}
+
+} // namespace
+
+TestSetPack::TestSetPack()
+    : data(nullptr)
+    , size(0)
+    , format(0)
+    , packVersion(0)
+    , count(0)
+{
+}
+
+TestSetPack::~TestSetPack()
+{
+    if (data) {
+        file.unmap(const_cast<uchar*>(data));
+    }
+}
+
+bool TestSetPack::open(const QString &path, QString *error)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开测试数据包：%1").arg(file.errorString());
+        return false;
+    }
+    size = file.size();
+    if (size < kHeaderSize) {
+        *error = "测试数据包不完整";
+        return false;
+    }
+    data = file.map(0, size);
+    if (!data) {
+        *error = QString("无法映射测试数据包：%1").arg(file.errorString());
+        return false;
+    }
+
+    format = readU32(data + 4);
+    if (memcmp(data, kMagic, sizeof(kMagic)) != 0
+        || (format != kFormatVersion && format != kCompressedFormat)) {
+        *error = "测试数据包格式不正确";
+        return false;
+    }
+    packVersion = int(readU32(data + 8));
+    count = int(readU32(data + 12));
+    if (qint64(count) * kEntrySize > size - kHeaderSize) {
+        *error = "测试数据包索引越界";
+        return false;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    addData(hash, reinterpret_cast<const char*>(data + kHeaderSize), size - kHeaderSize);
+    if (memcmp(hash.result().constData(), data + 16, kDigestSize) != 0) {
+        *error = "测试数据包校验失败";
+        return false;
+    }
+    return true;
+}
+
+const uchar *TestSetPack::entry(int index) const
+{
+    return data + kHeaderSize + qint64(index) * kEntrySize;
+}
+
+QByteArray TestSetPack::contentDigest() const
+{
+    return QByteArray(reinterpret_cast<const char*>(data + 16), kDigestSize);
+}
+
+QByteArray TestSetPack::caseHash(int index) const
+{
+    if (index < 0 || index >= count) {
+        return QByteArray();
+    }
+    return QByteArray(reinterpret_cast<const char*>(entry(index) + 32), kDigestSize);
+}
+
+bool TestSetPack::caseChanged(int index) const
+{
+    if (index < 0 || index >= count) {
+        return true;
+    }
+    return readU32(entry(index) + 64) & 1;
+}
+
+bool TestSetPack::inRange(quint64 offset, quint64 length) const
+{
+    return offset <= quint64(size) && length <= quint64(size) - offset;
+}
+
+bool TestSetPack::view(int index, TestCaseView *view) const
+{
+    if (index < 0 || index >= count || format != kFormatVersion) {
+        return false;
+    }
+    const uchar *e = entry(index);
+    quint64 inputOffset = readU64(e);
+    quint64 inputSize = readU64(e + 8);
+    quint64 outputOffset = readU64(e + 16);
+    quint64 outputSize = readU64(e + 24);
+    if (!inRange(inputOffset, inputSize) || !inRange(outputOffset, outputSize)) {
+        return false;
+    }
+    view->input = reinterpret_cast<const char*>(data + inputOffset);
+    view->inputSize = qint64(inputSize);
+    view->output = reinterpret_cast<const char*>(data + outputOffset);
+    view->outputSize = qint64(outputSize);
+    return true;
+}
+
+bool TestSetPack::readCase(int index, QByteArray *input, QByteArray *output) const
+{
+    if (index < 0 || index >= count) {
+        return false;
+    }
+    if (format == kCompressedFormat) {
+        const uchar *e = entry(index);
+        return readBlob(readU64(e), readU32(e + 8), readU32(e + 12), input)
+            && readBlob(readU64(e + 16), readU32(e + 24), readU32(e + 28), output);
+    }
+    TestCaseView v;
+    if (!view(index, &v) || v.inputSize > INT_MAX || v.outputSize > INT_MAX) {
+        return false;
+    }
+    *input = QByteArray(v.input, int(v.inputSize));
+    *output = QByteArray(v.output, int(v.outputSize));
+    return true;
+}
+
+bool TestSetPack::readBlob(quint64 offset, quint32 stored, quint32 rawSize, QByteArray *out) const
+{
+    if (!inRange(offset, stored) || stored > quint32(INT_MAX)) {
+        return false;
+    }
+    *out = qUncompress(data + offset, int(stored));
+    return quint32(out->size()) == rawSize;
+}
+
+TestSetStore::TestSetStore(const QString &dir)
+    : dir(dir)
+{
+    QDir().mkpath(dir);
+}
+
+QString TestSetStore::packPath(int homeworkId, int version) const
+{
+    return QString("%1/%2/v%3.pack").arg(dir).arg(homeworkId).arg(version);
+}
+
+int TestSetStore::latestVersion(int homeworkId)
+{
+    int latest = 0;
+    QStringList packs = QDir(QString("%1/%2").arg(dir).arg(homeworkId))
+        .entryList(QStringList() << "v*.pack", QDir::Files);
+    for (const QString &name : packs) {
+        latest = qMax(latest, name.mid(1, name.size() - 6).toInt());
+    }
+    return latest;
+}
+
+int TestSetStore::publish(int homeworkId, const QJsonArray &testCases, QList<int> *changedCases)
+{
+    // 版本号分配与写入串行进行
+    QMutexLocker locker(&publishMutex);
+    int previous = latestVersion(homeworkId);
+    int version = previous + 1;
+    QSharedPointer<TestSetPack> previousPack;
+    if (previous > 0) {
+        previousPack = open(homeworkId, previous);
+    }
+
+    // 先算出各测试点的长度与哈希写出索引，再逐个写入内容，不在内存中拼出整个数据包
+    QByteArray index;
+    qint64 offset = kHeaderSize + qint64(testCases.size()) * kEntrySize;
+    changedCases->clear();
+    for (int i = 0; i < testCases.size(); ++i) {
+        QJsonObject testCase = testCases[i].toObject();
+        QByteArray input = testCase["input"].toString().toUtf8();
+        QByteArray output = testCase["output"].toString().toUtf8();
+        QByteArray digest = caseDigest(input, output);
+        bool changed = !previousPack || previousPack->caseHash(i) != digest;
+        if (changed) {
+            changedCases->append(i);
+        }
+
+        appendU64(index, quint64(offset));
+        appendU64(index, quint64(input.size()));
+        offset += input.size();
+        appendU64(index, quint64(offset));
+        appendU64(index, quint64(output.size()));
+        offset += output.size();
+        index.append(digest);
+        appendU32(index, changed ? 1 : 0);
+        appendU32(index, 0);
+    }
+
+    QString path = packPath(homeworkId, version);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QString tmpPath = path + ".tmp";
+    QFile file(tmpPath);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    bool ok = file.open(QIODevice::WriteOnly)
+        && file.write(QByteArray(kHeaderSize, '\0')) == kHeaderSize
+        && writeAll(file, index.constData(), index.size());
+    hash.addData(index);
+    for (int i = 0; ok && i < testCases.size(); ++i) {
+        QJsonObject testCase = testCases[i].toObject();
+        QByteArray input = testCase["input"].toString().toUtf8();
+        QByteArray output = testCase["output"].toString().toUtf8();
+        ok = writeAll(file, input.constData(), input.size()) && writeAll(file, output.constData(), output.size());
+        addData(hash, input.constData(), input.size());
+        addData(hash, output.constData(), output.size());
+    }
+
+    QByteArray header(kMagic, sizeof(kMagic));
+    appendU32(header, kFormatVersion);
+    appendU32(header, quint32(version));
+    appendU32(header, quint32(testCases.size()));
+    header.append(hash.result());
+    ok = ok && file.seek(0) && file.write(header) == header.size() && file.flush();
+    if (!ok) {
+        LOG_ERROR(QString("写入测试数据包失败：%1").arg(file.errorString()));
+        file.close();
+        file.remove();
+        return -1;
+    }
+    file.close();
+    if (!QFile::rename(tmpPath, path)) {
+        QFile::remove(tmpPath);
+        return -1;
+    }
+
+    LOG_INFO(QString("作业 %1 测试数据更新到版本 %2：共 %3 个测试点，%4 个有变化，%5 KB")
+        .arg(homeworkId)
+        .arg(version)
+        .arg(testCases.size())
+        .arg(changedCases->size())
+        .arg(offset / 1024));
+    return version;
+}
+
+int TestSetStore::openPackCount()
+{
+    QMutexLocker locker(&mutex);
+    return openPacks.size();
+}
+
+QSharedPointer<TestSetPack> TestSetStore::open(int homeworkId, int version)
+{
+    QPair<int, int> key(homeworkId, version);
+    {
+        QMutexLocker locker(&mutex);
+        auto it = openPacks.constFind(key);
+        if (it != openPacks.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // 映射与校验在锁外进行；数据包写入后不再修改，重复打开无副作用
+    QSharedPointer<TestSetPack> pack(new TestSetPack);
+    QString error;
+    if (!pack->open(packPath(homeworkId, version), &error)) {
+        LOG_ERROR(QString("作业 %1 测试数据版本 %2：%3").arg(homeworkId).arg(version).arg(error));
+        return QSharedPointer<TestSetPack>();
+    }
+
+    QMutexLocker locker(&mutex);
+    if (openPacks.size() >= kMaxOpenPacks) {
+        // 正在使用的数据包由调用方持有的指针保持映射
+        openPacks.clear();
+    }
+    openPacks.insert(key, pack);
+    return pack;
+}
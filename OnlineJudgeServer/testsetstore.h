@@ -0,0 +1,93 @@
+#ifndef TESTSETSTORE_H
+#define TESTSETSTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QSharedPointer>
+
+// 一个测试点在映射内存中的位置，数据包对象存在期间有效
+struct TestCaseView
+{
+    const char *input = nullptr;
+    qint64 inputSize = 0;
+    const char *output = nullptr;
+    qint64 outputSize = 0;
+};
+
+// 一个版本的测试数据包，只读映射到内存
+// 文件格式（小端）：
+//   头部 48 字节：魔数 "OJTS"、格式版本、数据版本号、测试点数、其后全部内容的 SHA-256
+//   索引每个测试点 72 字节：输入偏移/长度、输出偏移/长度（均为 64 位）、
+//                           测试点内容 SHA-256、标志位（bit0 表示相对上一版本有变化）、保留
+//   数据区：各测试点输入与输出的原始字节，评测时直接从映射内存读取，不解压、不复制
+// 格式版本 1 的旧数据包各段为 qCompress 的结果，只能经 readCase 解压读取
+// 打开时校验整体 SHA-256，之后可被多个线程同时读取
+class TestSetPack
+{
+public:
+    ~TestSetPack();
+
+    int version() const { return packVersion; }
+    int caseCount() const { return count; }
+    // 头部记录的整个数据包内容的 SHA-256
+    QByteArray contentDigest() const;
+    // 测试点内容哈希，用于跨版本判断测试点是否改动
+    QByteArray caseHash(int index) const;
+    bool caseChanged(int index) const;
+
+    // 第 index 个测试点在映射内存中的位置；旧格式的数据包返回 false
+    bool view(int index, TestCaseView *view) const;
+    // 复制（旧格式为解压）第 index 个测试点
+    bool readCase(int index, QByteArray *input, QByteArray *output) const;
+
+private:
+    friend class TestSetStore;
+    TestSetPack();
+
+    bool open(const QString &path, QString *error);
+    const uchar *entry(int index) const;
+    bool inRange(quint64 offset, quint64 length) const;
+    bool readBlob(quint64 offset, quint32 stored, quint32 rawSize, QByteArray *out) const;
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    quint32 format;
+    int packVersion;
+    int count;
+};
+
+// 按作业保存测试数据包：<dir>/<作业ID>/v<版本>.pack，版本号从 1 递增
+// 可被多个线程同时调用
+class TestSetStore
+{
+public:
+    explicit TestSetStore(const QString &dir);
+
+    // 写入新版本并返回版本号，失败返回 -1；写入大量数据时耗时较长，不要在事件循环中调用
+    // changedCases 返回相对上一版本新增或内容改动的测试点下标
+    int publish(int homeworkId, const QJsonArray &testCases, QList<int> *changedCases);
+
+    // 打开并校验指定版本，失败返回空指针
+    QSharedPointer<TestSetPack> open(int homeworkId, int version);
+
+    int latestVersion(int homeworkId);
+    // 已映射的数据包数量
+    int openPackCount();
+
+private:
+    QString packPath(int homeworkId, int version) const;
+
+    QString dir;
+    QMutex publishMutex;
+    QMutex mutex;  // 保护 openPacks
+    QHash<QPair<int, int>, QSharedPointer<TestSetPack>> openPacks;
+};
+
+#endif // TESTSETSTORE_H
@@ -0,0 +1,235 @@
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include "logger.h"
+
+namespace {
+
+// 攒够这么多事件，或最早的事件已等待 kFlushIntervalMs，就写出一个文件
+const int kFlushEvents = 20000;
+const qint64 kFlushIntervalMs = 10000;
+
+// 线程当前所在请求的追踪状态与已结束的阶段
+struct ThreadTrace
+{
+    quint64 traceId = 0;
+    bool sampled = false;
+    int tid = 0;
+    QVector<TraceEvent> events;
+};
+
+thread_local ThreadTrace threadTrace;
+
+// 把一批事件写成 Chrome trace 事件格式
+class TraceWriteTask : public QRunnable
+{
+public:
+    TraceWriteTask(const QString &path, const QVector<TraceEvent> &events)
+        : path(path), events(events) {}
+
+    void run() override
+    {
+        qint64 pid = QCoreApplication::applicationPid();
+        QJsonArray traceEvents;
+        for (const TraceEvent &event : events) {
+            QJsonObject args{{"trace", QString::number(event.traceId)}};
+            if (!event.detail.isEmpty()) {
+                args["detail"] = event.detail;
+            }
+            traceEvents.append(QJsonObject{
+                {"name", QString::fromLatin1(event.name)},
+                {"cat", QString::fromLatin1(event.name).section('.', 0, 0)},
+                {"ph", "X"},
+                {"ts", event.startUs},
+                {"dur", event.durationUs},
+                {"pid", pid},
+                {"tid", event.tid},
+                {"args", args}
+            });
+        }
+
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            LOG_ERROR(QString("无法写入追踪文件：%1").arg(file.errorString()));
+            return;
+        }
+        QJsonObject root{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        LOG_INFO(QString("已写出 %1 个追踪事件：%2").arg(events.size()).arg(path));
+    }
+
+private:
+    QString path;
+    QVector<TraceEvent> events;
+};
+
+} // namespace
+
+Tracer *Tracer::instance()
+{
+    static Tracer *tracer = new Tracer();
+    return tracer;
+}
+
+Tracer::Tracer()
+    : lastTraceId(0)
+    , sampleEvery(0)
+    , nextTid(0)
+    , outputDir("traces")
+    , oldestPendingUs(-1)
+{
+    clock.start();
+    writerPool.setMaxThreadCount(1);
+}
+
+void Tracer::setSampling(int everyN)
+{
+    sampleEvery.storeRelease(qMax(0, everyN));
+}
+
+void Tracer::setOutputDirectory(const QString &dir)
+{
+    QMutexLocker locker(&mutex);
+    outputDir = dir;
+}
+
+quint64 Tracer::currentTraceId()
+{
+    return threadTrace.traceId;
+}
+
+quint64 Tracer::nextTraceId()
+{
+    return lastTraceId.fetchAndAddRelaxed(1) + 1;
+}
+
+bool Tracer::shouldSample(quint64 traceId) const
+{
+    int every = sampleEvery.loadAcquire();
+    return every > 0 && traceId % quint64(every) == 0;
+}
+
+qint64 Tracer::nowUs() const
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void Tracer::complete(QVector<TraceEvent> &events)
+{
+    bool due;
+    {
+        QMutexLocker locker(&mutex);
+        if (completed.isEmpty()) {
+            oldestPendingUs = nowUs();
+        }
+        completed += events;
+        due = completed.size() >= kFlushEvents || nowUs() - oldestPendingUs >= kFlushIntervalMs * 1000;
+    }
+    events.clear();
+    if (due) {
+        flush();
+    }
+}
+
+void Tracer::flushStale()
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (completed.isEmpty() || nowUs() - oldestPendingUs < kFlushIntervalMs * 1000) {
+            return;
+        }
+    }
+    flush();
+}
+
+int Tracer::flushIntervalMs()
+{
+    return int(kFlushIntervalMs);
+}
+
+void Tracer::flush()
+{
+    QVector<TraceEvent> batch;
+    QString path;
+    {
+        QMutexLocker locker(&mutex);
+        if (completed.isEmpty()) {
+            return;
+        }
+        batch.swap(completed);
+        QDir().mkpath(outputDir);
+        path = QString("%1/trace_%2.json")
+            .arg(outputDir)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz"));
+    }
+    writerPool.start(new TraceWriteTask(path, batch));
+}
+
+QJsonObject Tracer::stats()
+{
+    int pending;
+    {
+        QMutexLocker locker(&mutex);
+        pending = completed.size();
+    }
+    return QJsonObject{
+        {"sampleEvery", sampleEvery.loadAcquire()},
+        {"pendingEvents", pending},
+        {"writing", writerPool.activeThreadCount()}
+    };
+}
+
+void Tracer::stop()
+{
+    flush();
+    writerPool.waitForDone();
+}
+
+RequestTrace::RequestTrace()
+    : traceId(Tracer::instance()->nextTraceId())
+    , outerTraceId(threadTrace.traceId)
+    , outerSampled(threadTrace.sampled)
+{
+    threadTrace.traceId = traceId;
+    threadTrace.sampled = Tracer::instance()->shouldSample(traceId);
+    if (threadTrace.sampled && threadTrace.tid == 0) {
+        threadTrace.tid = Tracer::instance()->nextTid.fetchAndAddRelaxed(1) + 1;
+    }
+}
+
+RequestTrace::~RequestTrace()
+{
+    if (threadTrace.sampled) {
+        Tracer::instance()->complete(threadTrace.events);
+    }
+    threadTrace.traceId = outerTraceId;
+    threadTrace.sampled = outerSampled;
+}
+
+TraceSpan::TraceSpan(const char *name, const QString &detail)
+    : name(name)
+    , startUs(0)
+    , active(threadTrace.sampled)
+{
+    if (active) {
+        this->detail = detail;
+        startUs = Tracer::instance()->nowUs();
+    }
+}
+
+void TraceSpan::end()
+{
+    if (!active) {
+        return;
+    }
+    active = false;
+    qint64 endUs = Tracer::instance()->nowUs();
+    threadTrace.events.append(TraceEvent{name, detail, threadTrace.traceId, threadTrace.tid,
+                                         startUs, endUs - startUs});
+}
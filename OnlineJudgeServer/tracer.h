@@ -0,0 +1,106 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QJsonObject>
+
+// 一个已结束的阶段，对应 Chrome trace 的完整事件（ph = "X"）
+struct TraceEvent
+{
+    const char *name;
+    QString detail;
+    quint64 traceId;
+    int tid;
+    qint64 startUs;
+    qint64 durationUs;
+};
+
+// 请求级追踪：每个请求在 handleReadyRead 中分配追踪ID，各处理阶段用 TraceSpan 计时
+// 每 N 个请求采样一个；采样请求的阶段先记在线程本地缓冲中，请求结束时汇总，
+// 攒够一批或等待超过一定时间后在后台写成 Chrome trace 事件格式（traces/trace_*.json），
+// 可直接用 chrome://tracing 或 Perfetto 打开。未被采样的请求只付出一次线程本地变量读取
+class Tracer
+{
+public:
+    static Tracer *instance();
+
+    // everyN 为 0 时关闭采样，1 为记录所有请求
+    void setSampling(int everyN);
+    void setOutputDirectory(const QString &dir);
+    // 当前线程正在处理的请求的追踪ID，不在请求中时为 0
+    static quint64 currentTraceId();
+
+    // 把已完成的事件交给后台写出
+    void flush();
+    // 最早的未写出事件已等待超过 flushIntervalMs() 时写出；采样稀疏或请求停止时由定时器调用
+    void flushStale();
+    static int flushIntervalMs();
+    // 写出剩余事件并等待写完，进程退出前调用
+    void stop();
+    // 尚未交给后台写出的事件数与正在写的文件数
+    QJsonObject stats();
+
+private:
+    friend class RequestTrace;
+    friend class TraceSpan;
+
+    Tracer();
+
+    quint64 nextTraceId();
+    bool shouldSample(quint64 traceId) const;
+    qint64 nowUs() const;
+    void complete(QVector<TraceEvent> &events);
+
+    QAtomicInteger<quint64> lastTraceId;
+    QAtomicInt sampleEvery;
+    QAtomicInt nextTid;
+    QElapsedTimer clock;
+    QMutex mutex;  // 保护以下成员
+    QString outputDir;
+    QVector<TraceEvent> completed;
+    qint64 oldestPendingUs;  // completed 中最早事件的入队时间
+    QThreadPool writerPool;
+};
+
+// 一个请求的追踪范围，请求数据收完后构造，析构时结束
+class RequestTrace
+{
+public:
+    RequestTrace();
+    ~RequestTrace();
+
+    quint64 id() const { return traceId; }
+
+private:
+    Q_DISABLE_COPY(RequestTrace)
+
+    quint64 traceId;
+    quint64 outerTraceId;
+    bool outerSampled;
+};
+
+// 一个处理阶段，构造时开始，析构或调用 end() 时结束；所在请求未被采样时不做任何事
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const QString &detail = QString());
+    ~TraceSpan() { end(); }
+
+    void end();
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *name;
+    QString detail;
+    qint64 startUs;
+    bool active;
+};
+
+#endif // TRACER_H
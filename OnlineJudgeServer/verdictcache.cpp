@@ -0,0 +1,130 @@
+#include "verdictcache.h"
+#include <QCryptographicHash>
+#include "logger.h"
+
+VerdictCache::VerdictCache(int capacity)
+    : maxEntries(qMax(1, capacity))
+    , hits(0)
+    , misses(0)
+    , invalidations(0)
+{
+}
+
+QByteArray VerdictCache::makeKey(const QByteArray &artifactHash, const QByteArray &testSetVersion,
+                                 const QString &limitsKey)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(artifactHash);
+    hash.addData("\0", 1);
+    hash.addData(testSetVersion);
+    hash.addData("\0", 1);
+    hash.addData(limitsKey.toUtf8());
+    return hash.result().toHex();
+}
+
+bool VerdictCache::lookup(int homeworkId, const QByteArray &testSetVersion, const QByteArray &key,
+                          JudgeResult *result)
+{
+    QMutexLocker locker(&mutex);
+    checkVersionLocked(homeworkId, testSetVersion);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        ++misses;
+        return false;
+    }
+    lru.splice(lru.begin(), lru, it->lruPos);
+    *result = it->result;
+    ++hits;
+    return true;
+}
+
+void VerdictCache::store(int homeworkId, const QByteArray &testSetVersion, const QByteArray &key,
+                         const JudgeResult &result)
+{
+    QMutexLocker locker(&mutex);
+    // 评测期间测试数据已更新，旧版本的结果不再入缓存
+    auto version = versions.constFind(homeworkId);
+    if (version != versions.constEnd() && version.value() != testSetVersion) {
+        return;
+    }
+    versions.insert(homeworkId, testSetVersion);
+    if (entries.contains(key)) {
+        removeLocked(key);
+    }
+
+    lru.push_front(key);
+    Entry entry;
+    entry.homeworkId = homeworkId;
+    entry.result = result;
+    entry.lruPos = lru.begin();
+    entries.insert(key, entry);
+    keysByHomework[homeworkId].insert(key);
+
+    while (entries.size() > maxEntries) {
+        removeLocked(lru.back());
+    }
+}
+
+void VerdictCache::invalidate(int homeworkId)
+{
+    QMutexLocker locker(&mutex);
+    versions.remove(homeworkId);
+    QSet<QByteArray> keys = keysByHomework.take(homeworkId);
+    for (const QByteArray &key : keys) {
+        removeLocked(key);
+    }
+    if (!keys.isEmpty()) {
+        ++invalidations;
+        LOG_INFO(QString("作业 %1 测试数据变化，清除 %2 条缓存的评测结果").arg(homeworkId).arg(keys.size()));
+    }
+}
+
+QJsonObject VerdictCache::stats()
+{
+    QMutexLocker locker(&mutex);
+    qint64 lookups = hits + misses;
+    return QJsonObject{
+        {"entries", entries.size()},
+        {"capacity", maxEntries},
+        {"hits", hits},
+        {"misses", misses},
+        {"invalidations", invalidations},
+        {"hitRate", lookups > 0 ? double(hits) / lookups : 0.0}
+    };
+}
+
+void VerdictCache::checkVersionLocked(int homeworkId, const QByteArray &testSetVersion)
+{
+    auto it = versions.find(homeworkId);
+    if (it == versions.end()) {
+        versions.insert(homeworkId, testSetVersion);
+        return;
+    }
+    if (it.value() == testSetVersion) {
+        return;
+    }
+
+    it.value() = testSetVersion;
+    QSet<QByteArray> keys = keysByHomework.take(homeworkId);
+    for (const QByteArray &key : keys) {
+        removeLocked(key);
+    }
+    ++invalidations;
+}
+
+void VerdictCache::removeLocked(const QByteArray &key)
+{
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    auto homework = keysByHomework.find(it->homeworkId);
+    if (homework != keysByHomework.end()) {
+        homework->remove(key);
+        if (homework->isEmpty()) {
+            keysByHomework.erase(homework);
+        }
+    }
+    lru.erase(it->lruPos);
+    entries.erase(it);
+}
@@ -0,0 +1,59 @@
+#ifndef VERDICTCACHE_H
+#define VERDICTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QJsonObject>
+#include <list>
+#include <iterator>
+#include "judger.h"
+
+// 评测结果缓存：以（编译产物哈希, 测试数据版本, 资源限制）为键
+// 空白修改等产生完全相同的可执行文件时，或重测时测试数据未变，直接返回上次的结果
+// 每个作业只保留当前测试数据版本的结果，版本变化时该作业的旧结果全部作废
+// 仅在内存中保存，按 LRU 淘汰；可被多个评测线程同时调用
+class VerdictCache
+{
+public:
+    explicit VerdictCache(int capacity = 4096);
+
+    static QByteArray makeKey(const QByteArray &artifactHash, const QByteArray &testSetVersion,
+                              const QString &limitsKey);
+
+    bool lookup(int homeworkId, const QByteArray &testSetVersion, const QByteArray &key,
+                JudgeResult *result);
+    void store(int homeworkId, const QByteArray &testSetVersion, const QByteArray &key,
+               const JudgeResult &result);
+    // 作业测试数据被修改时调用
+    void invalidate(int homeworkId);
+
+    QJsonObject stats();
+
+private:
+    struct Entry
+    {
+        int homeworkId;
+        JudgeResult result;
+        std::list<QByteArray>::iterator lruPos;
+    };
+
+    // 记录作业的当前版本，版本变化时清掉旧结果
+    void checkVersionLocked(int homeworkId, const QByteArray &testSetVersion);
+    void removeLocked(const QByteArray &key);
+
+    int maxEntries;
+    QHash<QByteArray, Entry> entries;
+    std::list<QByteArray> lru;  // 队首最近使用
+    QHash<int, QByteArray> versions;
+    QHash<int, QSet<QByteArray>> keysByHomework;
+    QMutex mutex;
+
+    qint64 hits;
+    qint64 misses;
+    qint64 invalidations;
+};
+
+#endif // VERDICTCACHE_H
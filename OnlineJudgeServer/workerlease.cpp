@@ -0,0 +1,116 @@
+#include "workerlease.h"
+#include <QDateTime>
+#include <QJsonArray>
+
+namespace {
+
+// 超过此时间没有任何请求的节点不再列入统计
+const qint64 kWorkerForgetMs = 10 * 60 * 1000;
+
+qint64 nowMs()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+} // namespace
+
+WorkerLeases::WorkerLeases(qint64 leaseMs)
+    : duration(leaseMs)
+    , nextLeaseId(1)
+    , granted(0)
+    , completed(0)
+    , expired(0)
+{
+}
+
+void WorkerLeases::touch(const QString &workerId)
+{
+    workerSeenMs[workerId] = nowMs();
+}
+
+qint64 WorkerLeases::grant(const QString &workerId, const JudgeJob &job)
+{
+    touch(workerId);
+    qint64 leaseId = nextLeaseId++;
+    leases.insert(leaseId, Lease{workerId, job, nowMs() + duration});
+    ++jobAttempts[job.jobId];
+    ++granted;
+    return leaseId;
+}
+
+QList<qint64> WorkerLeases::renew(const QString &workerId, const QList<qint64> &leaseIds)
+{
+    touch(workerId);
+    QList<qint64> lost;
+    qint64 expiresMs = nowMs() + duration;
+    for (qint64 leaseId : leaseIds) {
+        auto it = leases.find(leaseId);
+        if (it == leases.end() || it->workerId != workerId) {
+            lost.append(leaseId);
+            continue;
+        }
+        it->expiresMs = expiresMs;
+    }
+    return lost;
+}
+
+bool WorkerLeases::complete(const QString &workerId, qint64 leaseId, JudgeJob *job)
+{
+    touch(workerId);
+    auto it = leases.find(leaseId);
+    if (it == leases.end() || it->workerId != workerId) {
+        return false;
+    }
+    *job = it->job;
+    leases.erase(it);
+    ++completed;
+    return true;
+}
+
+QList<JudgeJob> WorkerLeases::expire()
+{
+    QList<JudgeJob> jobs;
+    qint64 now = nowMs();
+    for (auto it = leases.begin(); it != leases.end();) {
+        if (it->expiresMs <= now) {
+            jobs.append(it->job);
+            it = leases.erase(it);
+            ++expired;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = workerSeenMs.begin(); it != workerSeenMs.end();) {
+        if (now - it.value() > kWorkerForgetMs) {
+            it = workerSeenMs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return jobs;
+}
+
+QJsonObject WorkerLeases::stats() const
+{
+    QHash<QString, int> active;
+    for (const Lease &lease : leases) {
+        ++active[lease.workerId];
+    }
+    QJsonArray workers;
+    qint64 now = nowMs();
+    for (auto it = workerSeenMs.cbegin(); it != workerSeenMs.cend(); ++it) {
+        workers.append(QJsonObject{
+            {"workerId", it.key()},
+            {"leases", active.value(it.key())},
+            {"idleMs", now - it.value()}
+        });
+    }
+    return QJsonObject{
+        {"leaseMs", duration},
+        {"activeLeases", leases.size()},
+        {"granted", granted},
+        {"completed", completed},
+        {"expired", expired},
+        {"workers", workers}
+    };
+}
@@ -0,0 +1,60 @@
+#ifndef WORKERLEASE_H
+#define WORKERLEASE_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QJsonObject>
+#include "judger.h"
+
+// 远程评测节点的任务租约
+// 节点拉取任务时获得租约，评测期间定期心跳续约，提交结果时归还；
+// 节点崩溃或失联导致租约过期后，任务由服务器放回评测队列
+// 只在主线程调用
+class WorkerLeases
+{
+public:
+    explicit WorkerLeases(qint64 leaseMs = 15000);
+
+    qint64 leaseMs() const { return duration; }
+
+    // 登记租约并返回租约ID
+    qint64 grant(const QString &workerId, const JudgeJob &job);
+    // 续约，返回已失效（过期或不属于该节点）的租约ID
+    QList<qint64> renew(const QString &workerId, const QList<qint64> &leaseIds);
+    // 归还租约；租约仍有效时取出对应任务并返回 true
+    bool complete(const QString &workerId, qint64 leaseId, JudgeJob *job);
+    // 移除所有过期的租约并返回其任务
+    QList<JudgeJob> expire();
+
+    // 尚未归还或过期的租约数
+    int activeCount() const { return leases.size(); }
+    // 同一任务已被租出的次数
+    int attempts(qint64 jobId) const { return jobAttempts.value(jobId); }
+    // 任务得出最终结果时调用，不论最后在哪里评测
+    void forget(qint64 jobId) { jobAttempts.remove(jobId); }
+
+    QJsonObject stats() const;
+
+private:
+    struct Lease
+    {
+        QString workerId;
+        JudgeJob job;
+        qint64 expiresMs;
+    };
+
+    void touch(const QString &workerId);
+
+    qint64 duration;
+    qint64 nextLeaseId;
+    QHash<qint64, Lease> leases;
+    QHash<qint64, int> jobAttempts;
+    QHash<QString, qint64> workerSeenMs;  // 各节点最近一次请求的时间
+
+    qint64 granted;
+    qint64 completed;
+    qint64 expired;
+};
+
+#endif // WORKERLEASE_H
@@ -0,0 +1,355 @@
+#include "zygotepool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include "logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+
+// 空闲进程与服务器共享写时复制的页面，闲置过久会随服务器写入逐渐占用内存，需要定期轮换
+const qint64 kZygoteMaxIdleMs = 30000;
+// 一组限制长时间无人使用时整组回收
+const qint64 kKeyMaxIdleMs = 60000;
+const int kMaxPathLength = 4096;
+
+void closeFd(int &fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// 子进程中使用，只调用 read
+bool readAll(int fd, char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = ::read(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// 子进程中使用：读取一个带长度前缀的路径并以 0 结尾
+bool readPath(int fd, char *path)
+{
+    quint32 length = 0;
+    if (!readAll(fd, reinterpret_cast<char*>(&length), sizeof(length))
+        || length == 0 || length >= quint32(kMaxPathLength)
+        || !readAll(fd, path, length)) {
+        return false;
+    }
+    path[length] = '\0';
+    return true;
+}
+
+void appendPath(QByteArray &message, const QByteArray &path)
+{
+    quint32 length = quint32(path.size());
+    message.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    message.append(path);
+}
+
+} // namespace
+
+ZygotePool::ZygotePool(int perKey, QObject *parent)
+    : QThread(parent)
+    , perKey(qMax(1, perKey))
+    , stopping(false)
+{
+}
+
+ZygotePool::~ZygotePool()
+{
+    stop();
+}
+
+void ZygotePool::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        refillNeeded.wakeAll();
+    }
+    wait();
+
+    QMutexLocker locker(&mutex);
+    for (KeyPool &pool : pools) {
+        for (Zygote &zygote : pool.ready) {
+            discard(zygote);
+        }
+    }
+    pools.clear();
+}
+
+bool ZygotePool::spawnZygote(const ResourceLimits &limits, Zygote *zygote)
+{
+    int controlPipe[2] = {-1, -1};
+    int inPipe[2] = {-1, -1};
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    int execPipe[2] = {-1, -1};
+    if (pipe2(controlPipe, O_CLOEXEC) < 0 || pipe2(inPipe, O_CLOEXEC) < 0
+        || pipe2(outPipe, O_CLOEXEC) < 0 || pipe2(errPipe, O_CLOEXEC) < 0
+        || pipe2(execPipe, O_CLOEXEC) < 0) {
+        for (int *p : {controlPipe, inPipe, outPipe, errPipe, execPipe}) {
+            closeFd(p[0]);
+            closeFd(p[1]);
+        }
+        return false;
+    }
+
+    zygote->cgroupDir = Sandbox::createCgroup(limits);
+    int procsFd = -1;
+    if (!zygote->cgroupDir.isEmpty()) {
+        procsFd = ::open(QFile::encodeName(zygote->cgroupDir + "/cgroup.procs").constData(),
+                         O_WRONLY | O_CLOEXEC);
+        // 进不了 cgroup 时按无 cgroup 处理：由 RLIMIT_AS 限制，不读取空 cgroup 的统计
+        if (procsFd < 0) {
+            QDir().rmdir(zygote->cgroupDir);
+            zygote->cgroupDir.clear();
+        }
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // 保留控制管道读端和 exec 状态管道写端，后者依赖 O_CLOEXEC 在 exec 成功时关闭
+        int keep[2] = {qMin(controlPipe[0], execPipe[1]), qMax(controlPipe[0], execPipe[1])};
+        // 空闲期间停在根目录，不占住任何评测目录
+        if (!Sandbox::setupChild(limits, inPipe[0], outPipe[1], errPipe[1], keep, 2, procsFd)
+            || chdir("/") != 0) {
+            int err = errno;
+            ssize_t ignored = ::write(execPipe[1], &err, sizeof(err));
+            Q_UNUSED(ignored);
+            _exit(127);
+        }
+
+        // 阻塞等待可执行文件路径与工作目录；读到 EOF 说明池已丢弃该进程
+        char path[kMaxPathLength];
+        char dir[kMaxPathLength];
+        if (!readPath(controlPipe[0], path) || !readPath(controlPipe[0], dir)) {
+            _exit(0);
+        }
+
+        // 与冷启动的 Sandbox::run 一样在调用方给出的工作目录中运行
+        char *argv[] = {path, nullptr};
+        if (chdir(dir) == 0) {
+            execv(path, argv);
+        }
+        int err = errno;
+        ssize_t ignored = ::write(execPipe[1], &err, sizeof(err));
+        Q_UNUSED(ignored);
+        _exit(127);
+    }
+
+    closeFd(controlPipe[0]);
+    closeFd(inPipe[0]);
+    closeFd(outPipe[1]);
+    closeFd(errPipe[1]);
+    closeFd(execPipe[1]);
+    closeFd(procsFd);
+
+    zygote->pid = pid;
+    zygote->controlFd = controlPipe[1];
+    zygote->stdinFd = inPipe[1];
+    zygote->stdoutFd = outPipe[0];
+    zygote->stderrFd = errPipe[0];
+    zygote->execFd = execPipe[0];
+    zygote->createdMs = QDateTime::currentMSecsSinceEpoch();
+
+    if (pid < 0) {
+        discard(*zygote);
+        return false;
+    }
+    return true;
+}
+
+void ZygotePool::discard(Zygote &zygote)
+{
+    // 关闭控制管道后空闲进程读到 EOF 自行退出
+    closeFd(zygote.controlFd);
+    closeFd(zygote.stdinFd);
+    closeFd(zygote.stdoutFd);
+    closeFd(zygote.stderrFd);
+    closeFd(zygote.execFd);
+    if (zygote.pid > 0) {
+        while (waitpid(zygote.pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        zygote.pid = -1;
+    }
+    if (!zygote.cgroupDir.isEmpty()) {
+        QDir().rmdir(zygote.cgroupDir);
+    }
+}
+
+RunResult ZygotePool::execute(const QString &binary, const QByteArray &input,
+                              const ResourceLimits &limits, const QString &workDir,
+                              OutputSink *sink)
+{
+    QString key = limits.key();
+    Zygote zygote;
+    bool warm = false;
+    {
+        QMutexLocker locker(&mutex);
+        auto it = pools.find(key);
+        if (it == pools.end()) {
+            it = pools.insert(key, KeyPool());
+            it->limits = limits;
+        }
+        it->lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+        if (!it->ready.isEmpty()) {
+            zygote = it->ready.takeFirst();
+            warm = true;
+        }
+        refillNeeded.wakeOne();
+    }
+
+    QByteArray path = QFile::encodeName(QFileInfo(binary).absoluteFilePath());
+    QByteArray dir = QFile::encodeName(QFileInfo(workDir).absoluteFilePath());
+    qint64 startUs = Sandbox::monotonicUs();
+    if (warm) {
+        QByteArray message;
+        appendPath(message, path);
+        appendPath(message, dir);
+        warm = path.size() < kMaxPathLength && !dir.isEmpty() && dir.size() < kMaxPathLength
+            && writeAll(zygote.controlFd, message.constData(), size_t(message.size()));
+        closeFd(zygote.controlFd);
+        if (!warm) {
+            // 路径过长或空闲进程已意外退出，改走冷启动
+            discard(zygote);
+        }
+    }
+
+    if (!warm) {
+        RunResult result = Sandbox::run({binary}, input, limits, workDir, sink);
+        coldSpawnUs.record(result.spawnUs);
+        return result;
+    }
+
+    int childErrno = 0;
+    ssize_t n;
+    do {
+        n = ::read(zygote.execFd, &childErrno, sizeof(childErrno));
+    } while (n < 0 && errno == EINTR);
+    closeFd(zygote.execFd);
+    qint64 spawnUs = Sandbox::monotonicUs() - startUs;
+
+    SandboxProcess process;
+    process.pid = zygote.pid;
+    process.stdinFd = zygote.stdinFd;
+    process.stdoutFd = zygote.stdoutFd;
+    process.stderrFd = zygote.stderrFd;
+    process.startUs = startUs;
+    process.cgroupDir = zygote.cgroupDir;
+
+    RunResult result = Sandbox::supervise(process, input, limits,
+                                          n == sizeof(childErrno) ? childErrno : 0, sink);
+    result.spawnUs = spawnUs;
+    if (result.status == RunResult::SystemError) {
+        result.error = QString("无法执行 %1：%2").arg(binary).arg(result.error);
+    }
+    warmSpawnUs.record(spawnUs);
+    return result;
+}
+
+void ZygotePool::run()
+{
+    QMutexLocker locker(&mutex);
+    while (!stopping) {
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QList<Zygote> expired;
+        QList<ResourceLimits> wanted;
+
+        for (auto it = pools.begin(); it != pools.end();) {
+            if (now - it->lastUsedMs > kKeyMaxIdleMs) {
+                expired.append(it->ready);
+                it = pools.erase(it);
+                continue;
+            }
+            for (int i = it->ready.size() - 1; i >= 0; --i) {
+                if (now - it->ready[i].createdMs > kZygoteMaxIdleMs) {
+                    expired.append(it->ready.takeAt(i));
+                }
+            }
+            for (int i = it->ready.size(); i < perKey; ++i) {
+                wanted.append(it->limits);
+            }
+            ++it;
+        }
+
+        // fork 与回收在锁外进行，不阻塞评测线程取进程
+        locker.unlock();
+        for (Zygote &zygote : expired) {
+            discard(zygote);
+        }
+        QList<QPair<QString, Zygote>> spawned;
+        for (const ResourceLimits &limits : wanted) {
+            Zygote zygote;
+            if (spawnZygote(limits, &zygote)) {
+                spawned.append(qMakePair(limits.key(), zygote));
+            }
+        }
+        locker.relock();
+
+        for (auto &entry : spawned) {
+            auto it = pools.find(entry.first);
+            if (it == pools.end() || stopping) {
+                discard(entry.second);
+            } else {
+                it->ready.append(entry.second);
+            }
+        }
+
+        // 无需补充或 fork 失败时等待下一次唤醒，避免空转
+        if (!stopping && (wanted.isEmpty() || spawned.isEmpty())) {
+            refillNeeded.wait(&mutex, 1000);
+        }
+    }
+}
+
+QJsonObject ZygotePool::stats()
+{
+    int idle = 0;
+    {
+        QMutexLocker locker(&mutex);
+        for (const KeyPool &pool : pools) {
+            idle += pool.ready.size();
+        }
+    }
+    return QJsonObject{
+        {"idle", idle},
+        {"warmSpawnUs", warmSpawnUs.summary()},
+        {"coldSpawnUs", coldSpawnUs.summary()}
+    };
+}
@@ -0,0 +1,72 @@
+#ifndef ZYGOTEPOOL_H
+#define ZYGOTEPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QList>
+#include <QAtomicInteger>
+#include <QJsonObject>
+#include "sandbox.h"
+#include "latencyrecorder.h"
+
+// 预派生的评测进程池
+// 每个空闲进程已 fork、施加好限制，阻塞在控制管道上；
+// 评测时只需写入可执行文件路径与工作目录，子进程切换目录后即 exec，省去每个测试点的 fork 与初始化
+// 进程按资源限制分组，补充工作在独立线程中完成
+class ZygotePool : public QThread
+{
+    Q_OBJECT
+public:
+    // perKey 为每组限制保持的空闲进程数
+    explicit ZygotePool(int perKey, QObject *parent = nullptr);
+    ~ZygotePool();
+
+    void stop();
+
+    // 运行编译产物；没有空闲进程时退回 Sandbox::run 冷启动
+    RunResult execute(const QString &binary, const QByteArray &input,
+                      const ResourceLimits &limits, const QString &workDir,
+                      OutputSink *sink = nullptr);
+
+    // 预热与冷启动两条路径的进程创建耗时分布（微秒）
+    QJsonObject stats();
+
+protected:
+    void run() override;
+
+private:
+    struct Zygote
+    {
+        pid_t pid = -1;
+        int controlFd = -1;
+        int stdinFd = -1;
+        int stdoutFd = -1;
+        int stderrFd = -1;
+        int execFd = -1;
+        qint64 createdMs = 0;
+        QString cgroupDir;
+    };
+
+    struct KeyPool
+    {
+        ResourceLimits limits;
+        QList<Zygote> ready;
+        qint64 lastUsedMs = 0;
+    };
+
+    bool spawnZygote(const ResourceLimits &limits, Zygote *zygote);
+    void discard(Zygote &zygote);
+
+    int perKey;
+    bool stopping;
+    QHash<QString, KeyPool> pools;
+    QMutex mutex;
+    QWaitCondition refillNeeded;
+
+    LatencyRecorder warmSpawnUs;
+    LatencyRecorder coldSpawnUs;
+};
+
+#endif // ZYGOTEPOOL_H
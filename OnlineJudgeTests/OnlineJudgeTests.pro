@@ -0,0 +1,5 @@
+# 单元测试，与服务器分开构建；qmake && make check 运行
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    comparator
@@ -0,0 +1,22 @@
+QT -= gui
+QT += testlib
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_outputcomparator
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+
+# 只依赖服务器的输出比较器
+SERVER_DIR = ../../OnlineJudgeServer
+INCLUDEPATH += $$SERVER_DIR
+
+SOURCES += \
+    tst_outputcomparator.cpp \
+    $$SERVER_DIR/outputcomparator.cpp
+
+HEADERS += \
+    $$SERVER_DIR/outputcomparator.h
@@ -0,0 +1,230 @@
+#include <QtTest>
+#include "outputcomparator.h"
+
+namespace {
+
+// 选手输出按 chunkSize 字节一块送入比较器，chunkSize 为 0 表示一次送完
+bool feed(OutputComparator &comparator, const QByteArray &actual, int chunkSize = 0)
+{
+    if (chunkSize <= 0) {
+        chunkSize = qMax(actual.size(), 1);
+    }
+    for (int i = 0; i < actual.size(); i += chunkSize) {
+        if (!comparator.consume(actual.constData() + i, qMin(chunkSize, actual.size() - i))) {
+            break;
+        }
+    }
+    return comparator.finish();
+}
+
+bool matches(OutputComparator::Mode mode, const QByteArray &expected, const QByteArray &actual,
+             int chunkSize = 0, double epsilon = 1e-6)
+{
+    OutputComparator comparator(mode, epsilon);
+    comparator.setExpected(expected.constData(), expected.size());
+    return feed(comparator, actual, chunkSize);
+}
+
+// 超过 16 字节，覆盖 SSE2 的整块比较路径
+const QByteArray kLongToken = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+} // namespace
+
+class OutputComparatorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void modeFromString();
+    void exactMatch();
+    void exactMismatchPosition();
+    void exactLengthDiffers();
+    void lineIgnoresTrailingSpace();
+    void lineMismatchPosition();
+    void lineMissingOutput();
+    void tokenIgnoresWhitespace();
+    void tokenMismatchPosition();
+    void tokenExtraOutput();
+    void floatWithinEpsilon();
+    void floatOutsideEpsilon();
+    void chunkBoundaries();
+};
+
+void OutputComparatorTest::modeFromString()
+{
+    QCOMPARE(OutputComparator::modeFromString("exact"), OutputComparator::Exact);
+    QCOMPARE(OutputComparator::modeFromString("line"), OutputComparator::Line);
+    QCOMPARE(OutputComparator::modeFromString("token"), OutputComparator::Token);
+    QCOMPARE(OutputComparator::modeFromString("float"), OutputComparator::Float);
+    QCOMPARE(OutputComparator::modeFromString(""), OutputComparator::Line);
+}
+
+void OutputComparatorTest::exactMatch()
+{
+    QVERIFY(matches(OutputComparator::Exact, kLongToken + "\n", kLongToken + "\n"));
+    QVERIFY(matches(OutputComparator::Exact, "", ""));
+    QVERIFY(!matches(OutputComparator::Exact, "1 2\n", "1 2 \n"));
+}
+
+void OutputComparatorTest::exactMismatchPosition()
+{
+    QByteArray expected = "first line\n" + kLongToken + "\n";
+    QByteArray actual = expected;
+    actual[11 + 20] = 'X';
+
+    OutputComparator comparator(OutputComparator::Exact);
+    comparator.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(comparator, actual));
+    QVERIFY(!comparator.matched());
+    QCOMPARE(comparator.actualOffset(), qint64(31));
+    QCOMPARE(comparator.expectedOffset(), qint64(31));
+    QCOMPARE(comparator.expectedLine(), qint64(2));
+    QCOMPARE(comparator.message(), QString("内容不一致"));
+}
+
+void OutputComparatorTest::exactLengthDiffers()
+{
+    QByteArray expected = kLongToken;
+
+    OutputComparator longer(OutputComparator::Exact);
+    longer.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(longer, expected + "!"));
+    QCOMPARE(longer.actualOffset(), qint64(expected.size()));
+    QCOMPARE(longer.message(), QString("输出多于期望"));
+
+    OutputComparator shorter(OutputComparator::Exact);
+    shorter.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(shorter, expected.left(10)));
+    QCOMPARE(shorter.actualOffset(), qint64(10));
+    QCOMPARE(shorter.expectedOffset(), qint64(10));
+    QCOMPARE(shorter.message(), QString("输出少于期望"));
+}
+
+void OutputComparatorTest::lineIgnoresTrailingSpace()
+{
+    QVERIFY(matches(OutputComparator::Line, "1 2\n3 4\n", "1 2   \n3 4"));
+    QVERIFY(matches(OutputComparator::Line, "1 2\t\n3 4\n\n\n", "1 2\n3 4\n"));
+    QVERIFY(matches(OutputComparator::Line, kLongToken + "\n", kLongToken + " \t\r\n"));
+    // 行内空白与行首空白仍须一致
+    QVERIFY(!matches(OutputComparator::Line, "1 2\n", "1  2\n"));
+    QVERIFY(!matches(OutputComparator::Line, "1 2\n", " 1 2\n"));
+}
+
+void OutputComparatorTest::lineMismatchPosition()
+{
+    QByteArray expected = "line one\nline two\nline three is long enough\n";
+    QByteArray actual = "line one\nline two\nline three is LONG enough\n";
+
+    OutputComparator comparator(OutputComparator::Line);
+    comparator.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(comparator, actual));
+    QCOMPARE(comparator.actualOffset(), qint64(32));
+    QCOMPARE(comparator.expectedOffset(), qint64(32));
+    QCOMPARE(comparator.expectedLine(), qint64(3));
+    QCOMPARE(comparator.message(), QString("内容不一致"));
+}
+
+void OutputComparatorTest::lineMissingOutput()
+{
+    QByteArray expected = "1\n2\n3\n";
+
+    OutputComparator shortLine(OutputComparator::Line);
+    shortLine.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(shortLine, "1\n\n3\n"));
+    QCOMPARE(shortLine.expectedLine(), qint64(2));
+    QCOMPARE(shortLine.message(), QString("该行输出不完整"));
+
+    OutputComparator missing(OutputComparator::Line);
+    missing.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(missing, "1\n2\n"));
+    QCOMPARE(missing.actualOffset(), qint64(4));
+    QCOMPARE(missing.expectedLine(), qint64(3));
+}
+
+void OutputComparatorTest::tokenIgnoresWhitespace()
+{
+    QVERIFY(matches(OutputComparator::Token, "1 2 3\n", "1\n2\t\t3   \n\n"));
+    QVERIFY(matches(OutputComparator::Token, kLongToken + " " + kLongToken, "  " + kLongToken + "\n" + kLongToken));
+    QVERIFY(!matches(OutputComparator::Token, "12 3", "1 23"));
+    QVERIFY(!matches(OutputComparator::Token, "1.0", "1"));
+}
+
+void OutputComparatorTest::tokenMismatchPosition()
+{
+    QByteArray expected = "10 20 30\n40 50\n";
+    QByteArray actual = "10 20 30\n40 51\n";
+
+    OutputComparator comparator(OutputComparator::Token);
+    comparator.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(comparator, actual));
+    // 报告的是不一致记号的起点
+    QCOMPARE(comparator.actualOffset(), qint64(12));
+    QCOMPARE(comparator.expectedOffset(), qint64(12));
+    QCOMPARE(comparator.expectedLine(), qint64(2));
+    QCOMPARE(comparator.message(), QString("记号不一致"));
+}
+
+void OutputComparatorTest::tokenExtraOutput()
+{
+    QByteArray expected = "1 2";
+
+    OutputComparator extra(OutputComparator::Token);
+    extra.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(extra, "1 2 3"));
+    QCOMPARE(extra.actualOffset(), qint64(4));
+    QCOMPARE(extra.message(), QString("输出多于期望"));
+
+    OutputComparator missing(OutputComparator::Token);
+    missing.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(missing, "1\n"));
+    QCOMPARE(missing.message(), QString("输出少于期望"));
+}
+
+void OutputComparatorTest::floatWithinEpsilon()
+{
+    QVERIFY(matches(OutputComparator::Float, "3.14159265 2.0\n", "3.14159266 2.0000001"));
+    QVERIFY(matches(OutputComparator::Float, "1000000", "1000000.5", 0, 1e-6));
+    QVERIFY(matches(OutputComparator::Float, "0.5 yes", "0.50 yes"));
+    QVERIFY(matches(OutputComparator::Float, kLongToken, kLongToken));
+}
+
+void OutputComparatorTest::floatOutsideEpsilon()
+{
+    QByteArray expected = "1.5 3.14159265\n";
+
+    OutputComparator comparator(OutputComparator::Float, 1e-6);
+    comparator.setExpected(expected.constData(), expected.size());
+    QVERIFY(!feed(comparator, "1.5 3.1416\n"));
+    QCOMPARE(comparator.actualOffset(), qint64(4));
+    QCOMPARE(comparator.expectedOffset(), qint64(4));
+    QCOMPARE(comparator.message(), QString("数值误差超出范围"));
+
+    QVERIFY(!matches(OutputComparator::Float, "yes", "no"));
+    QVERIFY(matches(OutputComparator::Float, "1.5", "1.6", 0, 0.2));
+}
+
+void OutputComparatorTest::chunkBoundaries()
+{
+    // 同一组输入无论怎样切块结果都一致
+    QByteArray text = "first " + kLongToken + "\n  2.5 " + kLongToken + kLongToken + "\nlast\n";
+    QByteArray wrong = text;
+    wrong[text.size() - 3] = 'X';
+    for (int chunk : {1, 2, 3, 7, 16, 17, 1000}) {
+        QVERIFY(matches(OutputComparator::Exact, text, text, chunk));
+        QVERIFY(matches(OutputComparator::Line, text, text, chunk));
+        QVERIFY(matches(OutputComparator::Token, text, text, chunk));
+        QVERIFY(matches(OutputComparator::Float, text, text, chunk));
+
+        for (OutputComparator::Mode mode : {OutputComparator::Exact, OutputComparator::Line,
+                                            OutputComparator::Token, OutputComparator::Float}) {
+            OutputComparator comparator(mode);
+            comparator.setExpected(text.constData(), text.size());
+            QVERIFY(!feed(comparator, wrong, chunk));
+            QCOMPARE(comparator.expectedLine(), qint64(3));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(OutputComparatorTest)
+
+#include "tst_outputcomparator.moc"
@@ -0,0 +1,48 @@
+QT -= gui
+QT += network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# 添加 Qt 头文件路径
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtCore
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtNetwork
+
+# 判题逻辑与服务器共用同一份源码
+SERVER_DIR = ../OnlineJudgeServer
+INCLUDEPATH += $$SERVER_DIR
+
+LIBS += -lz
+
+SOURCES += \
+    main.cpp \
+    nodeclient.cpp \
+    judgenode.cpp \
+    $$SERVER_DIR/logger.cpp \
+    $$SERVER_DIR/judger.cpp \
+    $$SERVER_DIR/sandbox.cpp \
+    $$SERVER_DIR/compilecache.cpp \
+    $$SERVER_DIR/latencyrecorder.cpp \
+    $$SERVER_DIR/zygotepool.cpp \
+    $$SERVER_DIR/outputcomparator.cpp \
+    $$SERVER_DIR/checkerpool.cpp \
+    $$SERVER_DIR/verdictcache.cpp \
+    $$SERVER_DIR/testsetstore.cpp
+
+HEADERS += \
+    nodeclient.h \
+    judgenode.h \
+    $$SERVER_DIR/logger.h \
+    $$SERVER_DIR/judger.h \
+    $$SERVER_DIR/sandbox.h \
+    $$SERVER_DIR/compilecache.h \
+    $$SERVER_DIR/latencyrecorder.h \
+    $$SERVER_DIR/zygotepool.h \
+    $$SERVER_DIR/outputcomparator.h \
+    $$SERVER_DIR/checkerpool.h \
+    $$SERVER_DIR/verdictcache.h \
+    $$SERVER_DIR/testsetstore.h
+
+target.path = /usr/local/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,158 @@
+#include "judgenode.h"
+#include <QJsonArray>
+#include "logger.h"
+
+namespace {
+
+// 没有任务时的轮询间隔，逐次加倍到上限
+const int kMinIdleMs = 100;
+const int kMaxIdleMs = 1000;
+// 服务器不可达时的重试间隔上限
+const int kMaxRetryMs = 5000;
+const int kResultAttempts = 5;
+
+} // namespace
+
+NodeSlot::NodeSlot(JudgeNode *node, int index, QObject *parent)
+    : QThread(parent)
+    , node(node)
+    , index(index)
+{
+}
+
+void NodeSlot::run()
+{
+    int idleMs = kMinIdleMs;
+    int retryMs = kMinIdleMs;
+    while (!node->stopping.loadAcquire()) {
+        QJsonObject reply;
+        int status = node->client.post("/api/worker/lease", {{"max", 1}}, &reply);
+        if (status != 200) {
+            if (retryMs == kMinIdleMs) {
+                LOG_WARNING(QString("评测槽 %1 无法租用任务（HTTP %2），稍后重试").arg(index).arg(status));
+            }
+            msleep(retryMs);
+            retryMs = qMin(retryMs * 2, kMaxRetryMs);
+            continue;
+        }
+        retryMs = kMinIdleMs;
+
+        QJsonArray jobs = reply["jobs"].toArray();
+        if (jobs.isEmpty()) {
+            msleep(idleMs);
+            idleMs = qMin(idleMs * 2, kMaxIdleMs);
+            continue;
+        }
+        idleMs = kMinIdleMs;
+
+        qint64 leaseMs = reply["leaseMs"].toVariant().toLongLong();
+        for (const QJsonValue &val : jobs) {
+            QJsonObject leased = val.toObject();
+            qint64 leaseId = leased["leaseId"].toString().toLongLong();
+            JudgeJob job = JudgeJob::fromJson(leased["job"].toObject());
+
+            node->addLease(leaseId, leaseMs);
+            JudgeResult result = node->judger->judge(job);
+            submit(leaseId, result);
+            node->removeLease(leaseId);
+        }
+    }
+}
+
+void NodeSlot::submit(qint64 leaseId, const JudgeResult &result)
+{
+    QJsonObject body{
+        {"leaseId", QString::number(leaseId)},
+        {"result", result.toJson()}
+    };
+    int delayMs = kMinIdleMs;
+    for (int attempt = 0; attempt < kResultAttempts; ++attempt) {
+        int status = node->client.post("/api/worker/result", body, nullptr);
+        if (status == 200) {
+            LOG_INFO(QString("评测任务 %1 完成：%2").arg(result.jobId).arg(result.verdict));
+            return;
+        }
+        if (status == 409) {
+            LOG_WARNING(QString("评测任务 %1 的租约已过期，结果被服务器丢弃").arg(result.jobId));
+            return;
+        }
+        msleep(delayMs);
+        delayMs = qMin(delayMs * 2, kMaxRetryMs);
+    }
+    // 放弃提交，租约过期后服务器会把任务交给其他节点
+    LOG_ERROR(QString("评测任务 %1 的结果无法提交").arg(result.jobId));
+}
+
+JudgeNode::JudgeNode(const NodeClient &client, Judger *judger, int slotCount, QObject *parent)
+    : QThread(parent)
+    , client(client)
+    , judger(judger)
+    , stopping(0)
+    , heartbeatMs(5000)
+{
+    for (int i = 0; i < slotCount; ++i) {
+        slotThreads.append(new NodeSlot(this, i, this));
+    }
+}
+
+JudgeNode::~JudgeNode()
+{
+    stop();
+}
+
+void JudgeNode::stop()
+{
+    stopping.storeRelease(1);
+    for (NodeSlot *slot : slotThreads) {
+        slot->wait();
+    }
+    wait();
+}
+
+void JudgeNode::addLease(qint64 leaseId, qint64 leaseMs)
+{
+    QMutexLocker locker(&leaseMutex);
+    activeLeases.insert(leaseId);
+    if (leaseMs > 0) {
+        heartbeatMs = qMax<qint64>(200, leaseMs / 3);
+    }
+}
+
+void JudgeNode::removeLease(qint64 leaseId)
+{
+    QMutexLocker locker(&leaseMutex);
+    activeLeases.remove(leaseId);
+}
+
+void JudgeNode::run()
+{
+    for (NodeSlot *slot : slotThreads) {
+        slot->start();
+    }
+    LOG_INFO(QString("评测节点 %1 启动：%2 个评测槽").arg(client.workerId()).arg(slotThreads.size()));
+
+    while (!stopping.loadAcquire()) {
+        QJsonArray leases;
+        qint64 interval;
+        {
+            QMutexLocker locker(&leaseMutex);
+            for (qint64 leaseId : activeLeases) {
+                leases.append(QString::number(leaseId));
+            }
+            interval = heartbeatMs;
+        }
+
+        if (!leases.isEmpty()) {
+            QJsonObject reply;
+            int status = client.post("/api/worker/heartbeat", {{"leases", leases}}, &reply,
+                                     int(interval));
+            if (status != 200) {
+                LOG_WARNING(QString("心跳失败（HTTP %1）").arg(status));
+            }
+            for (const QJsonValue &lost : reply["lost"].toArray()) {
+                LOG_WARNING(QString("租约 %1 已被服务器收回").arg(lost.toString()));
+            }
+        }
+        msleep(interval);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef JUDGENODE_H
+#define JUDGENODE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QSet>
+#include <QList>
+#include <QAtomicInt>
+#include "nodeclient.h"
+#include "judger.h"
+
+class JudgeNode;
+
+// 评测槽：循环租用任务、判题、提交结果，每个槽同一时间只评测一份提交
+class NodeSlot : public QThread
+{
+    Q_OBJECT
+public:
+    NodeSlot(JudgeNode *node, int index, QObject *parent = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    void submit(qint64 leaseId, const JudgeResult &result);
+
+    JudgeNode *node;
+    int index;
+};
+
+// 远程评测节点
+// 协议（均为 POST JSON，请求体带 workerId 与 token）：
+//   /api/worker/lease     {max}          -> {leaseMs, jobs: [{leaseId, job}]}
+//   /api/worker/heartbeat {leases: [id]} -> {lost: [id]}
+//   /api/worker/result    {leaseId, result}，租约已过期时返回 409，结果由服务器丢弃
+// 评测期间心跳线程每 leaseMs/3 为所有进行中的租约续约；节点退出或崩溃后
+// 服务器在租约过期时把任务重新排队
+class JudgeNode : public QThread
+{
+    Q_OBJECT
+public:
+    JudgeNode(const NodeClient &client, Judger *judger, int slotCount, QObject *parent = nullptr);
+    ~JudgeNode();
+
+    void stop();
+
+protected:
+    // 心跳循环
+    void run() override;
+
+private:
+    friend class NodeSlot;
+
+    void addLease(qint64 leaseId, qint64 leaseMs);
+    void removeLease(qint64 leaseId);
+
+    NodeClient client;
+    Judger *judger;
+    QList<NodeSlot*> slotThreads;
+    QAtomicInt stopping;
+
+    QMutex leaseMutex;
+    QSet<qint64> activeLeases;
+    qint64 heartbeatMs;
+};
+
+#endif // JUDGENODE_H
@@ -0,0 +1,124 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QProcess>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFile>
+#include <QHostInfo>
+#include <QRegExp>
+#include "judgenode.h"
+#include "compilecache.h"
+#include "checkerpool.h"
+#include "zygotepool.h"
+#include "sandbox.h"
+#include "logger.h"
+#include <signal.h>
+
+namespace {
+
+// 多进程模式：以相同参数启动若干个单进程节点，进程退出后 1 秒重启
+// 用于在一台机器上模拟多台评测机，节点崩溃时验证服务器的租约回收
+void superviseProcesses(int count, const QStringList &childArgs, const QString &baseId)
+{
+    for (int i = 0; i < count; ++i) {
+        QProcess *process = new QProcess(QCoreApplication::instance());
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->setProgram(QCoreApplication::applicationFilePath());
+        process->setArguments(childArgs + QStringList{"--id", QString("%1-%2").arg(baseId).arg(i + 1)});
+        QObject::connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                         process, [process, i](int exitCode, QProcess::ExitStatus status) {
+            LOG_WARNING(QString("评测节点进程 %1 退出（%2，退出码 %3），1 秒后重启")
+                .arg(i + 1)
+                .arg(status == QProcess::CrashExit ? "崩溃" : "正常")
+                .arg(exitCode));
+            QTimer::singleShot(1000, process, [process] { process->start(); });
+        });
+        process->start();
+    }
+    LOG_INFO(QString("已启动 %1 个评测节点进程").arg(count));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在线评测远程评测节点");
+    parser.addHelpOption();
+    parser.addOption({"server", "服务器地址 host:port", "address", "127.0.0.1:8080"});
+    parser.addOption({"token", "节点令牌，默认取环境变量 OJ_WORKER_TOKEN", "token"});
+    parser.addOption({"id", "节点ID，默认为主机名与进程号", "id"});
+    parser.addOption({"slots", "同时评测的提交数，默认为 CPU 核数", "count", "0"});
+    parser.addOption({"processes", "以多进程模式启动的节点数", "count", "1"});
+    parser.process(a);
+
+    QString id = parser.isSet("id") ? parser.value("id")
+                                    : QString("%1-%2").arg(QHostInfo::localHostName()).arg(a.applicationPid());
+    // 同机多进程各写各的日志文件，互不交错，也不会同时轮转同一个文件；须在第一条日志之前设置
+    Logger::getInstance()->setLogDirectory("logs", QString("worker_%1").arg(id));
+    Logger::getInstance()->setLogLevel(Logger::Info);
+    Logger::getInstance()->startAsync();
+
+    QString token = parser.isSet("token") ? parser.value("token")
+                                          : QString::fromUtf8(qgetenv("OJ_WORKER_TOKEN"));
+    if (token.isEmpty()) {
+        LOG_FATAL("未指定节点令牌");
+        return 1;
+    }
+
+    int processes = parser.value("processes").toInt();
+    if (processes > 1) {
+        // 令牌经环境变量传给子进程，不出现在命令行中
+        qputenv("OJ_WORKER_TOKEN", token.toUtf8());
+        QStringList childArgs{"--server", parser.value("server"), "--slots", parser.value("slots")};
+        superviseProcesses(processes, childArgs, id);
+        return a.exec();
+    }
+
+    QString address = parser.value("server");
+    address.remove(QRegExp("^https?://"));
+    QString host = address.section(':', 0, 0);
+    int port = address.contains(':') ? address.section(':', 1, 1).section('/', 0, 0).toInt() : 8080;
+    if (host.isEmpty() || port <= 0 || port > 65535) {
+        LOG_FATAL(QString("服务器地址无效：%1").arg(parser.value("server")));
+        return 1;
+    }
+
+    // 与服务器相同的进程环境
+    signal(SIGPIPE, SIG_IGN);
+    QString cgroupRoot = "/sys/fs/cgroup/onlinejudge";
+    if (QFile::exists(cgroupRoot)) {
+        Sandbox::setCgroupRoot(cgroupRoot);
+    }
+
+    int slotCount = parser.value("slots").toInt();
+    if (slotCount <= 0) {
+        slotCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    // 缓存目录按节点区分，同机多进程互不干扰
+    CompileCache compileCache(QString("worker_cache/%1").arg(id), 512LL << 20);
+    CheckerPool checkerPool(QString("worker_checkers/%1").arg(id));
+    ZygotePool zygotePool(slotCount);
+    QThreadPool casePool;
+    casePool.setMaxThreadCount(slotCount);
+
+    Judger judger;
+    judger.setCompileCache(&compileCache);
+    judger.setCheckerPool(&checkerPool);
+    judger.setZygotePool(&zygotePool);
+    judger.setCasePool(&casePool);
+
+    zygotePool.start();
+    JudgeNode node(NodeClient(host, quint16(port), token, id), &judger, slotCount);
+    node.start();
+
+    int ret = a.exec();
+    node.stop();
+    zygotePool.stop();
+    casePool.waitForDone();
+    Logger::getInstance()->stopAsync();
+    return ret;
+}
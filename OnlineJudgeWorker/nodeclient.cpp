@@ -0,0 +1,76 @@
+#include "nodeclient.h"
+#include <QTcpSocket>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+
+NodeClient::NodeClient(const QString &host, quint16 port, const QString &token, const QString &workerId)
+    : host(host)
+    , port(port)
+    , token(token)
+    , id(workerId)
+{
+}
+
+int NodeClient::post(const QString &path, QJsonObject body, QJsonObject *reply, int timeoutMs) const
+{
+    body["workerId"] = id;
+    body["token"] = token;
+    QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+
+    QElapsedTimer timer;
+    timer.start();
+    QTcpSocket socket;
+    socket.connectToHost(host, port);
+    if (!socket.waitForConnected(timeoutMs)) {
+        return -1;
+    }
+
+    QByteArray request = "POST " + path.toUtf8() + " HTTP/1.1\r\n"
+                         "Host: " + host.toUtf8() + "\r\n"
+                         "Content-Type: application/json\r\n"
+                         "Content-Length: " + QByteArray::number(payload.size()) + "\r\n"
+                         "Connection: close\r\n"
+                         "\r\n" + payload;
+    socket.write(request);
+
+    // 读到完整的响应头与 Content-Length 指定的响应体为止
+    QByteArray response;
+    int headerEnd = -1;
+    qint64 contentLength = -1;
+    while (true) {
+        if (headerEnd < 0) {
+            headerEnd = response.indexOf("\r\n\r\n");
+            if (headerEnd >= 0) {
+                for (const QByteArray &line : response.left(headerEnd).split('\n')) {
+                    if (line.toLower().startsWith("content-length:")) {
+                        contentLength = line.mid(15).trimmed().toLongLong();
+                    }
+                }
+            }
+        }
+        if (headerEnd >= 0 && contentLength >= 0 && response.size() - headerEnd - 4 >= contentLength) {
+            break;
+        }
+        int remaining = timeoutMs - int(timer.elapsed());
+        if (remaining <= 0 || !socket.waitForReadyRead(remaining)) {
+            response.append(socket.readAll());
+            if (headerEnd < 0) {
+                headerEnd = response.indexOf("\r\n\r\n");
+            }
+            if (socket.state() != QAbstractSocket::UnconnectedState || headerEnd < 0) {
+                return -1;
+            }
+            break;  // 服务器关闭连接，按已收到的内容处理
+        }
+        response.append(socket.readAll());
+    }
+    socket.disconnectFromHost();
+
+    // "HTTP/1.1 200 OK"
+    int status = response.left(response.indexOf("\r\n")).split(' ').value(1).toInt();
+    QJsonDocument doc = QJsonDocument::fromJson(response.mid(headerEnd + 4, int(contentLength)));
+    if (reply) {
+        *reply = doc.object();
+    }
+    return status > 0 ? status : -1;
+}
@@ -0,0 +1,27 @@
+#ifndef NODECLIENT_H
+#define NODECLIENT_H
+
+#include <QString>
+#include <QJsonObject>
+
+// 评测节点访问服务器的阻塞式 HTTP 客户端
+// 每次请求新建连接，只用 waitFor* 等待，可在没有事件循环的线程中调用
+class NodeClient
+{
+public:
+    NodeClient(const QString &host, quint16 port, const QString &token, const QString &workerId);
+
+    // 发送 POST 请求，请求体自动附带节点ID与令牌
+    // 返回 HTTP 状态码，网络错误返回 -1
+    int post(const QString &path, QJsonObject body, QJsonObject *reply, int timeoutMs = 10000) const;
+
+    QString workerId() const { return id; }
+
+private:
+    QString host;
+    quint16 port;
+    QString token;
+    QString id;
+};
+
+#endif // NODECLIENT_H